@@ -0,0 +1,113 @@
+package verushash
+
+import (
+	"github.com/asherda/go-verushash/verushash"
+	"runtime"
+	"sync"
+)
+
+// Each thread that hashes VerusHash 2b keeps its own CLHash key, and a goroutine calling cgo can
+// run on any of the process's threads, so hashing from many goroutines builds keys on many
+// threads, and more again as threads come and go. A Hasher instead hashes on a fixed set of
+// goroutines, each locked to its thread with runtime.LockOSThread, so the keys stay on those
+// threads and warm. Requests that queue up while a worker hashes are taken together as one
+// batch, one cgo call for all of them.
+
+// Hasher is a pool of worker goroutines, each locked to its own OS thread, that hash VerusHash
+// 2b2 headers sent to it by any number of goroutines
+type Hasher struct {
+	requests chan *hashRequest
+	maxBatch int
+	workers  sync.WaitGroup
+}
+
+type hashRequest struct {
+	header []byte
+	hash   [32]byte
+	ok     bool
+	done   chan struct{}
+}
+
+var requestPool = sync.Pool{New: func() interface{} { return &hashRequest{done: make(chan struct{}, 1)} }}
+
+// NewHasher starts workers worker goroutines, GOMAXPROCS for 0 or less, each hashing up to
+// maxBatch queued headers in one call, 64 for 0 or less
+func NewHasher(workers, maxBatch int) *Hasher {
+	if workers <= 0 {
+		workers = runtime.GOMAXPROCS(0)
+	}
+	if maxBatch <= 0 {
+		maxBatch = 64
+	}
+	h := &Hasher{requests: make(chan *hashRequest, workers*maxBatch), maxBatch: maxBatch}
+	h.workers.Add(workers)
+	for i := 0; i < workers; i++ {
+		go h.work()
+	}
+	return h
+}
+
+// HashV2B2 returns the hash of the serialized block header, as VerusHashSum_V2B2 does, and
+// false with a zero hash for a header that does not parse. header must not change until it
+// returns
+func (h *Hasher) HashV2B2(header []byte) ([32]byte, bool) {
+	r := requestPool.Get().(*hashRequest)
+	r.header = header
+	h.requests <- r
+	<-r.done
+	hash, ok := r.hash, r.ok
+	r.header = nil
+	requestPool.Put(r)
+	return hash, ok
+}
+
+// Close stops the workers once the requests sent so far are hashed. The Hasher must not be used
+// after it
+func (h *Hasher) Close() {
+	close(h.requests)
+	h.workers.Wait()
+}
+
+func (h *Hasher) work() {
+	runtime.LockOSThread()
+	defer h.workers.Done()
+
+	batch := make([]*hashRequest, 0, h.maxBatch)
+	offsets := make([]int, 0, h.maxBatch)
+	out := make([][32]byte, h.maxBatch)
+	status := make([]int32, h.maxBatch)
+	var packed []byte
+	for r := range h.requests {
+		batch = append(batch[:0], r)
+	fill:
+		for len(batch) < h.maxBatch {
+			select {
+			case next, ok := <-h.requests:
+				if !ok {
+					break fill
+				}
+				batch = append(batch, next)
+			default:
+				break fill
+			}
+		}
+
+		if len(batch) == 1 {
+			r.hash, r.ok = VH.HashV2B2(r.header)
+		} else {
+			// one thread, this one, whose key the batch keeps warm
+			packed, offsets = packed[:0], offsets[:0]
+			for _, r := range batch {
+				offsets = append(offsets, len(packed))
+				packed = append(packed, r.header...)
+			}
+			failed := VH.Batch(VH.VersionV2B2, packed, offsets, out, status, 1)
+			for i, r := range batch {
+				r.hash, r.ok = out[i], failed >= 0 && status[i] == 0
+			}
+		}
+		for _, r := range batch {
+			r.done <- struct{}{}
+		}
+	}
+}
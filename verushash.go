@@ -2,39 +2,177 @@ package verushash
 
 import (
 	"github.com/asherda/go-verushash/verushash"
-	"unsafe"
+	"io"
+	"runtime"
+	"sync"
+	"time"
 )
 
-// Initialize verushash object once.
-var verusHash = VH.NewVerushash()
+// The Sum functions return the hash by value and allocate nothing, the others return it in a new
+// slice. The header is passed to the library as it is, without a copy.
 
 func VerusHash(serializedHeader []byte) []byte {
-	hash := make([]byte, 32)
-	ptrHash := uintptr(unsafe.Pointer(&hash[0]))
-	length := len(serializedHeader)
-	verusHash.Verushash(string(serializedHeader), length, ptrHash)
-	return hash
+	hash := VH.HashV1(serializedHeader)
+	return hash[:]
 }
 
 func VerusHash_V2B(serializedHeader []byte) []byte {
-	hash := make([]byte, 32)
-	ptrHash := uintptr(unsafe.Pointer(&hash[0]))
-	length := len(serializedHeader)
-	verusHash.Verushash_v2b(string(serializedHeader), length, ptrHash)
-	return hash
+	hash := VH.HashV2B(serializedHeader)
+	return hash[:]
 }
 
 func VerusHash_V2B1(serializedHeader []byte) []byte {
-	hash := make([]byte, 32)
-	ptrHash := uintptr(unsafe.Pointer(&hash[0]))
-	length := len(serializedHeader)
-	verusHash.Verushash_v2b1(string(serializedHeader), length, ptrHash)
-	return hash
+	hash := VH.HashV2B1(serializedHeader)
+	return hash[:]
 }
 
+// VerusHash_V2B2 returns zeros for a header that does not parse
 func VerusHash_V2B2(serializedHeader []byte) []byte {
-	hash := make([]byte, 32)
-	ptrHash := uintptr(unsafe.Pointer(&hash[0]))
-	verusHash.Verushash_v2b2(string(serializedHeader), ptrHash)
-	return hash
+	hash, _ := VH.HashV2B2(serializedHeader)
+	return hash[:]
+}
+
+func VerusHashSum(serializedHeader []byte) [32]byte {
+	return VH.HashV1(serializedHeader)
+}
+
+func VerusHashSum_V2B(serializedHeader []byte) [32]byte {
+	return VH.HashV2B(serializedHeader)
+}
+
+func VerusHashSum_V2B1(serializedHeader []byte) [32]byte {
+	return VH.HashV2B1(serializedHeader)
+}
+
+// VerusHashSum_V2B2 returns false with a zero hash for a header that does not parse
+func VerusHashSum_V2B2(serializedHeader []byte) ([32]byte, bool) {
+	return VH.HashV2B2(serializedHeader)
+}
+
+// VerusHashV2B2Batch hashes headers into out in one call into the library, spread over up to
+// GOMAXPROCS threads that keep their keys from one batch to the next. It returns how many headers
+// did not parse, whose hashes are zero. The headers are copied into one buffer first, which
+// VerusHashV2B2Packed avoids. out must be at least as long as headers
+func VerusHashV2B2Batch(headers [][]byte, out [][32]byte) int {
+	b := packedPool.Get().(*packedHeaders)
+	b.data, b.offsets = b.data[:0], b.offsets[:0]
+	for _, header := range headers {
+		b.offsets = append(b.offsets, len(b.data))
+		b.data = append(b.data, header...)
+	}
+	failed := VerusHashV2B2Packed(b.data, b.offsets, out)
+	packedPool.Put(b)
+	return failed
+}
+
+// VerusHashV2B2Packed is VerusHashV2B2Batch for headers packed in one buffer, header i starting
+// at offsets[i] and ending at offsets[i+1], the last one at the end of packed. It panics if the
+// offsets are out of order or past the end of packed
+func VerusHashV2B2Packed(packed []byte, offsets []int, out [][32]byte) int {
+	failed := VH.Batch(VH.VersionV2B2, packed, offsets, out, nil, runtime.GOMAXPROCS(0))
+	if failed < 0 {
+		panic("verushash: offsets out of order or past the end of the packed headers")
+	}
+	return failed
+}
+
+// the buffers VerusHashV2B2Batch packs headers into, kept for the next batch
+type packedHeaders struct {
+	data    []byte
+	offsets []int
+}
+
+var packedPool = sync.Pool{New: func() interface{} { return new(packedHeaders) }}
+
+// Counters are what the library has done since the process started, over all threads
+type Counters struct {
+	HashesV1, HashesV2, HashesV2B, HashesV2B1, HashesV2B2 uint64
+	Bytes                                                 uint64 // input bytes absorbed by all versions
+	KeyGenerations                                        uint64 // CLHash keys generated for a new seed
+	KeyRestores                                           uint64 // CLHash keys restored for the same seed
+	KeyAllocations, KeyFrees                              uint64 // thread local key buffers, these climb with thread churn
+	ParseFailures                                         uint64 // headers VerusHash_V2B2 could not deserialize
+	KeyReleases                                           uint64 // keys of idle threads freed by ReleaseIdleKeys
+	Kernels                                               string // the selected hash kernels
+}
+
+// ReadCounters returns the library's runtime counters
+func ReadCounters() Counters {
+	v := VH.ReadCounters()
+	return Counters{
+		HashesV1:       v[VH.CounterHashesV1],
+		HashesV2:       v[VH.CounterHashesV2],
+		HashesV2B:      v[VH.CounterHashesV2B],
+		HashesV2B1:     v[VH.CounterHashesV2B1],
+		HashesV2B2:     v[VH.CounterHashesV2B2],
+		Bytes:          v[VH.CounterBytes],
+		KeyGenerations: v[VH.CounterKeyGenerations],
+		KeyRestores:    v[VH.CounterKeyRestores],
+		KeyAllocations: v[VH.CounterKeyAllocations],
+		KeyFrees:       v[VH.CounterKeyFrees],
+		ParseFailures:  v[VH.CounterParseFailures],
+		KeyReleases:    v[VH.CounterKeyReleases],
+		Kernels:        VH.SelectedKernels(),
+	}
+}
+
+// MemoryUse is what the library holds of one kind of buffer. The rate of Allocations is the
+// allocations per second
+type MemoryUse struct {
+	Live        uint64 // buffers held now, for keys the threads with a hashing context
+	Bytes       uint64 // bytes held now
+	PeakBytes   uint64 // the most bytes held at once
+	Allocations uint64
+	Frees       uint64
+}
+
+// ReadMemory returns what the library holds by kind: "keys", the ~17 KB CLHash key each hashing
+// thread keeps, "key_descriptors", "read_buffers" of file hashing and "thread_counters"
+func ReadMemory() map[string]MemoryUse {
+	v := VH.ReadMemory()
+	use := make(map[string]MemoryUse)
+	for kind := 0; kind < VH.MemoryKinds; kind++ {
+		f := v[kind*VH.MemoryFields:]
+		use[VH.MemoryKindName(kind)] = MemoryUse{
+			Live:        f[VH.MemoryLive],
+			Bytes:       f[VH.MemoryBytes],
+			PeakBytes:   f[VH.MemoryPeakBytes],
+			Allocations: f[VH.MemoryAllocations],
+			Frees:       f[VH.MemoryFrees],
+		}
+	}
+	return use
+}
+
+// ReleaseIdleKeys frees the keys of threads that have not hashed for idle, returning how many.
+// A thread hashing again allocates and generates its key again, so idle should be well above
+// the gap between hashes on a busy thread
+func ReleaseIdleKeys(idle time.Duration) int {
+	return VH.ReleaseIdleKeys(uint64(idle / time.Millisecond))
+}
+
+// ReleaseIdleKeysEvery runs ReleaseIdleKeys(idle) every idle until stop is called, so no thread
+// keeps a key for much more than twice idle after its last hash
+func ReleaseIdleKeysEvery(idle time.Duration) (stop func()) {
+	ticker := time.NewTicker(idle)
+	done := make(chan struct{})
+	go func() {
+		for {
+			select {
+			case <-ticker.C:
+				ReleaseIdleKeys(idle)
+			case <-done:
+				ticker.Stop()
+				return
+			}
+		}
+	}()
+	return func() { close(done) }
+}
+
+// WritePrometheus writes the per API and version latency histograms and the runtime counters
+// in Prometheus text exposition format, for serving on an existing metrics endpoint
+func WritePrometheus(w io.Writer) error {
+	_, err := io.WriteString(w, VH.PrometheusText())
+	return err
 }
@@ -0,0 +1,165 @@
+// (C) 2018 The Verus Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+/*
+Run statistics and baselines for verushash_bench. Every result is measured in several runs, and
+its median and a 95% bootstrap confidence interval of the median are what a later build is
+compared with. A result regresses when its median is slower than the baseline's by more than
+the threshold and the two intervals don't overlap, so run to run noise doesn't fail a
+comparison and a real slowdown of a few percent does.
+
+A baseline is simply the JSON of an earlier verushash_bench --out, which ReadBenchBaseline reads
+back. It only understands that output, one result object per line.
+*/
+#ifndef VERUSHASH_BENCH_BASELINE_H_
+#define VERUSHASH_BENCH_BASELINE_H_
+
+#include <errno.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <map>
+#include <string>
+#include <vector>
+
+static double BenchMedian(std::vector<double> values)
+{
+    if (values.empty())
+    {
+        return 0;
+    }
+    std::sort(values.begin(), values.end());
+    size_t n = values.size();
+    return n & 1 ? values[n / 2] : (values[n / 2 - 1] + values[n / 2]) / 2;
+}
+
+// the 2.5th and 97.5th percentiles of the medians of 1000 resamples of values
+static void BenchMedianInterval(const std::vector<double> &values, double &low, double &high)
+{
+    low = high = BenchMedian(values);
+    if (values.size() < 2)
+    {
+        return;
+    }
+
+    // a fixed seed, so the same runs always give the same interval
+    uint64_t state = 0x9E3779B97F4A7C15ULL;
+    std::vector<double> medians, resample(values.size());
+    for (int i = 0; i < 1000; i++)
+    {
+        for (double &v : resample)
+        {
+            state ^= state << 13;
+            state ^= state >> 7;
+            state ^= state << 17;
+            v = values[state % values.size()];
+        }
+        medians.push_back(BenchMedian(resample));
+    }
+    std::sort(medians.begin(), medians.end());
+    low = medians[25];
+    high = medians[974];
+}
+
+struct CBenchBaselineEntry
+{
+    double median;          // ns per hash
+    double ciLow, ciHigh;
+};
+
+struct CBenchBaseline
+{
+    std::string cpuModel;
+    std::string kernels;
+    std::map<std::string, CBenchBaselineEntry> results;
+};
+
+// what identifies a result across runs
+static std::string BenchResultKey(const std::string &group, const std::string &name, const std::string &kernel,
+                                  size_t bytes, int width, int threads)
+{
+    return group + " " + name + " " + kernel + " " + std::to_string(bytes) + "x" + std::to_string(width) +
+           " t" + std::to_string(threads);
+}
+
+// the string after "key": on line, as json_string in verushash_bench writes it
+static bool BenchJsonString(const std::string &line, const char *key, std::string &value)
+{
+    size_t pos = line.find(std::string("\"") + key + "\": \"");
+    if (pos == std::string::npos)
+    {
+        return false;
+    }
+    value.clear();
+    for (pos += strlen(key) + 5; pos < line.size() && line[pos] != '"'; pos++)
+    {
+        if (line[pos] == '\\' && pos + 1 < line.size())
+        {
+            pos++;
+        }
+        value += line[pos];
+    }
+    return true;
+}
+
+static bool BenchJsonNumber(const std::string &line, const char *key, double &value)
+{
+    size_t pos = line.find(std::string("\"") + key + "\": ");
+    if (pos == std::string::npos)
+    {
+        return false;
+    }
+    value = strtod(line.c_str() + pos + strlen(key) + 4, NULL);
+    return true;
+}
+
+// reads the results of a verushash_bench JSON file, returning an empty string or the error
+static std::string ReadBenchBaseline(const std::string &path, CBenchBaseline &baseline)
+{
+    FILE *f = fopen(path.c_str(), "r");
+    if (!f)
+    {
+        return path + ": " + strerror(errno);
+    }
+
+    std::string line;
+    char buf[4096];
+    while (fgets(buf, sizeof(buf), f))
+    {
+        line += buf;
+        if (line.empty() || line.back() != '\n')
+        {
+            continue;
+        }
+
+        std::string group, name, kernel;
+        double bytes, width, threads, median, ciLow, ciHigh;
+        if (line.find("\"cpu_model\": ") != std::string::npos)
+        {
+            BenchJsonString(line, "cpu_model", baseline.cpuModel);
+        }
+        else if (line.find("\"kernels\": ") != std::string::npos && line.find("\"group\": ") == std::string::npos)
+        {
+            BenchJsonString(line, "kernels", baseline.kernels);
+        }
+        else if (BenchJsonString(line, "group", group) && BenchJsonString(line, "name", name) &&
+                 BenchJsonString(line, "kernel", kernel) && BenchJsonNumber(line, "bytes", bytes) &&
+                 BenchJsonNumber(line, "width", width) && BenchJsonNumber(line, "threads", threads) &&
+                 BenchJsonNumber(line, "median_ns", median) && BenchJsonNumber(line, "ci_low_ns", ciLow) &&
+                 BenchJsonNumber(line, "ci_high_ns", ciHigh))
+        {
+            CBenchBaselineEntry &e = baseline.results[BenchResultKey(group, name, kernel, bytes, width, threads)];
+            e.median = median;
+            e.ciLow = ciLow;
+            e.ciHigh = ciHigh;
+        }
+        line.clear();
+    }
+    fclose(f);
+    return baseline.results.empty() ? path + ": no results with run statistics" : "";
+}
+
+#endif
@@ -0,0 +1,177 @@
+// (C) 2018 The Verus Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+/*
+A deterministic corpus of serialized block headers for the benchmarks and the PGO
+training run. The mix follows what a wallet or explorer backend actually hashes: mostly
+VERUS_V2 headers for VerusHash 2.2, with and without PBaaS headers in the solution, some
+of them for this chain so that the canonical data check and clear path runs, and a tail
+of older V1, V2, V2b and V2b1 headers.
+
+Every input is a full serialized CBlockHeader, 1487 bytes with a 1344 byte solution.
+*/
+#ifndef VERUSHASH_BENCH_CORPUS_H_
+#define VERUSHASH_BENCH_CORPUS_H_
+
+#include <stdint.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+#include "solutiondata.h"
+#include "verushash.h"
+
+extern uint160 ASSETCHAINS_CHAINID;
+
+enum BenchHashKind {
+    BENCH_HASH_V1 = 0,          // Verushash::verushash
+    BENCH_HASH_V2 = 1,          // Verushash::verushash_v2
+    BENCH_HASH_V2B = 2,         // Verushash::verushash_v2b
+    BENCH_HASH_V2B1 = 3,        // Verushash::verushash_v2b1
+    BENCH_HASH_V2B2 = 4,        // Verushash::verushash_v2b2, no PBaaS headers
+    BENCH_HASH_V2B2_PBAAS = 5,  // Verushash::verushash_v2b2, with PBaaS headers
+    BENCH_HASH_KINDS = 6
+};
+
+static const char *BenchHashKindName(int kind)
+{
+    static const char *names[BENCH_HASH_KINDS] = {"v1", "v2", "v2b", "v2b1", "v2b2", "v2b2_pbaas"};
+    return (kind >= 0 && kind < BENCH_HASH_KINDS) ? names[kind] : "unknown";
+}
+
+struct CBenchHeader
+{
+    int kind;
+    std::string bytes;
+};
+
+// header through the C API entry point of its kind, as the Go binding hashes it. The C API needs
+// no Verushash, vh is only the one each caller keeps per thread
+static void BenchHashHeader(Verushash &vh, const CBenchHeader &header, unsigned char *out)
+{
+    const uint8_t *data = (const uint8_t *)header.bytes.data();
+    switch (header.kind)
+    {
+        case BENCH_HASH_V1:
+            verushash_v1(data, header.bytes.size(), out);
+            break;
+        case BENCH_HASH_V2:
+            verushash_v2(data, header.bytes.size(), out);
+            break;
+        case BENCH_HASH_V2B:
+            verushash_v2b(data, header.bytes.size(), out);
+            break;
+        case BENCH_HASH_V2B1:
+            verushash_v2b1(data, header.bytes.size(), out);
+            break;
+        default:
+            verushash_v2b2(data, header.bytes.size(), out);
+            break;
+    }
+}
+
+// splitmix64, the corpus must be the same on every run and every platform
+class CBenchRandom
+{
+    public:
+        uint64_t state;
+
+        CBenchRandom(uint64_t seed) : state(seed) {}
+
+        uint64_t Next()
+        {
+            uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+            return z ^ (z >> 31);
+        }
+
+        void Fill(unsigned char *p, size_t len)
+        {
+            for (size_t i = 0; i < len; i++)
+            {
+                p[i] = (unsigned char)Next();
+            }
+        }
+};
+
+// one header of the given kind
+static CBenchHeader MakeBenchHeader(CBenchRandom &rnd, int kind)
+{
+    CBlockHeader bh;
+
+    bh.nVersion = kind < BENCH_HASH_V2B2 ? CBlockHeader::CURRENT_VERSION : CBlockHeader::VERUS_V2;
+    rnd.Fill(bh.hashPrevBlock.begin(), bh.hashPrevBlock.size());
+    rnd.Fill(bh.hashMerkleRoot.begin(), bh.hashMerkleRoot.size());
+    rnd.Fill(bh.hashFinalSaplingRoot.begin(), bh.hashFinalSaplingRoot.size());
+    bh.nTime = (uint32_t)rnd.Next();
+    bh.nBits = (uint32_t)rnd.Next();
+    rnd.Fill(bh.nNonce.begin(), bh.nNonce.size());
+    bh.nSolution.resize(1344);
+    rnd.Fill(bh.nSolution.data(), bh.nSolution.size());
+
+    CPBaaSSolutionDescriptor descr(bh.nSolution);
+    descr.extraDataSize = 0;
+    if (kind == BENCH_HASH_V2B2_PBAAS)
+    {
+        uint64_t r = rnd.Next();
+        descr.version = (r & 1) ? CActivationHeight::SOLUTION_VERUSV6 : CActivationHeight::SOLUTION_VERUSV5_1;
+        descr.descrBits = (r & 2) ? SOLUTION_POW : 0;
+        descr.numPBaaSHeaders = 1 + ((r >> 2) & 1);
+        CConstVerusSolutionVector::SetDescriptor(bh.nSolution, descr);
+
+        // three out of four carry a valid header for this chain, which is cleared before hashing
+        if ((r >> 3) & 3)
+        {
+            CPBaaSPreHeader preHeader(bh);
+            CPBaaSBlockHeader pbh(ASSETCHAINS_CHAINID, preHeader);
+            size_t idx = ((r >> 5) & 1) % descr.numPBaaSHeaders;
+            memcpy(&bh.nSolution[sizeof(CPBaaSSolutionDescriptor) + idx * sizeof(CPBaaSBlockHeader)], &pbh, sizeof(pbh));
+        }
+    }
+    else
+    {
+        descr.version = kind == BENCH_HASH_V2B2 ?
+                            (rnd.Next() & 1 ? CActivationHeight::SOLUTION_VERUSV5 : CActivationHeight::SOLUTION_VERUSV4) :
+                            CActivationHeight::SOLUTION_VERUSV3;
+        descr.descrBits = 0;
+        descr.numPBaaSHeaders = 0;
+        CConstVerusSolutionVector::SetDescriptor(bh.nSolution, descr);
+    }
+
+    CDataStream s(SER_NETWORK, 0);
+    s << bh;
+
+    CBenchHeader header;
+    header.kind = kind;
+    header.bytes.assign(s.begin(), s.end());
+    return header;
+}
+
+// count headers in the standard mix, shuffled so branches see realistic interleaving
+static std::vector<CBenchHeader> MakeBenchCorpus(size_t count, uint64_t seed = 0x5645525553ULL)
+{
+    // out of every 20: 2 V1, 1 V2, 1 V2b, 2 V2b1, 7 V2b2, 7 V2b2 with PBaaS headers
+    static const int mix[20] = {
+        BENCH_HASH_V1, BENCH_HASH_V1, BENCH_HASH_V2, BENCH_HASH_V2B, BENCH_HASH_V2B1, BENCH_HASH_V2B1,
+        BENCH_HASH_V2B2, BENCH_HASH_V2B2, BENCH_HASH_V2B2, BENCH_HASH_V2B2, BENCH_HASH_V2B2, BENCH_HASH_V2B2, BENCH_HASH_V2B2,
+        BENCH_HASH_V2B2_PBAAS, BENCH_HASH_V2B2_PBAAS, BENCH_HASH_V2B2_PBAAS, BENCH_HASH_V2B2_PBAAS,
+        BENCH_HASH_V2B2_PBAAS, BENCH_HASH_V2B2_PBAAS, BENCH_HASH_V2B2_PBAAS
+    };
+    CBenchRandom rnd(seed);
+    std::vector<CBenchHeader> corpus;
+
+    corpus.reserve(count);
+    for (size_t i = 0; i < count; i++)
+    {
+        corpus.push_back(MakeBenchHeader(rnd, mix[i % 20]));
+    }
+    for (size_t i = count; i > 1; i--)
+    {
+        std::swap(corpus[i - 1], corpus[rnd.Next() % i]);
+    }
+    return corpus;
+}
+
+#endif
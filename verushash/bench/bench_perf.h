@@ -0,0 +1,211 @@
+// (C) 2018 The Verus Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+/*
+Hardware performance counters for the benchmarks, through one perf_event_open group on the
+calling thread, so every event counts exactly the same region. Events are named:
+
+    cycles, instructions, branch-misses, l1d-misses, llc-misses
+    uops-port0, uops-port1, uops-port5      Intel only, UOPS_DISPATCHED.PORT_n, where the AES
+                                            and carry-less multiply uops run
+    task-clock, page-faults                 software events, available even in most VMs
+    raw:0x<config>                          any raw event of this CPU, see its PMU manual
+
+Events that can't be opened, for lack of permission (kernel.perf_event_paranoid), hardware
+support or on other platforms, are left out and the reason kept in Error(), so the benchmarks
+run the same without them. Counts are scaled for the time the group was multiplexed out.
+*/
+#ifndef VERUSHASH_BENCH_PERF_H_
+#define VERUSHASH_BENCH_PERF_H_
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+#ifdef __linux__
+#include <errno.h>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#endif
+
+class CBenchPerf
+{
+    public:
+        // the default events, and those of them this CPU has names for
+        static std::vector<std::string> DefaultEvents()
+        {
+            std::vector<std::string> events = {"cycles", "instructions", "l1d-misses", "branch-misses"};
+            if (IsIntel())
+            {
+                events.push_back("uops-port0");
+                events.push_back("uops-port1");
+                events.push_back("uops-port5");
+            }
+            return events;
+        }
+
+        CBenchPerf() {}
+        ~CBenchPerf() { Close(); }
+
+        // opens what it can of events, returning true if any opened
+        bool Open(const std::vector<std::string> &events)
+        {
+            Close();
+            for (const std::string &name : events)
+            {
+                std::string why = OpenEvent(name);
+                if (!why.empty())
+                {
+                    error += (error.empty() ? "" : "; ") + name + ": " + why;
+                }
+            }
+            return !fds.empty();
+        }
+
+        bool Available() const { return !fds.empty(); }
+        const std::vector<std::string> &Names() const { return names; }
+        const std::string &Error() const { return error; }
+
+        void Start()
+        {
+#ifdef __linux__
+            if (Available())
+            {
+                ioctl(fds[0], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+                ioctl(fds[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+            }
+#endif
+        }
+
+        // the count of each of Names() since Start
+        std::vector<double> Stop()
+        {
+            std::vector<double> values(fds.size(), 0);
+#ifdef __linux__
+            if (Available())
+            {
+                ioctl(fds[0], PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+
+                // nr, time enabled, time running, then a value for each event
+                std::vector<uint64_t> buf(3 + fds.size());
+                if (read(fds[0], buf.data(), buf.size() * sizeof(uint64_t)) == (ssize_t)(buf.size() * sizeof(uint64_t)))
+                {
+                    double scale = buf[2] ? (double)buf[1] / buf[2] : 0;
+                    for (size_t i = 0; i < fds.size() && i < buf[0]; i++)
+                    {
+                        values[i] = buf[3 + i] * scale;
+                    }
+                }
+            }
+#endif
+            return values;
+        }
+
+    private:
+        std::vector<int> fds;           // fds[0] is the group leader
+        std::vector<std::string> names;
+        std::string error;
+
+        static bool IsIntel()
+        {
+#if defined(__x86_64__) || defined(__i386__)
+            unsigned int eax, ebx, ecx, edx;
+            return __get_cpuid(0, &eax, &ebx, &ecx, &edx) && ebx == 0x756e6547 && edx == 0x49656e69 && ecx == 0x6c65746e;
+#else
+            return false;
+#endif
+        }
+
+        std::string OpenEvent(const std::string &name)
+        {
+#ifdef __linux__
+            struct perf_event_attr attr;
+            memset(&attr, 0, sizeof(attr));
+            attr.size = sizeof(attr);
+            attr.type = PERF_TYPE_HARDWARE;
+
+            if (name == "cycles")
+                attr.config = PERF_COUNT_HW_CPU_CYCLES;
+            else if (name == "instructions")
+                attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+            else if (name == "branch-misses")
+                attr.config = PERF_COUNT_HW_BRANCH_MISSES;
+            else if (name == "llc-misses")
+                attr.config = PERF_COUNT_HW_CACHE_MISSES;
+            else if (name == "l1d-misses")
+            {
+                attr.type = PERF_TYPE_HW_CACHE;
+                attr.config = PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+            }
+            else if (name == "uops-port0" || name == "uops-port1" || name == "uops-port5")
+            {
+                if (!IsIntel())
+                {
+                    return "only named for Intel CPUs, use raw:";
+                }
+                // UOPS_DISPATCHED.PORT_0, _1 and _5, event 0xa1 with the port's umask bit
+                attr.type = PERF_TYPE_RAW;
+                attr.config = 0xa1 | ((name == "uops-port0" ? 0x01 : name == "uops-port1" ? 0x02 : 0x20) << 8);
+            }
+            else if (name == "task-clock" || name == "page-faults")
+            {
+                attr.type = PERF_TYPE_SOFTWARE;
+                attr.config = name == "task-clock" ? PERF_COUNT_SW_TASK_CLOCK : PERF_COUNT_SW_PAGE_FAULTS;
+            }
+            else if (name.compare(0, 4, "raw:") == 0)
+            {
+                char *end;
+                attr.type = PERF_TYPE_RAW;
+                attr.config = strtoull(name.c_str() + 4, &end, 0);
+                if (*end || end == name.c_str() + 4)
+                {
+                    return "bad raw event";
+                }
+            }
+            else
+            {
+                return "unknown event";
+            }
+
+            attr.disabled = fds.empty();
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+            int fd = syscall(SYS_perf_event_open, &attr, 0, -1, fds.empty() ? -1 : fds[0], 0);
+            if (fd < 0)
+            {
+                return strerror(errno);
+            }
+            fds.push_back(fd);
+            names.push_back(name);
+            return "";
+#else
+            return "perf_event_open is only on Linux";
+#endif
+        }
+
+        void Close()
+        {
+#ifdef __linux__
+            for (size_t i = fds.size(); i-- > 0; )
+            {
+                close(fds[i]);
+            }
+#endif
+            fds.clear();
+            names.clear();
+            error.clear();
+        }
+};
+
+#endif
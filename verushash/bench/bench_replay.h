@@ -0,0 +1,143 @@
+// (C) 2018 The Verus Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+/*
+The replay corpus file, serialized block headers with the height and hash each is expected to
+have, for replaying recorded or generated chain data through the hash paths. All integers are
+little endian:
+
+    file        "VHRP"  magic
+                uint32  format version, 1
+                uint32  record count
+                record...
+    record      uint32  block height
+                uint8   BenchHashKind, the entry point that hashes it
+                uint8   expected hash[32], in the byte order the entry points write
+                uint32  header length
+                uint8   serialized CBlockHeader[length]
+
+The kind is stored rather than worked out from the height, so a corpus can hold headers of any
+chain, and of any mix of versions, for the benchmarks.
+*/
+#ifndef VERUSHASH_BENCH_REPLAY_H_
+#define VERUSHASH_BENCH_REPLAY_H_
+
+#include <errno.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+#include "bench/bench_corpus.h"
+
+static const uint32_t BENCH_REPLAY_VERSION = 1;
+static const uint32_t BENCH_REPLAY_MAX_HEADER = 1 << 20;    // larger lengths mean a damaged file
+
+struct CBenchReplayRecord
+{
+    uint32_t height;
+    CBenchHeader header;
+    unsigned char expected[32];
+};
+
+static void BenchReplayPut32(std::string &out, uint32_t v)
+{
+    for (int i = 0; i < 4; i++)
+    {
+        out += (char)(v >> (i * 8));
+    }
+}
+
+static bool BenchReplayGet32(FILE *f, uint32_t &v)
+{
+    unsigned char b[4];
+    if (fread(b, 1, 4, f) != 4)
+    {
+        return false;
+    }
+    v = b[0] | (b[1] << 8) | (b[2] << 16) | ((uint32_t)b[3] << 24);
+    return true;
+}
+
+// writes records to path, returning an empty string or the error
+static std::string WriteBenchReplay(const std::string &path, const std::vector<CBenchReplayRecord> &records)
+{
+    std::string out = "VHRP";
+    BenchReplayPut32(out, BENCH_REPLAY_VERSION);
+    BenchReplayPut32(out, records.size());
+    for (const CBenchReplayRecord &r : records)
+    {
+        BenchReplayPut32(out, r.height);
+        out += (char)r.header.kind;
+        out.append((const char *)r.expected, sizeof(r.expected));
+        BenchReplayPut32(out, r.header.bytes.size());
+        out += r.header.bytes;
+    }
+
+    FILE *f = fopen(path.c_str(), "wb");
+    if (!f)
+    {
+        return path + ": " + strerror(errno);
+    }
+    bool ok = fwrite(out.data(), 1, out.size(), f) == out.size();
+    ok = fclose(f) == 0 && ok;
+    return ok ? "" : path + ": write failed";
+}
+
+// reads the records of path, returning an empty string or the error
+static std::string ReadBenchReplay(const std::string &path, std::vector<CBenchReplayRecord> &records)
+{
+    FILE *f = fopen(path.c_str(), "rb");
+    if (!f)
+    {
+        return path + ": " + strerror(errno);
+    }
+
+    char magic[4];
+    uint32_t version, count;
+    std::string error;
+    if (fread(magic, 1, 4, f) != 4 || memcmp(magic, "VHRP", 4) || !BenchReplayGet32(f, version) || !BenchReplayGet32(f, count))
+    {
+        error = "not a replay corpus";
+    }
+    else if (version != BENCH_REPLAY_VERSION)
+    {
+        error = "unsupported format version " + std::to_string(version);
+    }
+
+    records.clear();
+    for (uint32_t i = 0; error.empty() && i < count; i++)
+    {
+        CBenchReplayRecord r;
+        uint32_t length = 0;
+        int kind = EOF;
+        if (!BenchReplayGet32(f, r.height) || (kind = fgetc(f)) == EOF ||
+            fread(r.expected, 1, sizeof(r.expected), f) != sizeof(r.expected) || !BenchReplayGet32(f, length))
+        {
+            error = "truncated record " + std::to_string(i);
+        }
+        else if (kind >= BENCH_HASH_KINDS || length > BENCH_REPLAY_MAX_HEADER)
+        {
+            error = "bad record " + std::to_string(i);
+        }
+        else
+        {
+            r.header.kind = kind;
+            r.header.bytes.resize(length);
+            if (length && fread(&r.header.bytes[0], 1, length, f) != length)
+            {
+                error = "truncated record " + std::to_string(i);
+            }
+            else
+            {
+                records.push_back(r);
+            }
+        }
+    }
+    fclose(f);
+    return error.empty() ? "" : path + ": " + error;
+}
+
+#endif
@@ -0,0 +1,191 @@
+// (C) 2018 The Verus Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+/*
+Time per hash of the VerusHash 2.2 CLHash step for every CLHash kernel in the registry that
+runs on this CPU, one hash at a time and four at once through clhashV2_2x4. Both are checked
+against the byte-wise "port" kernel, including the mutated keys and the move scratch.
+*/
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "crypto/verus_hash.h"
+
+static const uint64_t keySize = (VERUSKEYSIZE >> 5) << 5;
+static const int scratchSize = 64 + 1;      // two entries per loop iteration and the terminator
+
+struct CBenchLanes
+{
+    unsigned char *key[4];
+    __m128i **scratch[4];
+    unsigned char buf[4][64] __attribute__((aligned(32)));
+
+    CBenchLanes()
+    {
+        for (int lane = 0; lane < 4; lane++)
+        {
+            key[lane] = (unsigned char *)alloc_aligned_buffer(keySize);
+            scratch[lane] = (__m128i **)alloc_aligned_buffer(scratchSize * sizeof(__m128i *));
+            memset(scratch[lane], 0, scratchSize * sizeof(__m128i *));
+        }
+    }
+
+    ~CBenchLanes()
+    {
+        for (int lane = 0; lane < 4; lane++)
+        {
+            free(key[lane]);
+            free(scratch[lane]);
+        }
+    }
+
+    void Fill(uint32_t seed)
+    {
+        for (int lane = 0; lane < 4; lane++)
+        {
+            for (uint64_t i = 0; i < keySize; i++)
+            {
+                seed = seed * 1103515245 + 12345;
+                key[lane][i] = (unsigned char)(seed >> 16);
+            }
+            for (int i = 0; i < 64; i++)
+            {
+                seed = seed * 1103515245 + 12345;
+                buf[lane][i] = (unsigned char)(seed >> 16);
+            }
+        }
+    }
+
+    void Scalar(VerusCLHashFunction fn, uint64_t result[4])
+    {
+        for (int lane = 0; lane < 4; lane++)
+        {
+            result[lane] = (*fn)(key[lane], buf[lane], keymask(), scratch[lane]);
+        }
+    }
+
+    void X4(VerusCLHashX4Function fn, uint64_t result[4])
+    {
+        void *keys[4] = {key[0], key[1], key[2], key[3]};
+        const unsigned char *bufs[4] = {buf[0], buf[1], buf[2], buf[3]};
+        (*fn)(keys, bufs, keymask(), scratch, result);
+    }
+
+    static uint64_t keymask()
+    {
+        return verusclhasher::keymask(keySize);
+    }
+
+    // feeds each result back into its buffer, so the next hashes depend on this one
+    void Chain(const uint64_t result[4])
+    {
+        for (int lane = 0; lane < 4; lane++)
+        {
+            memcpy(buf[lane] + ((result[lane] >> 3) & 7) * 8, &result[lane], 8);
+        }
+    }
+};
+
+// same results, keys and key locations as the reference, over many chained hashes
+static bool same_output(const CVerusCLHashKernel *pk, const CVerusCLHashKernel *reference, bool x4)
+{
+    CBenchLanes test, ref;
+    test.Fill(1);
+    ref.Fill(1);
+    for (int i = 0; i < 2000; i++)
+    {
+        uint64_t testResult[4], refResult[4];
+        if (x4)
+        {
+            test.X4(pk->clhashV2_2x4, testResult);
+        }
+        else
+        {
+            test.Scalar(pk->clhash[VERUS_CLHASH_V2_2], testResult);
+        }
+        ref.Scalar(reference->clhash[VERUS_CLHASH_V2_2], refResult);
+        if (memcmp(testResult, refResult, sizeof(testResult)))
+        {
+            return false;
+        }
+        for (int lane = 0; lane < 4; lane++)
+        {
+            if (memcmp(test.key[lane], ref.key[lane], keySize))
+            {
+                return false;
+            }
+            for (int j = 0; j < scratchSize - 1; j++)
+            {
+                if ((unsigned char *)test.scratch[lane][j] - test.key[lane] != (unsigned char *)ref.scratch[lane][j] - ref.key[lane])
+                {
+                    return false;
+                }
+            }
+        }
+        test.Chain(testResult);
+        ref.Chain(refResult);
+    }
+    return true;
+}
+
+static double ns_per_hash(const CVerusCLHashKernel *pk, bool x4, int iterations)
+{
+    CBenchLanes lanes;
+    uint64_t result[4];
+
+    lanes.Fill(2);
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++)
+    {
+        if (x4)
+        {
+            lanes.X4(pk->clhashV2_2x4, result);
+        }
+        else
+        {
+            lanes.Scalar(pk->clhash[VERUS_CLHASH_V2_2], result);
+        }
+        lanes.Chain(result);
+    }
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(end - start).count() / (iterations * 4.0);
+}
+
+int main(int argc, char **argv)
+{
+    int iterations = argc > 1 ? atoi(argv[1]) : 50000;
+    const CVerusCLHashKernel *reference = NULL;
+    bool allMatch = true;
+
+    for (size_t i = 0; i < CVerusKernels::Count(VERUS_KERNEL_CLHASH); i++)
+    {
+        const CVerusCLHashKernel *pk = (const CVerusCLHashKernel *)CVerusKernels::Get(VERUS_KERNEL_CLHASH, i);
+        if (!strcmp(pk->name, "port"))
+        {
+            reference = pk;
+        }
+    }
+
+    printf("%s\n", CVerusKernels::Describe().c_str());
+    printf("%-10s %14s %14s %s\n", "kernel", "1x ns/hash", "4x ns/hash", "match");
+    for (size_t i = 0; i < CVerusKernels::Count(VERUS_KERNEL_CLHASH); i++)
+    {
+        const CVerusCLHashKernel *pk = (const CVerusCLHashKernel *)CVerusKernels::Get(VERUS_KERNEL_CLHASH, i);
+        if (!CVerusKernels::IsSupported(pk))
+        {
+            printf("%-10s not supported on this CPU\n", pk->name);
+            continue;
+        }
+        bool match = same_output(pk, reference, false) && same_output(pk, reference, true);
+        printf("%-10s %14.1f %14.1f %s\n", pk->name,
+               ns_per_hash(pk, false, iterations),
+               ns_per_hash(pk, true, iterations),
+               match ? "yes" : "NO");
+        allMatch = allMatch && match;
+    }
+    return allMatch ? 0 : 1;
+}
@@ -0,0 +1,210 @@
+// (C) 2018 The Verus Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+/*
+Throughput of every Haraka kernel in the registry that runs on this CPU,
+with each one checked for identical output against the byte-wise "port"
+reference. The multi-lane haraka512Zero kernels are timed per hash, and
+CVerusHash::HashBatch against CVerusHash::Hash per V1 block header.
+*/
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include <vector>
+
+#include "crypto/verus_hash.h"
+
+typedef void (*haraka_fn)(unsigned char *out, const unsigned char *in);
+
+static unsigned char benchKey[40 * 16] __attribute__((aligned(32)));
+static VerusHarakaKeyedFunction benchKeyed;
+
+static void haraka512_keyed_bench(unsigned char *out, const unsigned char *in)
+{
+    (*benchKeyed)(out, in, (const u128 *)benchKey);
+}
+
+// chains the output back into the input, so calls can not overlap
+static double ns_per_call(haraka_fn fn, int iterations)
+{
+    unsigned char buf[64] __attribute__((aligned(32))) = {0};
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++)
+    {
+        (*fn)(buf + (i & 1) * 32, buf);
+    }
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(end - start).count() / iterations;
+}
+
+// lanes hashes per call, each chained back into its own input, in ns per hash
+static double ns_per_lane_hash(haraka_fn fn, int lanes, int iterations)
+{
+    unsigned char buf[8 * 64] __attribute__((aligned(32))) = {0}, out[8 * 32];
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i += lanes)
+    {
+        (*fn)(out, buf);
+        for (int lane = 0; lane < lanes; lane++)
+        {
+            memcpy(buf + lane * 64 + (i & 32), out + lane * 32, 32);
+        }
+    }
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(end - start).count() / iterations;
+}
+
+static bool same_lanes(haraka_fn lanesFn, int lanes, haraka_fn one)
+{
+    unsigned char in[8 * 64] __attribute__((aligned(32))), out[8 * 32], ref[32];
+    for (int i = 0; i < 200; i++)
+    {
+        for (int j = 0; j < lanes * 64; j++)
+        {
+            in[j] = (unsigned char)(i * 131 + j * 7 + (i >> 3));
+        }
+        (*lanesFn)(out, in);
+        for (int lane = 0; lane < lanes; lane++)
+        {
+            (*one)(ref, in + lane * 64);
+            if (memcmp(ref, out + lane * 32, 32))
+            {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+static bool same_chain(VerusHarakaChainFunction chain, haraka_fn one)
+{
+    unsigned char in[64 + 1] __attribute__((aligned(32))), cv[32] __attribute__((aligned(32))), ref[32];
+    for (int i = 0; i < 1000; i++)
+    {
+        for (int j = 0; j < 65; j++)
+        {
+            in[j] = (unsigned char)(i * 131 + j * 7 + (i >> 3));
+        }
+        memcpy(cv, in, 32);
+        (*chain)(cv, cv, in + 33);          // block unaligned, out over cv
+        memmove(in + 32, in + 33, 32);
+        (*one)(ref, in);
+        if (memcmp(cv, ref, 32))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool same_output(haraka_fn a, VerusHarakaKeyedFunction keyedA, haraka_fn b, VerusHarakaKeyedFunction keyedB)
+{
+    unsigned char in[64] __attribute__((aligned(32))), outA[32], outB[32];
+    for (int i = 0; i < 1000; i++)
+    {
+        for (int j = 0; j < 64; j++)
+        {
+            in[j] = (unsigned char)(i * 131 + j * 7 + (i >> 3));
+        }
+        if (keyedA)
+        {
+            (*keyedA)(outA, in, (const u128 *)benchKey);
+            (*keyedB)(outB, in, (const u128 *)benchKey);
+        }
+        else
+        {
+            (*a)(outA, in);
+            (*b)(outB, in);
+        }
+        if (memcmp(outA, outB, 32))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    int iterations = argc > 1 ? atoi(argv[1]) : 200000;
+    const CVerusHarakaKernel *reference = NULL;
+    bool allMatch = true;
+
+    for (int i = 0; i < (int)sizeof(benchKey); i++)
+    {
+        benchKey[i] = (unsigned char)(i * 37 + 11);
+    }
+    for (size_t i = 0; i < CVerusKernels::Count(VERUS_KERNEL_HARAKA); i++)
+    {
+        const CVerusHarakaKernel *pk = (const CVerusHarakaKernel *)CVerusKernels::Get(VERUS_KERNEL_HARAKA, i);
+        if (!strcmp(pk->name, "port"))
+        {
+            reference = pk;
+        }
+    }
+
+    printf("%s\n", CVerusKernels::Describe().c_str());
+    printf("%-8s %12s %12s %12s %12s %12s %12s %s\n", "kernel", "h256 ns", "h512 ns", "h512z ns", "h512k ns", "h512z x4", "h512z x8", "match");
+    for (size_t i = 0; i < CVerusKernels::Count(VERUS_KERNEL_HARAKA); i++)
+    {
+        const CVerusHarakaKernel *pk = (const CVerusHarakaKernel *)CVerusKernels::Get(VERUS_KERNEL_HARAKA, i);
+        if (!CVerusKernels::IsSupported(pk))
+        {
+            printf("%-8s not supported on this CPU\n", pk->name);
+            continue;
+        }
+        bool match = same_output(pk->haraka256, NULL, reference->haraka256, NULL) &&
+                     same_output(pk->haraka512, NULL, reference->haraka512, NULL) &&
+                     same_output(pk->haraka512Zero, NULL, reference->haraka512Zero, NULL) &&
+                     same_output(NULL, pk->haraka512Keyed, NULL, reference->haraka512Keyed) &&
+                     same_lanes(pk->haraka512Zero4x, 4, reference->haraka512Zero) &&
+                     same_lanes(pk->haraka512Zero8x, 8, reference->haraka512Zero) &&
+                     same_chain(pk->haraka512Chain, reference->haraka512) &&
+                     same_chain(pk->haraka512ZeroChain, reference->haraka512Zero);
+        benchKeyed = pk->haraka512Keyed;
+        printf("%-8s %12.1f %12.1f %12.1f %12.1f %12.1f %12.1f %s\n", pk->name,
+               ns_per_call(pk->haraka256, iterations),
+               ns_per_call(pk->haraka512, iterations),
+               ns_per_call(pk->haraka512Zero, iterations),
+               ns_per_call(&haraka512_keyed_bench, iterations),
+               ns_per_lane_hash(pk->haraka512Zero4x, 4, iterations),
+               ns_per_lane_hash(pk->haraka512Zero8x, 8, iterations),
+               match ? "yes" : "NO");
+        allMatch = allMatch && match;
+    }
+
+    // V1 header rehash with the selected kernel, one at a time and in batches
+    const size_t headers = 4096, headerSize = 1487;
+    std::vector<unsigned char> bytes(headers * headerSize), one(headers * 32), batch(headers * 32);
+    std::vector<const unsigned char *> data(headers);
+    std::vector<size_t> len(headers, headerSize);
+    for (size_t i = 0; i < bytes.size(); i++)
+    {
+        bytes[i] = (unsigned char)(i * 2654435761U >> 13);
+    }
+    for (size_t i = 0; i < headers; i++)
+    {
+        data[i] = &bytes[i * headerSize];
+        len[i] = headerSize - (i % 5 == 0 ? i % 32 : 0);
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < headers; i++)
+    {
+        CVerusHash::Hash(&one[i * 32], data[i], len[i]);
+    }
+    auto middle = std::chrono::steady_clock::now();
+    CVerusHash::HashBatch(&batch[0], &data[0], &len[0], headers);
+    auto end = std::chrono::steady_clock::now();
+
+    bool batchMatch = one == batch;
+    printf("V1 header (%s): Hash %.1f ns, HashBatch %.1f ns, match %s\n", CVerusKernels::Haraka()->name,
+           std::chrono::duration<double, std::nano>(middle - start).count() / headers,
+           std::chrono::duration<double, std::nano>(end - middle).count() / headers,
+           batchMatch ? "yes" : "NO");
+    return allMatch && batchMatch ? 0 : 1;
+}
@@ -0,0 +1,53 @@
+# Fails if any global function of the library outside the x86-64-v3/v4, AVX-512 and VAES
+# kernels has VEX or EVEX encoded instructions. The linker keeps one copy of each inline or
+# template function, and a copy from a kernel source built for another feature level would
+# make the baseline code run AVX2 or AVX-512 instructions on any CPU, see crypto/verus_kernel_isa.h.
+#   cmake -DLIBRARY=<libverushash.a> -DOBJDUMP=<objdump> -DNM=<nm> -DOUT=<dir> -P isa_check.cmake
+
+# functions named for a feature level, which only the kernel registry calls after checking it
+set(ALLOWED "_(v3|v4|avx512|vaes)(\\(|$)")
+
+execute_process(COMMAND ${NM} -A -C --defined-only ${LIBRARY} OUTPUT_VARIABLE symbols RESULT_VARIABLE result)
+if(NOT result EQUAL 0)
+    message(FATAL_ERROR "${NM} failed: ${result}")
+endif()
+string(REPLACE ";" "\\;" symbols "${symbols}")
+string(REPLACE "\n" ";" symbols "${symbols}")
+set(globals "")
+foreach(line IN LISTS symbols)
+    if(line MATCHES "^[^:]+:([^:]+):[0-9a-f]+ [TWi] (.*)$")
+        string(APPEND globals "|${CMAKE_MATCH_1}:${CMAKE_MATCH_2}|")
+    endif()
+endforeach()
+
+# only object and function headers and the instructions with a VEX (c4, c5) or EVEX (62)
+# prefix, after any address size or segment prefixes
+execute_process(COMMAND ${OBJDUMP} -d -w -C ${LIBRARY} OUTPUT_FILE ${OUT}/isa_check.txt RESULT_VARIABLE result)
+if(NOT result EQUAL 0)
+    message(FATAL_ERROR "${OBJDUMP} failed: ${result}")
+endif()
+file(STRINGS ${OUT}/isa_check.txt lines
+     REGEX "file format|^[0-9a-f]+ <.*>:$|:\t((26|2e|36|3e|64|65|67) )*(62|c4|c5) ")
+
+set(object "")
+set(function "")
+set(bad "")
+foreach(line IN LISTS lines)
+    if(line MATCHES "^(.*):[ \t]+file format")
+        set(object "${CMAKE_MATCH_1}")
+    elseif(line MATCHES "^[0-9a-f]+ <(.*)>:$")
+        set(function "${CMAKE_MATCH_1}")
+        set(checked FALSE)
+    elseif(NOT checked)
+        set(checked TRUE)
+        string(FIND "${globals}" "|${object}:${function}|" global)
+        if(NOT global EQUAL -1 AND NOT function MATCHES "${ALLOWED}")
+            string(APPEND bad "    ${object}: ${function}: ${line}\n")
+        endif()
+    endif()
+endforeach()
+
+if(bad)
+    message(FATAL_ERROR "global functions with VEX or EVEX instructions outside the feature level kernels:\n${bad}")
+endif()
+message("-- no VEX or EVEX code outside the feature level kernels")
@@ -0,0 +1,35 @@
+# Runs verushash_train from the plain and the PGO+LTO build, checks that both hash the
+# corpus to the same digest and reports the speedup.
+#   cmake -DPLAIN=<verushash_train> -DOPTIMIZED=<pgo/verushash_train> -P pgo_report.cmake
+
+set(PASSES 10)
+
+foreach(build PLAIN OPTIMIZED)
+    execute_process(COMMAND ${${build}} ${PASSES} OUTPUT_VARIABLE out RESULT_VARIABLE result)
+    if(NOT result EQUAL 0)
+        message(FATAL_ERROR "${${build}} failed: ${result}")
+    endif()
+    string(REGEX MATCH "total_ns_per_hash ([0-9]+)" unused "${out}")
+    set(${build}_NS ${CMAKE_MATCH_1})
+    string(REGEX MATCH "digest ([0-9a-f]+)" unused "${out}")
+    set(${build}_DIGEST ${CMAKE_MATCH_1})
+    message("${build}:\n${out}")
+endforeach()
+
+if(NOT PLAIN_DIGEST STREQUAL OPTIMIZED_DIGEST)
+    message(FATAL_ERROR "PGO build output differs from the plain build")
+endif()
+if(NOT PLAIN_NS OR NOT OPTIMIZED_NS)
+    message(FATAL_ERROR "no timing in verushash_train output")
+endif()
+
+# cmake only has integer math, report with three decimals
+math(EXPR speedup "${PLAIN_NS} * 1000 / ${OPTIMIZED_NS}")
+math(EXPR whole "${speedup} / 1000")
+math(EXPR frac "${speedup} % 1000")
+string(LENGTH "${frac}" len)
+while(len LESS 3)
+    set(frac "0${frac}")
+    string(LENGTH "${frac}" len)
+endwhile()
+message("PGO+LTO: ${OPTIMIZED_NS} ns/hash, plain: ${PLAIN_NS} ns/hash, speedup ${whole}.${frac}x")
@@ -0,0 +1,945 @@
+// (C) 2018 The Verus Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+/*
+Benchmark of every hash path, written as JSON to standard output or a file:
+
+    verushash_bench [--quick] [--filter text] [--threads n] [--perf] [--perf-events list]
+                    [--repeat n] [--baseline file [--threshold percent]] [--out file]
+
+It measures
+    primitive   each Haraka, CLHash and SHA-256 kernel this CPU runs, including the four and
+                eight lane calls, and libsodium BLAKE2b
+    hash        V1, V2, V2b, V2b1 and V2b2 over a range of input sizes, for the kernels
+                selected at startup and with each Haraka and CLHash variant pinned in turn, plus
+                V2b2 of full block headers through the Verushash class the Go binding calls
+    batch       V1 headers one at a time and through CVerusHash::HashBatch at each lane width
+    threads     V1 and V2b2 headers on 1, 2, 4 ... threads, with the scaling efficiency
+    stages      in builds with VERUSHASH_STAGE_STATS, the cycles of each stage of V2b2 header
+                hashing, see crypto/verus_stage_stats.h
+    clhash      in builds with VERUSHASH_CLHASH_STATS, the CLHash case mix and key access
+                histograms over the whole header corpus, see crypto/verus_clhash_stats.h
+
+Every result has its ns per hash, TSC cycles per input byte and hashes per second. Each is the
+best of three runs, or --repeat runs, of at least the minimum time, 50 ms, or 10 ms with --quick,
+which also skips the pinned kernel variants. The median ns per hash of the runs and its 95%
+confidence interval come with it. --filter keeps the results whose group or name contains the
+text.
+
+--baseline compares the results with those in the JSON of an earlier run, see
+bench/bench_baseline.h, and exits with 2 if any single threaded result is more than the
+threshold, 5% by default, slower beyond the noise. Results that only one run has are listed.
+
+--perf counts cycles, instructions, L1D and branch misses, and on Intel the uops dispatched to
+ports 0, 1 and 5 that run AES and PCLMULQDQ, over the same best run, see bench/bench_perf.h.
+--perf-events takes a comma separated list of its event names instead. Each single threaded
+result then has a "perf" object of each event per hash and the IPC. Events the kernel doesn't
+allow are left out, with the reason in "perf_error", and the timings are made all the same.
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#include <x86intrin.h>
+#endif
+
+#include <sodium.h>
+
+#include "verushash.h"
+#include "bench/bench_baseline.h"
+#include "bench/bench_corpus.h"
+#include "bench/bench_perf.h"
+#include "crypto/sha256.h"
+#include "crypto/verus_hash.h"
+#include "crypto/verus_clhash_stats.h"
+#include "crypto/verus_stage_stats.h"
+
+struct CBenchResult
+{
+    std::string group;
+    std::string name;
+    std::string kernel;
+    size_t bytes;               // input bytes per hash
+    int width;                  // hashes per call
+    int threads;
+    double nsPerHash;
+    double cyclesPerByte;
+    double hashesPerSecond;
+    double scaling;             // threads results only, throughput over threads times one thread
+    int runs;
+    double median;              // ns per hash of the runs, and its 95% confidence interval
+    double ciLow, ciHigh;
+    std::vector<double> perf;   // each of perf.Names() per hash, when counting
+};
+
+struct CBenchOptions
+{
+    double minSeconds = 0.05;
+    bool quick = false;
+    std::string filter;
+    int maxThreads = 0;
+    std::vector<std::string> perfEvents;
+    int repeat = 3;
+    std::string baseline;
+    double threshold = 5;       // percent
+};
+
+static CBenchOptions options;
+static std::vector<CBenchResult> results;
+static std::vector<CVerusStageSummary> stages;
+static std::vector<CVerusCLHashStatsSnapshot> clhashStats;
+static std::string initialKernels;      // the selection at startup, VERUSHASH_KERNELS or automatic
+static CBenchPerf perf;
+
+static inline uint64_t tsc()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+static double tsc_ghz()
+{
+    auto start = std::chrono::steady_clock::now();
+    uint64_t startTsc = tsc();
+    while (std::chrono::steady_clock::now() - start < std::chrono::milliseconds(100))
+    {
+    }
+    double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    return (tsc() - startTsc) / ns;
+}
+
+static bool wanted(const std::string &group, const std::string &name)
+{
+    return options.filter.empty() || group.find(options.filter) != std::string::npos ||
+           name.find(options.filter) != std::string::npos;
+}
+
+// the selected kernel of each type, as a VERUSHASH_KERNELS spec
+static std::string selected_kernels()
+{
+    return std::string("haraka=") + CVerusKernels::Haraka()->name +
+           ",clhash=" + CVerusKernels::CLHash()->name +
+           ",sha256=" + CVerusKernels::SHA256()->name;
+}
+
+// the per hash count of a perf event of a result, or -1 if it wasn't counted
+static double perf_value(const std::vector<double> &values, const std::string &event)
+{
+    const std::vector<std::string> &names = perf.Names();
+    for (size_t i = 0; i < names.size() && i < values.size(); i++)
+    {
+        if (names[i] == event)
+        {
+            return values[i];
+        }
+    }
+    return -1;
+}
+
+static std::string perf_summary(const std::vector<double> &values)
+{
+    char buf[128] = "";
+    double cycles = perf_value(values, "cycles"), instructions = perf_value(values, "instructions");
+    double l1d = perf_value(values, "l1d-misses"), branches = perf_value(values, "branch-misses");
+    int len = 0;
+    if (cycles > 0 && instructions >= 0)
+    {
+        len += snprintf(buf + len, sizeof(buf) - len, "  ipc %.2f", instructions / cycles);
+    }
+    if (l1d >= 0)
+    {
+        len += snprintf(buf + len, sizeof(buf) - len, "  l1d %.2f", l1d);
+    }
+    if (branches >= 0)
+    {
+        snprintf(buf + len, sizeof(buf) - len, "  br %.2f", branches);
+    }
+    return buf;
+}
+
+// the processor brand string, such as "Intel(R) Xeon(R) Platinum 8375C CPU @ 2.90GHz"
+static std::string cpu_model()
+{
+    std::string model;
+#if defined(__x86_64__) || defined(__i386__)
+    unsigned int regs[12];
+    if (__get_cpuid_max(0x80000000, NULL) >= 0x80000004)
+    {
+        for (unsigned int i = 0; i < 3; i++)
+        {
+            __get_cpuid(0x80000002 + i, &regs[i * 4], &regs[i * 4 + 1], &regs[i * 4 + 2], &regs[i * 4 + 3]);
+        }
+        model.assign((const char *)regs, strnlen((const char *)regs, sizeof(regs)));
+        model.erase(0, model.find_first_not_of(' '));
+    }
+#endif
+    return model;
+}
+
+// loop(n) does n calls. returns the best ns and TSC cycles per call of options.repeat runs,
+// the perf counts of that run per call, and the ns per call of every run
+static void measure(const std::function<void(size_t)> &loop, double &nsPerCall, double &cyclesPerCall,
+                    std::vector<double> &perfPerCall, std::vector<double> &runs)
+{
+    size_t n = 1;
+    for (;;)
+    {
+        auto start = std::chrono::steady_clock::now();
+        loop(n);
+        if (std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() >= options.minSeconds || n >= (1ULL << 40))
+        {
+            break;
+        }
+        n <<= 1;
+    }
+
+    nsPerCall = cyclesPerCall = 0;
+    runs.clear();
+    for (int run = 0; run < options.repeat; run++)
+    {
+        perf.Start();
+        auto start = std::chrono::steady_clock::now();
+        uint64_t startTsc = tsc();
+        loop(n);
+        uint64_t cycles = tsc() - startTsc;
+        double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+        std::vector<double> counts = perf.Stop();
+        runs.push_back(ns / n);
+        if (run == 0 || ns / n < nsPerCall)
+        {
+            nsPerCall = ns / n;
+            cyclesPerCall = (double)cycles / n;
+            perfPerCall.clear();
+            for (double count : counts)
+            {
+                perfPerCall.push_back(count / n);
+            }
+        }
+    }
+}
+
+static void add(const std::string &group, const std::string &name, const std::string &kernel, size_t bytes, int width,
+                const std::function<void(size_t)> &loop)
+{
+    if (!wanted(group, name))
+    {
+        return;
+    }
+
+    CBenchResult r;
+    double ns, cycles;
+    std::vector<double> perfPerCall, runs;
+    measure(loop, ns, cycles, perfPerCall, runs);
+
+    r.group = group;
+    r.name = name;
+    r.kernel = kernel;
+    r.bytes = bytes;
+    r.width = width;
+    r.threads = 1;
+    r.nsPerHash = ns / width;
+    r.cyclesPerByte = bytes ? cycles / ((double)bytes * width) : 0;
+    r.hashesPerSecond = 1e9 / r.nsPerHash;
+    r.scaling = 1;
+    for (double &run : runs)
+    {
+        run /= width;
+    }
+    r.runs = runs.size();
+    r.median = BenchMedian(runs);
+    BenchMedianInterval(runs, r.ciLow, r.ciHigh);
+    for (double count : perfPerCall)
+    {
+        r.perf.push_back(count / width);
+    }
+    results.push_back(r);
+    fprintf(stderr, "%-9s %-14s %-52s %6zu bytes x%d %12.1f ns%s\n", group.c_str(), name.c_str(), kernel.c_str(), bytes, width,
+            r.nsPerHash, perf_summary(r.perf).c_str());
+}
+
+static std::vector<unsigned char> bench_bytes(size_t size)
+{
+    std::vector<unsigned char> v(size + 64);
+    CBenchRandom rnd(size);
+    rnd.Fill(v.data(), v.size());
+    return v;
+}
+
+static void bench_haraka()
+{
+    alignas(32) unsigned char in[8 * 64] = {0}, out[8 * 32], key[40 * 16];
+    CBenchRandom(1).Fill(key, sizeof(key));
+
+    for (size_t i = 0; i < CVerusKernels::Count(VERUS_KERNEL_HARAKA); i++)
+    {
+        const CVerusHarakaKernel *pk = (const CVerusHarakaKernel *)CVerusKernels::Get(VERUS_KERNEL_HARAKA, i);
+        if (!CVerusKernels::IsSupported(pk))
+        {
+            continue;
+        }
+        std::string kernel = std::string("haraka=") + pk->name;
+
+        // each call is fed its own output, so calls can't overlap
+        add("primitive", "haraka256", kernel, 32, 1, [&](size_t n) {
+            for (size_t j = 0; j < n; j++)
+                (*pk->haraka256)(in, in);
+        });
+        add("primitive", "haraka512", kernel, 64, 1, [&](size_t n) {
+            for (size_t j = 0; j < n; j++)
+                (*pk->haraka512)(in + 32, in);
+        });
+        add("primitive", "haraka512_zero", kernel, 64, 1, [&](size_t n) {
+            for (size_t j = 0; j < n; j++)
+                (*pk->haraka512Zero)(in + 32, in);
+        });
+        add("primitive", "haraka512_keyed", kernel, 64, 1, [&](size_t n) {
+            for (size_t j = 0; j < n; j++)
+                (*pk->haraka512Keyed)(in + 32, in, (const u128 *)key);
+        });
+        add("primitive", "haraka512_zero", kernel, 64, 4, [&](size_t n) {
+            for (size_t j = 0; j < n; j++)
+            {
+                (*pk->haraka512Zero4x)(out, in);
+                memcpy(in, out, 32);
+            }
+        });
+        add("primitive", "haraka512_zero", kernel, 64, 8, [&](size_t n) {
+            for (size_t j = 0; j < n; j++)
+            {
+                (*pk->haraka512Zero8x)(out, in);
+                memcpy(in, out, 32);
+            }
+        });
+    }
+}
+
+static void bench_clhash()
+{
+    const uint64_t keySize = (VERUSKEYSIZE >> 5) << 5;
+    const uint64_t keyMask = verusclhasher::keymask(keySize);
+    unsigned char *keys[4];
+    __m128i **scratch[4];
+    alignas(32) unsigned char buf[4][64];
+
+    for (int lane = 0; lane < 4; lane++)
+    {
+        keys[lane] = (unsigned char *)alloc_aligned_buffer(keySize);
+        scratch[lane] = (__m128i **)alloc_aligned_buffer(65 * sizeof(__m128i *));
+        CBenchRandom(lane).Fill(keys[lane], keySize);
+        CBenchRandom(lane + 4).Fill(buf[lane], 64);
+    }
+
+    static const char *versionNames[VERUS_CLHASH_VERSIONS] = {"clhash_v2", "clhash_v2_1", "clhash_v2_2"};
+    for (size_t i = 0; i < CVerusKernels::Count(VERUS_KERNEL_CLHASH); i++)
+    {
+        const CVerusCLHashKernel *pk = (const CVerusCLHashKernel *)CVerusKernels::Get(VERUS_KERNEL_CLHASH, i);
+        if (!CVerusKernels::IsSupported(pk))
+        {
+            continue;
+        }
+        std::string kernel = std::string("clhash=") + pk->name;
+
+        for (int version = 0; version < VERUS_CLHASH_VERSIONS; version++)
+        {
+            add("primitive", versionNames[version], kernel, 64, 1, [&](size_t n) {
+                for (size_t j = 0; j < n; j++)
+                {
+                    uint64_t r = (*pk->clhash[version])(keys[0], buf[0], keyMask, scratch[0]);
+                    memcpy(buf[0] + ((r >> 3) & 7) * 8, &r, 8);
+                }
+            });
+        }
+        add("primitive", "clhash_v2_2", kernel, 64, 4, [&](size_t n) {
+            void *k[4] = {keys[0], keys[1], keys[2], keys[3]};
+            const unsigned char *b[4] = {buf[0], buf[1], buf[2], buf[3]};
+            uint64_t r[4];
+            for (size_t j = 0; j < n; j++)
+            {
+                (*pk->clhashV2_2x4)(k, b, keyMask, scratch, r);
+                for (int lane = 0; lane < 4; lane++)
+                {
+                    memcpy(buf[lane] + ((r[lane] >> 3) & 7) * 8, &r[lane], 8);
+                }
+            }
+        });
+    }
+
+    for (int lane = 0; lane < 4; lane++)
+    {
+        free(keys[lane]);
+        free(scratch[lane]);
+    }
+}
+
+static void bench_sha256_blake2b(const std::vector<size_t> &sizes)
+{
+    for (size_t i = 0; i < CVerusKernels::Count(VERUS_KERNEL_SHA256); i++)
+    {
+        const CVerusKernel *pk = CVerusKernels::Get(VERUS_KERNEL_SHA256, i);
+        if (!CVerusKernels::IsSupported(pk) || !CVerusKernels::Select(VERUS_KERNEL_SHA256, pk->name))
+        {
+            continue;
+        }
+        for (size_t size : sizes)
+        {
+            std::vector<unsigned char> data = bench_bytes(size);
+            add("primitive", "sha256", std::string("sha256=") + pk->name, size, 1, [&](size_t n) {
+                unsigned char hash[CSHA256::OUTPUT_SIZE];
+                for (size_t j = 0; j < n; j++)
+                {
+                    CSHA256().Write(data.data(), size).Finalize(hash);
+                    data[0] ^= hash[0] | 1;
+                }
+            });
+        }
+    }
+    CVerusKernels::Select(initialKernels);
+
+    for (size_t size : sizes)
+    {
+        std::vector<unsigned char> data = bench_bytes(size);
+        add("primitive", "blake2b", "libsodium", size, 1, [&](size_t n) {
+            unsigned char hash[32];
+            for (size_t j = 0; j < n; j++)
+            {
+                crypto_generichash_blake2b(hash, sizeof(hash), data.data(), size, NULL, 0);
+                data[0] ^= hash[0] | 1;
+            }
+        });
+    }
+}
+
+static void hash_version(const std::string &version, unsigned char *out, const unsigned char *data, size_t size)
+{
+    if (version == "v1")
+    {
+        CVerusHash::Hash(out, data, size);
+    }
+    else if (version == "v2")
+    {
+        CVerusHashV2::Hash(out, data, size);
+    }
+    else
+    {
+        CVerusHashV2 vh(version == "v2b2" ? SOLUTION_VERUSHHASH_V2_2 :
+                        version == "v2b1" ? SOLUTION_VERUSHHASH_V2_1 : SOLUTION_VERUSHHASH_V2);
+        vh.Write(data, size);
+        vh.Finalize2b(out);
+    }
+}
+
+static void bench_hashes(const std::vector<CBenchHeader> &corpus)
+{
+    static const char *versions[] = {"v1", "v2", "v2b", "v2b1", "v2b2"};
+    std::vector<size_t> sizes = {32, 64, 256, 1487, 4096, 65536};
+    std::vector<std::string> specs = {initialKernels};
+
+    // each Haraka and CLHash variant pinned in turn, the other left as selected at startup
+    if (!options.quick)
+    {
+        for (int type = VERUS_KERNEL_HARAKA; type <= VERUS_KERNEL_CLHASH; type++)
+        {
+            for (size_t i = 0; i < CVerusKernels::Count((VerusKernelType)type); i++)
+            {
+                const CVerusKernel *pk = CVerusKernels::Get((VerusKernelType)type, i);
+                if (CVerusKernels::IsSupported(pk))
+                {
+                    specs.push_back(initialKernels + "," + CVerusKernels::TypeName((VerusKernelType)type) + "=" + pk->name);
+                }
+            }
+        }
+    }
+
+    std::vector<std::string> done;
+    for (const std::string &spec : specs)
+    {
+        CVerusKernels::Select(spec);
+        std::string kernel = selected_kernels();
+        if (std::find(done.begin(), done.end(), kernel) != done.end())
+        {
+            continue;
+        }
+        done.push_back(kernel);
+
+        for (const char *version : versions)
+        {
+            for (size_t size : sizes)
+            {
+                std::vector<unsigned char> data = bench_bytes(size);
+                add("hash", version, kernel, size, 1, [&](size_t n) {
+                    alignas(32) unsigned char hash[32];
+                    for (size_t j = 0; j < n; j++)
+                    {
+                        hash_version(version, hash, data.data(), size);
+                        // always a new input, or an unchanged one would reuse the CLHash key
+                        data[0] ^= hash[0] | 1;
+                    }
+                });
+            }
+        }
+
+        Verushash vh;
+        add("hash", "v2b2_header", kernel, corpus[0].bytes.size(), 1, [&](size_t n) {
+            unsigned char hash[32];
+            for (size_t j = 0; j < n; j++)
+            {
+                vh.verushash_v2b2(corpus[j % corpus.size()].bytes, hash);
+            }
+        });
+    }
+    CVerusKernels::Select(initialKernels);
+}
+
+static void bench_batch(const std::vector<CBenchHeader> &corpus)
+{
+    std::string kernel = selected_kernels();
+    std::vector<const unsigned char *> data(corpus.size());
+    std::vector<size_t> len(corpus.size());
+    std::vector<unsigned char> out(corpus.size() * 32);
+
+    for (size_t i = 0; i < corpus.size(); i++)
+    {
+        data[i] = (const unsigned char *)corpus[i].bytes.data();
+        len[i] = corpus[i].bytes.size();
+    }
+
+    add("batch", "v1_header", kernel, len[0], 1, [&](size_t n) {
+        for (size_t j = 0; j < n; j++)
+        {
+            CVerusHash::Hash(&out[0], data[j % data.size()], len[0]);
+        }
+    });
+    for (int width : {4, 8, 64})
+    {
+        add("batch", "v1_header", kernel, len[0], width, [&](size_t n) {
+            for (size_t j = 0; j < n; j++)
+            {
+                CVerusHash::HashBatch(&out[0], &data[(j * width) % (data.size() - width)], &len[0], width);
+            }
+        });
+    }
+}
+
+// throughput of name on 1, 2, 4 ... threads, each running hash on its own copy of the corpus
+static void bench_threads(const std::string &name, const std::vector<CBenchHeader> &corpus,
+                          const std::function<void(Verushash &, const CBenchHeader &, unsigned char *)> &hash)
+{
+    if (!wanted("threads", name))
+    {
+        return;
+    }
+
+    std::string kernel = selected_kernels();
+    double single = 0;
+    int maxThreads = options.maxThreads ? options.maxThreads : std::max(1, (int)std::thread::hardware_concurrency());
+    std::vector<int> counts;
+
+    for (int threads = 1; threads < maxThreads; threads <<= 1)
+    {
+        counts.push_back(threads);
+    }
+    counts.push_back(maxThreads);
+
+    for (int threads : counts)
+    {
+        std::vector<size_t> hashes(threads, 0);
+        std::vector<std::thread> workers;
+        auto duration = std::chrono::duration<double>(options.minSeconds * 4);
+        auto start = std::chrono::steady_clock::now();
+
+        for (int t = 0; t < threads; t++)
+        {
+            workers.push_back(std::thread([&, t]() {
+                Verushash vh;
+                unsigned char out[32];
+                size_t count = 0;
+                while (std::chrono::steady_clock::now() - start < duration)
+                {
+                    for (int j = 0; j < 16; j++, count++)
+                    {
+                        hash(vh, corpus[(count + t * 97) % corpus.size()], out);
+                    }
+                }
+                hashes[t] = count;
+            }));
+        }
+        for (std::thread &worker : workers)
+        {
+            worker.join();
+        }
+
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        size_t total = 0;
+        for (size_t h : hashes)
+        {
+            total += h;
+        }
+
+        CBenchResult r;
+        r.group = "threads";
+        r.name = name;
+        r.kernel = kernel;
+        r.bytes = corpus[0].bytes.size();
+        r.width = 1;
+        r.threads = threads;
+        r.hashesPerSecond = total / seconds;
+        r.nsPerHash = 1e9 / r.hashesPerSecond;
+        r.cyclesPerByte = 0;
+        if (threads == 1)
+        {
+            single = r.hashesPerSecond;
+        }
+        r.scaling = r.hashesPerSecond / (threads * single);
+        r.runs = 1;
+        r.median = r.ciLow = r.ciHigh = r.nsPerHash;
+        results.push_back(r);
+        fprintf(stderr, "%-9s %-14s %2d threads %12.0f hashes/s scaling %.2f\n", "threads", name.c_str(), threads, r.hashesPerSecond, r.scaling);
+    }
+}
+
+// the stage counters of a pass over the V2b2 headers with the kernels selected at startup
+static void bench_stages(const std::vector<CBenchHeader> &corpus)
+{
+    if (!CVerusStageStats::Enabled() || !wanted("stages", "v2b2_header"))
+    {
+        return;
+    }
+
+    Verushash vh;
+    unsigned char out[32];
+    CVerusStageStats::Reset();
+    for (size_t i = 0; i < (options.quick ? 20000 : 200000); i++)
+    {
+        vh.verushash_v2b2(corpus[i % corpus.size()].bytes, out);
+    }
+    for (int stage = 0; stage < VERUS_STAGES; stage++)
+    {
+        stages.push_back(CVerusStageStats::Summary(stage));
+    }
+    fprintf(stderr, "%s", CVerusStageStats::Report().c_str());
+}
+
+// the CLHash counters of a pass over every header of the corpus, each with its own hash version
+static void bench_clhash_stats(const std::vector<CBenchHeader> &corpus)
+{
+    if (!CVerusCLHashStats::Enabled() || !wanted("clhash", "header"))
+    {
+        return;
+    }
+
+    Verushash vh;
+    unsigned char out[32];
+    CVerusCLHashStats::Reset();
+    for (size_t i = 0; i < (options.quick ? 20000 : 200000); i++)
+    {
+        const CBenchHeader &header = corpus[i % corpus.size()];
+        switch (header.kind)
+        {
+            case BENCH_HASH_V1:
+            case BENCH_HASH_V2:
+                break;
+            case BENCH_HASH_V2B:
+                vh.verushash_v2b(header.bytes.data(), header.bytes.size(), out);
+                break;
+            case BENCH_HASH_V2B1:
+                vh.verushash_v2b1(header.bytes, header.bytes.size(), out);
+                break;
+            default:
+                vh.verushash_v2b2(header.bytes, out);
+                break;
+        }
+    }
+    clhashStats.resize(1);
+    CVerusCLHashStats::Snapshot(clhashStats[0]);
+    fprintf(stderr, "%s", CVerusCLHashStats::Report().c_str());
+}
+
+static std::string json_array(const uint64_t *values, size_t count)
+{
+    std::string out = "[";
+    for (size_t i = 0; i < count; i++)
+    {
+        out += (i ? ", " : "") + std::to_string(values[i]);
+    }
+    return out + "]";
+}
+
+static std::string json_string(const std::string &s)
+{
+    std::string out = "\"";
+    for (char c : s)
+    {
+        if (c == '"' || c == '\\')
+        {
+            out += '\\';
+        }
+        out += c;
+    }
+    return out + "\"";
+}
+
+static void write_json(FILE *f, double ghz)
+{
+    fprintf(f, "{\n");
+    fprintf(f, "  \"cpu_model\": %s,\n", json_string(cpu_model()).c_str());
+    fprintf(f, "  \"cpu_features\": %s,\n", json_string(CVerusKernels::CPUFeatureString()).c_str());
+    fprintf(f, "  \"kernels\": %s,\n", json_string(selected_kernels()).c_str());
+    fprintf(f, "  \"tsc_ghz\": %.3f,\n", ghz);
+    fprintf(f, "  \"hardware_threads\": %u,\n", std::thread::hardware_concurrency());
+    fprintf(f, "  \"min_seconds\": %g,\n", options.minSeconds);
+    if (!options.perfEvents.empty())
+    {
+        std::string names;
+        for (const std::string &name : perf.Names())
+        {
+            names += (names.empty() ? "" : ", ") + json_string(name);
+        }
+        fprintf(f, "  \"perf_events\": [%s],\n", names.c_str());
+        fprintf(f, "  \"perf_error\": %s,\n", json_string(perf.Error()).c_str());
+    }
+    fprintf(f, "  \"results\": [\n");
+    for (size_t i = 0; i < results.size(); i++)
+    {
+        const CBenchResult &r = results[i];
+        std::string perfJson;
+        if (!r.perf.empty())
+        {
+            char value[64];
+            for (size_t j = 0; j < r.perf.size(); j++)
+            {
+                snprintf(value, sizeof(value), ": %.3f", r.perf[j]);
+                perfJson += (j ? ", " : ", \"perf\": {") + json_string(perf.Names()[j]) + value;
+            }
+            double cycles = perf_value(r.perf, "cycles"), instructions = perf_value(r.perf, "instructions");
+            if (cycles > 0 && instructions >= 0)
+            {
+                snprintf(value, sizeof(value), ", \"ipc\": %.3f", instructions / cycles);
+                perfJson += value;
+            }
+            perfJson += "}";
+        }
+        fprintf(f, "    {\"group\": %s, \"name\": %s, \"kernel\": %s, \"bytes\": %zu, \"width\": %d, \"threads\": %d, "
+                   "\"ns_per_hash\": %.2f, \"cycles_per_byte\": %.3f, \"hashes_per_second\": %.0f, \"scaling\": %.3f, "
+                   "\"runs\": %d, \"median_ns\": %.2f, \"ci_low_ns\": %.2f, \"ci_high_ns\": %.2f%s}%s\n",
+                json_string(r.group).c_str(), json_string(r.name).c_str(), json_string(r.kernel).c_str(),
+                r.bytes, r.width, r.threads, r.nsPerHash, r.cyclesPerByte, r.hashesPerSecond, r.scaling,
+                r.runs, r.median, r.ciLow, r.ciHigh, perfJson.c_str(), i + 1 < results.size() ? "," : "");
+    }
+    fprintf(f, "  ],\n");
+    fprintf(f, "  \"stages\": [\n");
+    for (size_t i = 0; i < stages.size(); i++)
+    {
+        const CVerusStageSummary &s = stages[i];
+        fprintf(f, "    {\"stage\": %s, \"count\": %llu, \"average\": %.1f, \"p50\": %llu, \"p90\": %llu, "
+                   "\"p99\": %llu, \"p999\": %llu, \"max\": %llu}%s\n",
+                json_string(s.name).c_str(), (unsigned long long)s.count, s.average, (unsigned long long)s.p50,
+                (unsigned long long)s.p90, (unsigned long long)s.p99, (unsigned long long)s.p999, (unsigned long long)s.max,
+                i + 1 < stages.size() ? "," : "");
+    }
+    fprintf(f, "  ]");
+    if (!clhashStats.empty())
+    {
+        const CVerusCLHashStatsSnapshot &s = clhashStats[0];
+        fprintf(f, ",\n  \"clhash\": {\n");
+        fprintf(f, "    \"hashes\": %s,\n", json_array(s.hashes, VERUS_CLHASH_VERSIONS).c_str());
+        fprintf(f, "    \"cases\": [%s, %s, %s],\n", json_array(s.cases[0], 8).c_str(), json_array(s.cases[1], 8).c_str(),
+                json_array(s.cases[2], 8).c_str());
+        fprintf(f, "    \"prand\": %s,\n", json_array(s.prand, VERUS_CLHASH_STATS_ENTRIES).c_str());
+        fprintf(f, "    \"prandex\": %s,\n", json_array(s.prandex, VERUS_CLHASH_STATS_ENTRIES).c_str());
+        fprintf(f, "    \"reuse\": %s,\n", json_array(s.reuse, 64).c_str());
+        fprintf(f, "    \"lines\": %s\n  }", json_array(s.lines, 65).c_str());
+    }
+    fprintf(f, "\n}\n");
+}
+
+// compares results with the baseline file, returning the number of regressions
+static int compare_baseline(const std::string &path)
+{
+    CBenchBaseline baseline;
+    std::string error = ReadBenchBaseline(path, baseline);
+    if (!error.empty())
+    {
+        fprintf(stderr, "%s\n", error.c_str());
+        return -1;
+    }
+    if (baseline.cpuModel != cpu_model() || baseline.kernels != initialKernels)
+    {
+        fprintf(stderr, "warning: the baseline ran on \"%s\" with %s, this run on \"%s\" with %s\n",
+                baseline.cpuModel.c_str(), baseline.kernels.c_str(), cpu_model().c_str(), initialKernels.c_str());
+    }
+
+    int regressions = 0, improvements = 0, compared = 0;
+    std::map<std::string, bool> seen;
+    fprintf(stderr, "%-80s %12s %12s %8s\n", "result", "baseline ns", "ns", "change");
+    for (const CBenchResult &r : results)
+    {
+        std::string key = BenchResultKey(r.group, r.name, r.kernel, r.bytes, r.width, r.threads);
+        auto it = baseline.results.find(key);
+        seen[key] = true;
+        if (it == baseline.results.end())
+        {
+            fprintf(stderr, "%-80s %12s %12.1f %8s\n", key.c_str(), "-", r.median, "new");
+            continue;
+        }
+
+        // the threads results are one run each and vary with whatever else the machine does
+        if (r.threads > 1 || r.group == "threads")
+        {
+            continue;
+        }
+        const CBenchBaselineEntry &b = it->second;
+        double change = (r.median / b.median - 1) * 100;
+        const char *verdict = "";
+        if (change > options.threshold && r.ciLow > b.ciHigh)
+        {
+            verdict = "  REGRESSION";
+            regressions++;
+        }
+        else if (change < -options.threshold && r.ciHigh < b.ciLow)
+        {
+            verdict = "  faster";
+            improvements++;
+        }
+        compared++;
+        fprintf(stderr, "%-80s %12.1f %12.1f %+7.1f%%%s\n", key.c_str(), b.median, r.median, change, verdict);
+    }
+    for (const auto &entry : baseline.results)
+    {
+        if (!seen.count(entry.first) && (options.filter.empty() || entry.first.find(options.filter) != std::string::npos))
+        {
+            fprintf(stderr, "%-80s %12.1f %12s %8s\n", entry.first.c_str(), entry.second.median, "-", "missing");
+        }
+    }
+    fprintf(stderr, "%d results compared, %d slower and %d faster by more than %g%% beyond the noise\n",
+            compared, regressions, improvements, options.threshold);
+    return regressions;
+}
+
+int main(int argc, char **argv)
+{
+    const char *outPath = NULL;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (!strcmp(argv[i], "--quick"))
+        {
+            options.quick = true;
+            options.minSeconds = 0.01;
+        }
+        else if (!strcmp(argv[i], "--filter") && i + 1 < argc)
+        {
+            options.filter = argv[++i];
+        }
+        else if (!strcmp(argv[i], "--threads") && i + 1 < argc)
+        {
+            options.maxThreads = atoi(argv[++i]);
+        }
+        else if (!strcmp(argv[i], "--perf"))
+        {
+            options.perfEvents = CBenchPerf::DefaultEvents();
+        }
+        else if (!strcmp(argv[i], "--perf-events") && i + 1 < argc)
+        {
+            std::string list = argv[++i];
+            options.perfEvents.clear();
+            for (size_t start = 0, end; start <= list.size(); start = end + 1)
+            {
+                end = std::min(list.find(',', start), list.size());
+                if (end > start)
+                {
+                    options.perfEvents.push_back(list.substr(start, end - start));
+                }
+            }
+        }
+        else if (!strcmp(argv[i], "--repeat") && i + 1 < argc && atoi(argv[i + 1]) >= 1)
+        {
+            options.repeat = atoi(argv[++i]);
+        }
+        else if (!strcmp(argv[i], "--baseline") && i + 1 < argc)
+        {
+            options.baseline = argv[++i];
+        }
+        else if (!strcmp(argv[i], "--threshold") && i + 1 < argc)
+        {
+            options.threshold = atof(argv[++i]);
+        }
+        else if (!strcmp(argv[i], "--out") && i + 1 < argc)
+        {
+            outPath = argv[++i];
+        }
+        else
+        {
+            fprintf(stderr, "usage: %s [--quick] [--filter text] [--threads n] [--perf] [--perf-events list]\n"
+                            "       [--repeat n] [--baseline file [--threshold percent]] [--out file]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    Verushash vh;
+    vh.initialize();
+
+    initialKernels = selected_kernels();
+    double ghz = tsc_ghz();
+    std::vector<CBenchHeader> corpus = MakeBenchCorpus(256);
+    std::vector<CBenchHeader> v2b2Headers, v1Headers;
+    for (const CBenchHeader &header : corpus)
+    {
+        (header.kind >= BENCH_HASH_V2B2 ? v2b2Headers : v1Headers).push_back(header);
+    }
+
+    fprintf(stderr, "%s\n", CVerusKernels::Describe().c_str());
+    if (!options.perfEvents.empty())
+    {
+        perf.Open(options.perfEvents);
+        if (!perf.Error().empty())
+        {
+            fprintf(stderr, "perf counters not counted: %s\n", perf.Error().c_str());
+        }
+    }
+    bench_haraka();
+    bench_clhash();
+    bench_sha256_blake2b(options.quick ? std::vector<size_t>{64, 1487} : std::vector<size_t>{64, 1487, 65536});
+    bench_hashes(v2b2Headers);
+    bench_batch(corpus);
+    bench_stages(v2b2Headers);
+    bench_clhash_stats(corpus);
+    bench_threads("v1_header", corpus, [](Verushash &vh, const CBenchHeader &header, unsigned char *out) {
+        vh.verushash(header.bytes.data(), header.bytes.size(), out);
+    });
+    bench_threads("v2b2_header", v2b2Headers, [](Verushash &vh, const CBenchHeader &header, unsigned char *out) {
+        vh.verushash_v2b2(header.bytes, out);
+    });
+
+    FILE *f = outPath ? fopen(outPath, "w") : stdout;
+    if (!f)
+    {
+        perror(outPath);
+        return 1;
+    }
+    write_json(f, ghz);
+    if (outPath)
+    {
+        fclose(f);
+    }
+
+    if (!options.baseline.empty())
+    {
+        int regressions = compare_baseline(options.baseline);
+        return regressions < 0 ? 1 : regressions ? 2 : 0;
+    }
+    return 0;
+}
@@ -0,0 +1,169 @@
+// (C) 2018 The Verus Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+/*
+VerusHash of files through CVerusFileHasher, with the throughput of each hash version.
+
+    verushash_file [-v version] [-m auto|mmap|pread] [-c chunk MiB] [-p] file...
+
+The version is v1, v2, v2b, v2b1, v2b2 or all, the default. "-" hashes standard input, with
+a single version. For every file and version it prints the hash, in byte order, and GB/s:
+
+    <hash>  v2b2  <bytes> bytes  <seconds> s  <GB/s> GB/s  <file>
+
+-p shows the progress of each hash on standard error.
+*/
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+#include "crypto/verus_hash_file.h"
+
+struct CProgress
+{
+    const char *file;
+    const char *version;
+    uint64_t lastPercent;
+};
+
+static bool show_progress(uint64_t done, uint64_t total, void *context)
+{
+    CProgress *p = (CProgress *)context;
+    if (total)
+    {
+        uint64_t percent = done * 100 / total;
+        if (percent != p->lastPercent)
+        {
+            fprintf(stderr, "\r%s %s %3d%%", p->version, p->file, (int)percent);
+            p->lastPercent = percent;
+        }
+    }
+    else
+    {
+        fprintf(stderr, "\r%s %s %llu MiB", p->version, p->file, (unsigned long long)(done >> 20));
+    }
+    return true;
+}
+
+static int usage(const char *name)
+{
+    fprintf(stderr, "usage: %s [-v v1|v2|v2b|v2b1|v2b2|all] [-m auto|mmap|pread] [-c chunk MiB] [-p] file...\n", name);
+    return 1;
+}
+
+int main(int argc, char **argv)
+{
+    std::vector<int> versions;
+    int method = VERUS_FILE_READ_AUTO;
+    size_t chunkSize = CVerusFileHasher::DEFAULT_CHUNK_SIZE;
+    bool progress = false;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "v:m:c:p")) != -1)
+    {
+        switch (opt)
+        {
+            case 'v':
+                if (!strcmp(optarg, "all"))
+                {
+                    versions.clear();
+                }
+                else if (CVerusFileHasher::VersionFromName(optarg) >= 0)
+                {
+                    versions.push_back(CVerusFileHasher::VersionFromName(optarg));
+                }
+                else
+                {
+                    return usage(argv[0]);
+                }
+                break;
+            case 'm':
+                if (!strcmp(optarg, "auto"))
+                    method = VERUS_FILE_READ_AUTO;
+                else if (!strcmp(optarg, "mmap"))
+                    method = VERUS_FILE_READ_MMAP;
+                else if (!strcmp(optarg, "pread"))
+                    method = VERUS_FILE_READ_BUFFERED;
+                else
+                    return usage(argv[0]);
+                break;
+            case 'c':
+                chunkSize = strtoul(optarg, NULL, 10) << 20;
+                if (!chunkSize)
+                {
+                    return usage(argv[0]);
+                }
+                break;
+            case 'p':
+                progress = true;
+                break;
+            default:
+                return usage(argv[0]);
+        }
+    }
+    if (optind >= argc)
+    {
+        return usage(argv[0]);
+    }
+    if (versions.empty())
+    {
+        for (int version = 0; version < VERUS_FILE_HASH_VERSIONS; version++)
+        {
+            versions.push_back(version);
+        }
+    }
+
+    int status = 0;
+    for (int i = optind; i < argc; i++)
+    {
+        bool isStdin = !strcmp(argv[i], "-");
+        if (isStdin && versions.size() > 1)
+        {
+            fprintf(stderr, "%s: standard input can only be hashed with a single -v version\n", argv[0]);
+            return 1;
+        }
+        for (size_t v = 0; v < versions.size(); v++)
+        {
+            CVerusFileHasher hasher(versions[v]);
+            CProgress state = {argv[i], CVerusFileHasher::VersionName(versions[v]), ~0ULL};
+            unsigned char hash[32];
+            std::string error;
+
+            hasher.SetChunkSize(chunkSize);
+            if (progress)
+            {
+                hasher.SetProgress(show_progress, &state);
+            }
+
+            auto start = std::chrono::steady_clock::now();
+            bool ok = isStdin ? hasher.HashDescriptor(STDIN_FILENO, hash, method, &error) :
+                                hasher.HashFile(argv[i], hash, method, &error);
+            auto end = std::chrono::steady_clock::now();
+            if (progress)
+            {
+                fprintf(stderr, "\r\033[K");
+            }
+            if (!ok)
+            {
+                fprintf(stderr, "%s: %s\n", argv[0], error.c_str());
+                status = 1;
+                break;
+            }
+            uint64_t bytes = hasher.BytesHashed();
+            double seconds = std::chrono::duration<double>(end - start).count();
+            for (int j = 0; j < 32; j++)
+            {
+                printf("%02x", hash[j]);
+            }
+            printf("  %-4s  %llu bytes  %.3f s  %.3f GB/s  %s\n", CVerusFileHasher::VersionName(versions[v]),
+                   (unsigned long long)bytes, seconds, seconds > 0 ? bytes / seconds / 1e9 : 0.0, argv[i]);
+        }
+    }
+    return status;
+}
@@ -0,0 +1,103 @@
+// (C) 2018 The Verus Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+/*
+libFuzzer entry point for Verushash::verushash_v2b2, which parses its input as a block header
+before hashing it. Each input is hashed with the kernels this CPU selects and again with the
+portable reference, and also as plain V2b2 of the same bytes, and any difference aborts. A parse
+failure must give the same zero result either way.
+
+With clang and VERUSHASH_FUZZ=ON this links with -fsanitize=fuzzer,address. Other compilers
+get a main that runs each file argument once, which replays a crash or a corpus:
+
+    verushash_fuzz corpus/ -max_len=4096        libFuzzer build
+    verushash_fuzz crash-1234 ...               replay build
+*/
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+#include "verushash.h"
+#include "crypto/verus_hash.h"
+
+static const char *REFERENCE = "haraka=port,clhash=port,sha256=generic";
+static const char *SELECTED = "haraka=auto,clhash=auto,sha256=auto";
+
+static void compare(const char *what, const unsigned char *selected, const unsigned char *reference, size_t len)
+{
+    if (memcmp(selected, reference, 32))
+    {
+        fprintf(stderr, "%s of %zu bytes differs, %s from the reference\n", what, len, CVerusKernels::Describe().c_str());
+        abort();
+    }
+}
+
+static void hash_both(const std::string &bytes, unsigned char header[32], unsigned char plain[32])
+{
+    Verushash vh;
+    vh.verushash_v2b2(bytes, header);
+
+    CVerusHashV2 v2b2(SOLUTION_VERUSHHASH_V2_2);
+    v2b2.Reset();
+    v2b2.Write((const unsigned char *)bytes.data(), bytes.size());
+    v2b2.Finalize2b(plain);
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+    static bool initialized = false;
+    if (!initialized)
+    {
+        Verushash().initialize();
+        initialized = true;
+    }
+
+    std::string bytes((const char *)data, size);
+    unsigned char header[2][32], plain[2][32];
+
+    CVerusKernels::Select(SELECTED);
+    hash_both(bytes, header[0], plain[0]);
+    CVerusKernels::Select(REFERENCE);
+    hash_both(bytes, header[1], plain[1]);
+    CVerusKernels::Select(SELECTED);
+
+    compare("verushash_v2b2", header[0], header[1], size);
+    compare("V2b2", plain[0], plain[1], size);
+    return 0;
+}
+
+#ifndef VERUSHASH_LIBFUZZER
+int main(int argc, char **argv)
+{
+    if (argc < 2)
+    {
+        fprintf(stderr, "usage: %s file...\n", argv[0]);
+        return 1;
+    }
+    for (int i = 1; i < argc; i++)
+    {
+        FILE *f = fopen(argv[i], "rb");
+        if (!f)
+        {
+            perror(argv[i]);
+            return 1;
+        }
+        std::vector<uint8_t> data;
+        uint8_t buf[4096];
+        size_t n;
+        while ((n = fread(buf, 1, sizeof(buf), f)) > 0)
+        {
+            data.insert(data.end(), buf, buf + n);
+        }
+        fclose(f);
+        LLVMFuzzerTestOneInput(data.data(), data.size());
+        printf("%s: %zu bytes, ok\n", argv[i], data.size());
+    }
+    return 0;
+}
+#endif
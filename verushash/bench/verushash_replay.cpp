@@ -0,0 +1,407 @@
+// (C) 2018 The Verus Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+/*
+Writes and replays corpus files of serialized block headers, see bench/bench_replay.h.
+
+    verushash_replay generate <file> [headers [seed]]
+    verushash_replay run <file> [passes [threads]]
+    verushash_replay gobench <file> [seconds]
+
+generate writes the bench_corpus.h header mix, V2b2 headers with and without PBaaS headers, some
+of them for this chain so that CheckNonCanonicalData clears them, and older versions, with
+sequential heights and the hashes this build computes. Make it with a known good build, or
+write recorded chain headers in the same format, to check later ones.
+
+run hashes every header through the Verushash entry points the Go binding calls, the full
+GetVerusV2Hash path for V2b2, three ways:
+
+    single      one header at a time on one thread
+    batch       V1 headers through CVerusHash::HashBatch 64 at a time, the other versions one
+                at a time, verushash_batch spreads either over threads
+    threads     the corpus split across threads, each with its own Verushash, default all
+                hardware threads
+
+Every output is checked against the corpus. It prints the best throughput of each way over the
+passes, and per kind for single, and exits with 1 on any mismatch.
+
+gobench times the same calls as the Go benchmarks in verushash_bench_test.go at the repository
+root, on the same corpus, and prints them in Go benchmark format under the same names, seq
+on one thread and parallel on all hardware threads like b.RunParallel. What the Go results add
+over these is the cost of the binding: the cgo call, and the result slice of the functions
+that return one, which the Sum functions don't allocate. For example, with benchstat:
+
+    go test -run - -bench . -count 5 > go.txt
+    verushash_replay gobench testdata/headers.vhrp > cpp.txt    (five times)
+    benchstat cpp.txt go.txt
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "verushash.h"
+#include "bench/bench_replay.h"
+#include "crypto/verus_hash.h"
+#include "crypto/verus_latency.h"
+
+static size_t mismatches = 0;
+
+static void mismatch(const CBenchReplayRecord &r, const char *way)
+{
+    if (mismatches++ < 10)
+    {
+        fprintf(stderr, "%s: mismatch at height %u, %s\n", way, r.height, BenchHashKindName(r.header.kind));
+    }
+}
+
+static void check(const CBenchReplayRecord &r, const unsigned char *out, const char *way)
+{
+    if (memcmp(out, r.expected, 32))
+    {
+        mismatch(r, way);
+    }
+}
+
+static double seconds_since(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+static int generate(const std::string &path, size_t count, uint64_t seed)
+{
+    Verushash vh;
+    vh.initialize();
+
+    std::vector<CBenchHeader> corpus = MakeBenchCorpus(count, seed);
+    std::vector<CBenchReplayRecord> records(corpus.size());
+    for (size_t i = 0; i < corpus.size(); i++)
+    {
+        records[i].height = i + 1;
+        records[i].header = corpus[i];
+        BenchHashHeader(vh, corpus[i], records[i].expected);
+    }
+
+    std::string error = WriteBenchReplay(path, records);
+    if (!error.empty())
+    {
+        fprintf(stderr, "%s\n", error.c_str());
+        return 1;
+    }
+    printf("%zu headers written to %s\n", records.size(), path.c_str());
+    return 0;
+}
+
+// seconds for one pass over records one at a time, adding each kind's seconds to kindSeconds
+static double replay_single(Verushash &vh, const std::vector<CBenchReplayRecord> &records, double *kindSeconds)
+{
+    unsigned char out[32];
+    auto start = std::chrono::steady_clock::now();
+    for (const CBenchReplayRecord &r : records)
+    {
+        auto headerStart = std::chrono::steady_clock::now();
+        BenchHashHeader(vh, r.header, out);
+        kindSeconds[r.header.kind] += seconds_since(headerStart);
+        check(r, out, "single");
+    }
+    return seconds_since(start);
+}
+
+static double replay_batch(Verushash &vh, const std::vector<CBenchReplayRecord> &records)
+{
+    const size_t width = 64;
+    std::vector<const CBenchReplayRecord *> batch;
+    std::vector<const unsigned char *> data;
+    std::vector<size_t> len;
+    std::vector<unsigned char> results(width * 32);
+    unsigned char out[32];
+
+    auto flush = [&]() {
+        data.clear();
+        len.clear();
+        for (const CBenchReplayRecord *r : batch)
+        {
+            data.push_back((const unsigned char *)r->header.bytes.data());
+            len.push_back(r->header.bytes.size());
+        }
+        CVerusHash::HashBatch(results.data(), data.data(), len.data(), batch.size());
+        for (size_t i = 0; i < batch.size(); i++)
+        {
+            check(*batch[i], &results[i * 32], "batch");
+        }
+        batch.clear();
+    };
+
+    auto start = std::chrono::steady_clock::now();
+    for (const CBenchReplayRecord &r : records)
+    {
+        if (r.header.kind == BENCH_HASH_V1)
+        {
+            batch.push_back(&r);
+            if (batch.size() == width)
+            {
+                flush();
+            }
+        }
+        else
+        {
+            BenchHashHeader(vh, r.header, out);
+            check(r, out, "batch");
+        }
+    }
+    flush();
+    return seconds_since(start);
+}
+
+static double replay_threads(const std::vector<CBenchReplayRecord> &records, int threads)
+{
+    std::vector<std::vector<const CBenchReplayRecord *>> failed(threads);
+    std::vector<std::thread> workers;
+
+    auto start = std::chrono::steady_clock::now();
+    for (int t = 0; t < threads; t++)
+    {
+        workers.push_back(std::thread([&, t]() {
+            Verushash vh;
+            unsigned char out[32];
+            for (size_t i = t; i < records.size(); i += threads)
+            {
+                BenchHashHeader(vh, records[i].header, out);
+                if (memcmp(out, records[i].expected, 32))
+                {
+                    failed[t].push_back(&records[i]);
+                }
+            }
+        }));
+    }
+    for (std::thread &worker : workers)
+    {
+        worker.join();
+    }
+    double seconds = seconds_since(start);
+
+    // reported after the run, so the threads don't share the mismatch count
+    for (const std::vector<const CBenchReplayRecord *> &f : failed)
+    {
+        for (const CBenchReplayRecord *r : f)
+        {
+            mismatch(*r, "threads");
+        }
+    }
+    return seconds;
+}
+
+static int run(const std::string &path, int passes, int threads)
+{
+    std::vector<CBenchReplayRecord> records;
+    std::string error = ReadBenchReplay(path, records);
+    if (!error.empty() || records.empty())
+    {
+        fprintf(stderr, "%s\n", error.empty() ? (path + ": no headers").c_str() : error.c_str());
+        return 1;
+    }
+
+    Verushash vh;
+    vh.initialize();
+
+    size_t kindCount[BENCH_HASH_KINDS] = {0};
+    double bestKind[BENCH_HASH_KINDS] = {0}, bestSingle = 0, bestBatch = 0, bestThreads = 0;
+    for (const CBenchReplayRecord &r : records)
+    {
+        kindCount[r.header.kind]++;
+    }
+
+    for (int pass = 0; pass < passes; pass++)
+    {
+        double kindSeconds[BENCH_HASH_KINDS] = {0};
+        double single = replay_single(vh, records, kindSeconds);
+        double batch = replay_batch(vh, records);
+        double threaded = replay_threads(records, threads);
+
+        for (int kind = 0; kind < BENCH_HASH_KINDS; kind++)
+        {
+            if (pass == 0 || kindSeconds[kind] < bestKind[kind])
+            {
+                bestKind[kind] = kindSeconds[kind];
+            }
+        }
+        bestSingle = pass == 0 ? single : std::min(bestSingle, single);
+        bestBatch = pass == 0 ? batch : std::min(bestBatch, batch);
+        bestThreads = pass == 0 ? threaded : std::min(bestThreads, threaded);
+    }
+
+    printf("kernels %s\n", CVerusKernels::Describe().c_str());
+    printf("headers %zu passes %d threads %d\n", records.size(), passes, threads);
+    for (int kind = 0; kind < BENCH_HASH_KINDS; kind++)
+    {
+        if (kindCount[kind])
+        {
+            printf("single  %-12s %8zu headers %12.0f hashes/s\n", BenchHashKindName(kind), kindCount[kind], kindCount[kind] / bestKind[kind]);
+        }
+    }
+    printf("single  %-12s %8zu headers %12.0f hashes/s\n", "all", records.size(), records.size() / bestSingle);
+    printf("batch   %-12s %8zu headers %12.0f hashes/s\n", "all", records.size(), records.size() / bestBatch);
+    printf("threads %-12s %8zu headers %12.0f hashes/s\n", "all", records.size(), records.size() / bestThreads);
+    printf("mismatches %zu\n", mismatches);
+    return mismatches ? 1 : 0;
+}
+
+// the per op time of calling op for seconds on threads threads, each op given a running index
+template <typename F>
+static double gobench_time(int threads, double seconds, F op)
+{
+    std::vector<uint64_t> ops(threads);
+    std::vector<std::thread> workers;
+    auto start = std::chrono::steady_clock::now();
+    for (int t = 0; t < threads; t++)
+    {
+        workers.push_back(std::thread([&, t]() {
+            Verushash vh;
+            uint64_t n = 0;
+            do
+            {
+                for (int i = 0; i < 64; i++, n++)
+                {
+                    op(vh, n);
+                }
+            } while (seconds_since(start) < seconds);
+            ops[t] = n;
+        }));
+    }
+    for (std::thread &worker : workers)
+    {
+        worker.join();
+    }
+    double elapsed = seconds_since(start);
+    uint64_t total = 0;
+    for (uint64_t n : ops)
+    {
+        total += n;
+    }
+    return elapsed * 1e9 / total;
+}
+
+// one result line as go test -bench prints it, which leaves out the -1 of GOMAXPROCS 1
+static void gobench_print(const std::string &name, int procs, double nsPerOp, size_t bytes, double seconds)
+{
+    std::string full = "Benchmark" + name + (procs > 1 ? "-" + std::to_string(procs) : "");
+    uint64_t n = seconds * 1e9 / nsPerOp;
+    printf("%-40s %10llu %12.1f ns/op", full.c_str(), (unsigned long long)n, nsPerOp);
+    if (bytes)
+    {
+        printf(" %8.2f MB/s", bytes * 1e3 / nsPerOp);
+    }
+    printf("\n");
+    fflush(stdout);
+}
+
+static int gobench(const std::string &path, double seconds)
+{
+    std::vector<CBenchReplayRecord> records;
+    std::string error = ReadBenchReplay(path, records);
+    if (!error.empty() || records.empty())
+    {
+        fprintf(stderr, "%s\n", error.empty() ? (path + ": no headers").c_str() : error.c_str());
+        return 1;
+    }
+
+    Verushash vh;
+    vh.initialize();
+    int procs = std::max(1, (int)std::thread::hardware_concurrency());
+
+    // the Go functions and the kinds of header each hashes
+    static const struct
+    {
+        const char *name;
+        int kinds[2];
+    } functions[] = {
+        {"VerusHash", {BENCH_HASH_V1, BENCH_HASH_V1}},
+        {"VerusHash_V2B", {BENCH_HASH_V2B, BENCH_HASH_V2B}},
+        {"VerusHash_V2B1", {BENCH_HASH_V2B1, BENCH_HASH_V2B1}},
+        {"VerusHash_V2B2", {BENCH_HASH_V2B2, BENCH_HASH_V2B2_PBAAS}},
+        {"VerusHashSum", {BENCH_HASH_V1, BENCH_HASH_V1}},
+        {"VerusHashSum_V2B", {BENCH_HASH_V2B, BENCH_HASH_V2B}},
+        {"VerusHashSum_V2B1", {BENCH_HASH_V2B1, BENCH_HASH_V2B1}},
+        {"VerusHashSum_V2B2", {BENCH_HASH_V2B2, BENCH_HASH_V2B2_PBAAS}},
+    };
+
+    printf("pkg: github.com/asherda/go-verushash\n");
+    printf("kernels: %s\n", CVerusKernels::Describe().c_str());
+    for (const auto &f : functions)
+    {
+        std::vector<const CBenchHeader *> headers;
+        unsigned char out[32];
+        for (const CBenchReplayRecord &r : records)
+        {
+            if (r.header.kind == f.kinds[0] || r.header.kind == f.kinds[1])
+            {
+                BenchHashHeader(vh, r.header, out);
+                check(r, out, f.name);
+                headers.push_back(&r.header);
+            }
+        }
+        if (headers.empty())
+        {
+            continue;
+        }
+
+        auto op = [&](Verushash &vh, uint64_t i) {
+            unsigned char out[32];
+            BenchHashHeader(vh, *headers[i % headers.size()], out);
+        };
+        size_t bytes = headers[0]->bytes.size();
+        gobench_print(std::string(f.name) + "/seq", procs, gobench_time(1, seconds, op), bytes, seconds);
+        gobench_print(std::string(f.name) + "/parallel", procs, gobench_time(procs, seconds, op), bytes, seconds);
+    }
+
+    gobench_print("ReadCounters", procs, gobench_time(1, seconds, [](Verushash &, uint64_t) {
+        uint64_t counters[VERUS_COUNTERS];
+        char kernels[256];
+        verushash_counters(counters, VERUS_COUNTERS);
+        verushash_selected_kernels(kernels, sizeof(kernels));
+    }), 0, seconds);
+    gobench_print("WritePrometheus", procs, gobench_time(1, seconds, [](Verushash &, uint64_t) {
+        std::vector<char> text(verushash_prometheus(NULL, 0) + 1);
+        verushash_prometheus(text.data(), text.size());
+    }), 0, seconds);
+    return mismatches ? 1 : 0;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc >= 3 && !strcmp(argv[1], "generate"))
+    {
+        size_t count = argc > 3 ? strtoul(argv[3], NULL, 10) : 10000;
+        uint64_t seed = argc > 4 ? strtoull(argv[4], NULL, 0) : 0x5645525553ULL;
+        if (count >= 1)
+        {
+            return generate(argv[2], count, seed);
+        }
+    }
+    else if (argc >= 3 && !strcmp(argv[1], "run"))
+    {
+        int passes = argc > 3 ? atoi(argv[3]) : 3;
+        int threads = argc > 4 ? atoi(argv[4]) : std::max(1, (int)std::thread::hardware_concurrency());
+        if (passes >= 1 && threads >= 1)
+        {
+            return run(argv[2], passes, threads);
+        }
+    }
+    else if (argc >= 3 && !strcmp(argv[1], "gobench"))
+    {
+        double seconds = argc > 3 ? atof(argv[3]) : 1;
+        if (seconds > 0)
+        {
+            return gobench(argv[2], seconds);
+        }
+    }
+    fprintf(stderr, "usage: %s generate <file> [headers [seed]]\n       %s run <file> [passes [threads]]\n"
+                    "       %s gobench <file> [seconds]\n", argv[0], argv[0], argv[0]);
+    return 1;
+}
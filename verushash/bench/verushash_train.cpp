@@ -0,0 +1,105 @@
+// (C) 2018 The Verus Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+/*
+Training workload for the profile guided build, also used to time it against the plain
+build. It runs the bench_corpus.h header mix through the same Verushash entry points the
+Go binding calls, and prints the best time per hash of each kind and overall, plus a
+digest of every output so the two builds can be checked for identical results.
+
+    verushash_train [passes [headers]]
+
+The "pgo" target in CMakeLists.txt drives it, see the README.
+*/
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "verushash.h"
+#include "bench/bench_corpus.h"
+#include "crypto/sha256.h"
+#include "crypto/verus_hash.h"
+
+int main(int argc, char **argv)
+{
+    int passes = argc > 1 ? atoi(argv[1]) : 10;
+    size_t count = argc > 2 ? strtoul(argv[2], NULL, 10) : 2000;
+
+    if (passes < 1 || count < 1)
+    {
+        fprintf(stderr, "usage: %s [passes [headers]]\n", argv[0]);
+        return 1;
+    }
+
+    Verushash vh;
+    vh.initialize();
+
+    std::vector<CBenchHeader> corpus = MakeBenchCorpus(count);
+    size_t kindCount[BENCH_HASH_KINDS] = {0};
+    double bestKind[BENCH_HASH_KINDS], bestTotal = 0;
+    unsigned char digest[CSHA256::OUTPUT_SIZE];
+
+    for (int kind = 0; kind < BENCH_HASH_KINDS; kind++)
+    {
+        bestKind[kind] = 0;
+    }
+    for (size_t i = 0; i < corpus.size(); i++)
+    {
+        kindCount[corpus[i].kind]++;
+    }
+
+    for (int pass = 0; pass < passes; pass++)
+    {
+        double kindNs[BENCH_HASH_KINDS] = {0}, totalNs = 0;
+        CSHA256 outputs;
+
+        for (size_t i = 0; i < corpus.size(); i++)
+        {
+            unsigned char out[32];
+            auto start = std::chrono::steady_clock::now();
+            BenchHashHeader(vh, corpus[i], out);
+            auto end = std::chrono::steady_clock::now();
+            double ns = std::chrono::duration<double, std::nano>(end - start).count();
+            kindNs[corpus[i].kind] += ns;
+            totalNs += ns;
+            if (pass == 0)
+            {
+                outputs.Write(out, sizeof(out));
+            }
+        }
+        if (pass == 0)
+        {
+            outputs.Finalize(digest);
+        }
+
+        for (int kind = 0; kind < BENCH_HASH_KINDS; kind++)
+        {
+            if (kindCount[kind] && (pass == 0 || kindNs[kind] / kindCount[kind] < bestKind[kind]))
+            {
+                bestKind[kind] = kindNs[kind] / kindCount[kind];
+            }
+        }
+        if (pass == 0 || totalNs / corpus.size() < bestTotal)
+        {
+            bestTotal = totalNs / corpus.size();
+        }
+    }
+
+    printf("kernels %s\n", CVerusKernels::Describe().c_str());
+    printf("headers %zu passes %d\n", corpus.size(), passes);
+    for (int kind = 0; kind < BENCH_HASH_KINDS; kind++)
+    {
+        printf("%-12s %6zu headers %10.1f ns/hash\n", BenchHashKindName(kind), kindCount[kind], bestKind[kind]);
+    }
+    printf("total_ns_per_hash %.0f\n", bestTotal);
+    printf("digest ");
+    for (size_t i = 0; i < sizeof(digest); i++)
+    {
+        printf("%02x", digest[i]);
+    }
+    printf("\n");
+    return 0;
+}
@@ -0,0 +1,550 @@
+// (C) 2018 The Verus Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+/*
+Differential check of every kernel variant and API path this CPU runs against the portable
+reference, haraka=port, clhash=port and sha256=generic:
+
+    verushash_verify [--quick] [--inputs n] [--seed n]
+
+    primitive   each Haraka function of each kernel, including the four and eight lane and the
+                chaining ones, each CLHash version's result and the key it leaves mutated,
+                the four lane CLHash, and SHA-256, on random inputs
+    hash        V1, V2, V2b, V2b1 and V2b2 of random inputs of many lengths, for every pair of
+                Haraka and CLHash kernels, through the one-shot Hash and HashAligned, streaming
+                Write in random pieces, CVerusFileHasher, the Extra midstate calls that vary
+                the last 32 bytes after Write, and CVerusHash::HashBatch at every width. Extra
+                results are not compared after a whole number of blocks, as they depend on how
+                the input was written in the reference code too
+    header      the bench_corpus.h header mix through the C API entry points the Go binding
+                calls, one at a time and packed through verushash_batch on four threads, for
+                every pair of kernels
+    release     V2b, V2b1 and V2b2 hashes of short and block inputs and of headers, before and
+                after verushash_release_idle_keys frees the thread's key
+
+It prints the number of checks and the first mismatches, and exits with 1 if there are any.
+*/
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "verushash.h"
+#include "bench/bench_corpus.h"
+#include "crypto/sha256.h"
+#include "crypto/verus_hash.h"
+#include "crypto/verus_hash_file.h"
+
+static const char *REFERENCE = "haraka=port,clhash=port,sha256=generic";
+
+static size_t checks = 0, mismatches = 0;
+
+static void check(const void *expected, const void *actual, size_t len, const std::string &what)
+{
+    checks++;
+    if (memcmp(expected, actual, len))
+    {
+        if (mismatches++ < 20)
+        {
+            fprintf(stderr, "mismatch: %s\n", what.c_str());
+        }
+    }
+}
+
+static std::string describe(const std::string &path, size_t len)
+{
+    return std::string(path) + " " + std::to_string(len) + " bytes, " + CVerusKernels::Describe();
+}
+
+// every kernel of a type that this CPU runs, skipping a name seen before
+static std::vector<const CVerusKernel *> supported(VerusKernelType type)
+{
+    std::vector<const CVerusKernel *> kernels;
+    for (size_t i = 0; i < CVerusKernels::Count(type); i++)
+    {
+        const CVerusKernel *pk = CVerusKernels::Get(type, i);
+        bool seen = false;
+        for (const CVerusKernel *other : kernels)
+        {
+            seen = seen || !strcmp(other->name, pk->name);
+        }
+        if (CVerusKernels::IsSupported(pk) && !seen)
+        {
+            kernels.push_back(pk);
+        }
+    }
+    return kernels;
+}
+
+static const CVerusKernel *named(VerusKernelType type, const char *name)
+{
+    for (size_t i = 0; i < CVerusKernels::Count(type); i++)
+    {
+        if (!strcmp(CVerusKernels::Get(type, i)->name, name))
+        {
+            return CVerusKernels::Get(type, i);
+        }
+    }
+    return NULL;
+}
+
+static void verify_haraka(CBenchRandom &rnd, int inputs)
+{
+    const CVerusHarakaKernel *ref = (const CVerusHarakaKernel *)named(VERUS_KERNEL_HARAKA, "port");
+    alignas(32) unsigned char in[8 * 64], key[40 * 16], expected[8 * 32], actual[8 * 32], joined[64];
+
+    for (const CVerusKernel *k : supported(VERUS_KERNEL_HARAKA))
+    {
+        const CVerusHarakaKernel *pk = (const CVerusHarakaKernel *)k;
+        std::string kernel = std::string(" haraka=") + pk->name;
+        for (int i = 0; i < inputs; i++)
+        {
+            rnd.Fill(in, sizeof(in));
+            rnd.Fill(key, sizeof(key));
+
+            (*ref->haraka256)(expected, in);
+            (*pk->haraka256)(actual, in);
+            check(expected, actual, 32, "haraka256" + kernel);
+            (*ref->haraka512)(expected, in);
+            (*pk->haraka512)(actual, in);
+            check(expected, actual, 32, "haraka512" + kernel);
+            (*ref->haraka512Zero)(expected, in);
+            (*pk->haraka512Zero)(actual, in);
+            check(expected, actual, 32, "haraka512_zero" + kernel);
+            (*ref->haraka512Keyed)(expected, in, (const u128 *)key);
+            (*pk->haraka512Keyed)(actual, in, (const u128 *)key);
+            check(expected, actual, 32, "haraka512_keyed" + kernel);
+
+            for (int lane = 0; lane < 8; lane++)
+            {
+                (*ref->haraka512Zero)(expected + lane * 32, in + lane * 64);
+            }
+            (*pk->haraka512Zero4x)(actual, in);
+            check(expected, actual, 4 * 32, "haraka512_zero x4" + kernel);
+            (*pk->haraka512Zero8x)(actual, in);
+            check(expected, actual, 8 * 32, "haraka512_zero x8" + kernel);
+
+            // the chaining value and block from separate places, as the one-shot Hash reads them
+            memcpy(joined, in + 64, 32);
+            memcpy(joined + 32, in + 160, 32);
+            (*ref->haraka512)(expected, joined);
+            (*pk->haraka512Chain)(actual, in + 64, in + 160);
+            check(expected, actual, 32, "haraka512 chain" + kernel);
+            (*ref->haraka512Zero)(expected, joined);
+            (*pk->haraka512ZeroChain)(actual, in + 64, in + 160);
+            check(expected, actual, 32, "haraka512_zero chain" + kernel);
+        }
+    }
+}
+
+static void verify_clhash(CBenchRandom &rnd, int inputs)
+{
+    static const char *versionNames[VERUS_CLHASH_VERSIONS] = {"clhash_v2", "clhash_v2_1", "clhash_v2_2"};
+    const CVerusCLHashKernel *ref = (const CVerusCLHashKernel *)named(VERUS_KERNEL_CLHASH, "port");
+    const uint64_t keySize = (VERUSKEYSIZE >> 5) << 5;
+    const uint64_t keyMask = verusclhasher::keymask(keySize);
+
+    // each lane's key as generated, and the reference's and the kernel's copies that CLHash mutates
+    std::vector<unsigned char *> seeds, refKeys, keys;
+    __m128i **scratch[4];
+    alignas(32) unsigned char buf[4][64];
+    for (int lane = 0; lane < 4; lane++)
+    {
+        seeds.push_back((unsigned char *)alloc_aligned_buffer(keySize));
+        refKeys.push_back((unsigned char *)alloc_aligned_buffer(keySize));
+        keys.push_back((unsigned char *)alloc_aligned_buffer(keySize));
+        scratch[lane] = (__m128i **)alloc_aligned_buffer(65 * sizeof(__m128i *));
+    }
+
+    for (const CVerusKernel *k : supported(VERUS_KERNEL_CLHASH))
+    {
+        const CVerusCLHashKernel *pk = (const CVerusCLHashKernel *)k;
+        std::string kernel = std::string(" clhash=") + pk->name;
+        for (int i = 0; i < inputs; i++)
+        {
+            for (int lane = 0; lane < 4; lane++)
+            {
+                rnd.Fill(seeds[lane], keySize);
+                rnd.Fill(buf[lane], 64);
+            }
+
+            for (int version = 0; version < VERUS_CLHASH_VERSIONS; version++)
+            {
+                memcpy(refKeys[0], seeds[0], keySize);
+                memcpy(keys[0], seeds[0], keySize);
+                uint64_t expected = (*ref->clhash[version])(refKeys[0], buf[0], keyMask, scratch[0]);
+                uint64_t actual = (*pk->clhash[version])(keys[0], buf[0], keyMask, scratch[0]);
+                check(&expected, &actual, 8, versionNames[version] + kernel);
+                check(refKeys[0], keys[0], keySize, std::string(versionNames[version]) + " mutated key" + kernel);
+            }
+
+            uint64_t expected[4], actual[4];
+            void *lanes[4];
+            const unsigned char *bufs[4];
+            for (int lane = 0; lane < 4; lane++)
+            {
+                memcpy(refKeys[lane], seeds[lane], keySize);
+                memcpy(keys[lane], seeds[lane], keySize);
+                expected[lane] = (*ref->clhash[VERUS_CLHASH_V2_2])(refKeys[lane], buf[lane], keyMask, scratch[lane]);
+                lanes[lane] = keys[lane];
+                bufs[lane] = buf[lane];
+            }
+            (*pk->clhashV2_2x4)(lanes, bufs, keyMask, scratch, actual);
+            check(expected, actual, sizeof(expected), "clhash_v2_2 x4" + kernel);
+            for (int lane = 0; lane < 4; lane++)
+            {
+                check(refKeys[lane], keys[lane], keySize, "clhash_v2_2 x4 mutated key" + kernel);
+            }
+        }
+    }
+
+    for (int lane = 0; lane < 4; lane++)
+    {
+        free(seeds[lane]);
+        free(refKeys[lane]);
+        free(keys[lane]);
+        free(scratch[lane]);
+    }
+}
+
+static void verify_sha256(CBenchRandom &rnd, int inputs)
+{
+    std::vector<std::vector<unsigned char>> data;
+    std::vector<uint256> expected;
+    CVerusKernels::Select(REFERENCE);
+    for (int i = 0; i < inputs; i++)
+    {
+        data.push_back(std::vector<unsigned char>(rnd.Next() % 1024));
+        rnd.Fill(data.back().data(), data.back().size());
+        expected.push_back(uint256());
+        CSHA256().Write(data.back().data(), data.back().size()).Finalize(expected.back().begin());
+    }
+
+    for (const CVerusKernel *pk : supported(VERUS_KERNEL_SHA256))
+    {
+        CVerusKernels::Select(VERUS_KERNEL_SHA256, pk->name);
+        for (int i = 0; i < inputs; i++)
+        {
+            uint256 actual;
+            CSHA256().Write(data[i].data(), data[i].size()).Finalize(actual.begin());
+            check(expected[i].begin(), actual.begin(), 32, describe("sha256", data[i].size()));
+        }
+    }
+}
+
+enum {
+    HASH_V1 = 0,
+    HASH_V2 = 1,
+    HASH_V2B = 2,
+    HASH_V2B1 = 3,
+    HASH_V2B2 = 4,
+    HASH_V1_EXTRA = 5,          // Write, then the last 32 bytes replaced with ExtraI64Ptr and ExtraHash
+    HASH_V2_EXTRA = 6,
+    HASH_RESULTS = 7
+};
+
+struct CVerifyInput
+{
+    std::vector<unsigned char> data;
+    int64_t nonce;
+    uint256 expected[HASH_RESULTS];
+};
+
+static const int solutionVersions[3] = {SOLUTION_VERUSHHASH_V2, SOLUTION_VERUSHHASH_V2_1, SOLUTION_VERUSHHASH_V2_2};
+
+// every result of input through the streaming Write in pieces of at most piece bytes
+template <typename F>
+static void write_pieces(const std::vector<unsigned char> &data, CBenchRandom &rnd, F write)
+{
+    for (size_t pos = 0; pos < data.size(); )
+    {
+        size_t len = std::min(data.size() - pos, (size_t)(rnd.Next() % 97));
+        write(data.data() + pos, len);
+        pos += len;
+    }
+}
+
+// ClearExtra leaves the extra half as it is after a whole number of blocks, as miners expect, so
+// what ExtraHash returns then depends on how the input was written
+static bool extra_defined(size_t len)
+{
+    return len % 32 != 0;
+}
+
+static void hash_streaming(const CVerifyInput &input, CBenchRandom *rnd, uint256 *results)
+{
+    CVerusHash v1;
+    CVerusHashV2 v2;
+    auto writeV1 = [&](const unsigned char *p, size_t len) { v1.Write(p, len); };
+    auto writeV2 = [&](const unsigned char *p, size_t len) { v2.Write(p, len); };
+
+    v1.Reset();
+    rnd ? write_pieces(input.data, *rnd, writeV1) : writeV1(input.data.data(), input.data.size());
+    v1.Finalize(results[HASH_V1].begin());
+    v1.ClearExtra();
+    *v1.ExtraI64Ptr() = input.nonce;
+    v1.ExtraHash(results[HASH_V1_EXTRA].begin());
+
+    v2.Reset();
+    rnd ? write_pieces(input.data, *rnd, writeV2) : writeV2(input.data.data(), input.data.size());
+    v2.Finalize(results[HASH_V2].begin());
+    v2.ClearExtra();
+    *v2.ExtraI64Ptr() = input.nonce;
+    v2.ExtraHash(results[HASH_V2_EXTRA].begin());
+
+    for (int i = 0; i < 3; i++)
+    {
+        CVerusHashV2 v2b(solutionVersions[i]);
+        auto writeV2b = [&](const unsigned char *p, size_t len) { v2b.Write(p, len); };
+        v2b.Reset();
+        rnd ? write_pieces(input.data, *rnd, writeV2b) : writeV2b(input.data.data(), input.data.size());
+        v2b.Finalize2b(results[HASH_V2B + i].begin());
+    }
+}
+
+static void verify_hashes(CBenchRandom &rnd, int inputs)
+{
+    static const char *resultNames[HASH_RESULTS] = {"v1", "v2", "v2b", "v2b1", "v2b2", "v1 extra", "v2 extra"};
+    std::vector<CVerifyInput> corpus(inputs);
+
+    // lengths around every 32 byte boundary up to a few blocks, then random ones up to 8 KB
+    CVerusKernels::Select(REFERENCE);
+    for (int i = 0; i < inputs; i++)
+    {
+        size_t len = i < 200 ? i : rnd.Next() % 8192;
+        corpus[i].data.resize(len);
+        rnd.Fill(corpus[i].data.data(), len);
+        corpus[i].nonce = rnd.Next();
+        hash_streaming(corpus[i], NULL, corpus[i].expected);
+    }
+
+    for (const CVerusKernel *haraka : supported(VERUS_KERNEL_HARAKA))
+    {
+        for (const CVerusKernel *clhash : supported(VERUS_KERNEL_CLHASH))
+        {
+            CVerusKernels::Select("sha256=auto");
+            CVerusKernels::Select(VERUS_KERNEL_HARAKA, haraka->name);
+            CVerusKernels::Select(VERUS_KERNEL_CLHASH, clhash->name);
+
+            for (const CVerifyInput &input : corpus)
+            {
+                size_t len = input.data.size();
+                uint256 results[HASH_RESULTS];
+                hash_streaming(input, &rnd, results);
+                for (int r = 0; r < HASH_RESULTS; r++)
+                {
+                    if (r >= HASH_V1_EXTRA && !extra_defined(len))
+                    {
+                        continue;
+                    }
+                    check(input.expected[r].begin(), results[r].begin(), 32, describe(std::string("streaming ") + resultNames[r], len));
+                }
+
+                alignas(32) unsigned char out[32];
+                CVerusHash::Hash(out, input.data.data(), len);
+                check(input.expected[HASH_V1].begin(), out, 32, describe("CVerusHash::Hash", len));
+                CVerusHash::HashAligned(out, input.data.data(), len);
+                check(input.expected[HASH_V1].begin(), out, 32, describe("CVerusHash::HashAligned", len));
+                verus_hash(out, input.data.data(), len);
+                check(input.expected[HASH_V1].begin(), out, 32, describe("verus_hash", len));
+                CVerusHashV2::Hash(out, input.data.data(), len);
+                check(input.expected[HASH_V2].begin(), out, 32, describe("CVerusHashV2::Hash", len));
+                CVerusHashV2::HashAligned(out, input.data.data(), len);
+                check(input.expected[HASH_V2].begin(), out, 32, describe("CVerusHashV2::HashAligned", len));
+                verus_hash_v2(out, input.data.data(), len);
+                check(input.expected[HASH_V2].begin(), out, 32, describe("verus_hash_v2", len));
+
+                for (int version = 0; version < VERUS_FILE_HASH_VERSIONS; version++)
+                {
+                    CVerusFileHasher file(version);
+                    write_pieces(input.data, rnd, [&](const unsigned char *p, size_t n) { file.Write(p, n); });
+                    file.Finalize(out);
+                    check(input.expected[HASH_V1 + version].begin(), out, 32,
+                          describe(std::string("CVerusFileHasher ") + resultNames[version], len));
+                }
+            }
+
+            // batches of every width up to 70, so each lane count and the refill of finished lanes run
+            for (size_t count = 1, start = 0; count <= 70; start = (start + count) % corpus.size(), count++)
+            {
+                std::vector<const unsigned char *> data;
+                std::vector<size_t> lens;
+                std::vector<unsigned char> out(count * 32);
+                for (size_t i = 0; i < count; i++)
+                {
+                    const CVerifyInput &input = corpus[(start + i) % corpus.size()];
+                    data.push_back(input.data.data());
+                    lens.push_back(input.data.size());
+                }
+                CVerusHash::HashBatch(out.data(), data.data(), lens.data(), count);
+                for (size_t i = 0; i < count; i++)
+                {
+                    const CVerifyInput &input = corpus[(start + i) % corpus.size()];
+                    check(input.expected[HASH_V1].begin(), &out[i * 32], 32,
+                          describe("CVerusHash::HashBatch of " + std::to_string(count), input.data.size()));
+                }
+            }
+        }
+    }
+}
+
+static void verify_headers(int count, uint64_t seed)
+{
+    Verushash vh;
+    std::vector<CBenchHeader> corpus = MakeBenchCorpus(count, seed);
+    std::vector<uint256> expected(corpus.size());
+
+    CVerusKernels::Select(REFERENCE);
+    for (size_t i = 0; i < corpus.size(); i++)
+    {
+        BenchHashHeader(vh, corpus[i], expected[i].begin());
+    }
+
+    for (const CVerusKernel *haraka : supported(VERUS_KERNEL_HARAKA))
+    {
+        for (const CVerusKernel *clhash : supported(VERUS_KERNEL_CLHASH))
+        {
+            CVerusKernels::Select("sha256=auto");
+            CVerusKernels::Select(VERUS_KERNEL_HARAKA, haraka->name);
+            CVerusKernels::Select(VERUS_KERNEL_CLHASH, clhash->name);
+            for (size_t i = 0; i < corpus.size(); i++)
+            {
+                uint256 out;
+                BenchHashHeader(vh, corpus[i], out.begin());
+                check(expected[i].begin(), out.begin(), 32,
+                      describe(std::string("Verushash ") + BenchHashKindName(corpus[i].kind) + " header", corpus[i].bytes.size()));
+            }
+
+            // each version's headers packed through verushash_batch on the thread pool, the
+            // kinds are the VERUS_COUNTER_HASHES_ versions but for the two V2b2 ones
+            for (int version = VERUS_COUNTER_HASHES_V1; version <= VERUS_COUNTER_HASHES_V2B2; version++)
+            {
+                std::string packed;
+                std::vector<size_t> offsets, indexes;
+                for (size_t i = 0; i < corpus.size(); i++)
+                {
+                    if (std::min(corpus[i].kind, (int)BENCH_HASH_V2B2) == version)
+                    {
+                        offsets.push_back(packed.size());
+                        indexes.push_back(i);
+                        packed += corpus[i].bytes;
+                    }
+                }
+                std::vector<unsigned char> out(indexes.size() * 32);
+                verushash_batch(version, (const uint8_t *)packed.data(), packed.size(), offsets.data(), offsets.size(), out.data(), NULL, 4);
+                for (size_t j = 0; j < indexes.size(); j++)
+                {
+                    const CBenchHeader &header = corpus[indexes[j]];
+                    check(expected[indexes[j]].begin(), &out[j * 32], 32,
+                          describe(std::string("verushash_batch ") + BenchHashKindName(header.kind) + " header", header.bytes.size()));
+                }
+            }
+        }
+    }
+}
+
+// a thread whose key was released allocates a new one on its next hash, which must be generated
+// whatever the seed, the zero one of inputs under 32 bytes included
+static void verify_release(int count, uint64_t seed)
+{
+    typedef void (*hash_fn)(const uint8_t *data, size_t len, uint8_t out[32]);
+    static const hash_fn hashes[2] = {verushash_v2b, verushash_v2b1};
+    static const char *names[2] = {"verushash_v2b", "verushash_v2b1"};
+    std::vector<CBenchHeader> corpus = MakeBenchCorpus(count, seed);
+    std::vector<unsigned char> data(256);
+    std::vector<uint256> before;
+
+    for (size_t i = 0; i < data.size(); i++)
+    {
+        data[i] = (unsigned char)(i * 7 + 1);
+    }
+    for (int round = 0; round < 2; round++)
+    {
+        size_t n = 0;
+        if (round)
+        {
+            verushash_release_idle_keys(0);
+        }
+        for (size_t len : {(size_t)0, (size_t)16, (size_t)31, (size_t)32, (size_t)100, data.size()})
+        {
+            for (int i = 0; i < 2; i++, n++)
+            {
+                uint256 out;
+                (*hashes[i])(data.data(), len, out.begin());
+                if (!round)
+                {
+                    before.push_back(out);
+                }
+                else
+                {
+                    // after the release both the first hash, on the new key, and the later ones
+                    check(before[n].begin(), out.begin(), 32, describe(std::string(names[i]) + " after a key release", len));
+                }
+            }
+        }
+        for (const CBenchHeader &header : corpus)
+        {
+            if (header.kind >= BENCH_HASH_V2B2)
+            {
+                uint256 out;
+                verushash_v2b2((const uint8_t *)header.bytes.data(), header.bytes.size(), out.begin());
+                if (!round)
+                {
+                    before.push_back(out);
+                }
+                else
+                {
+                    check(before[n].begin(), out.begin(), 32, describe("verushash_v2b2 after a key release", header.bytes.size()));
+                }
+                n++;
+            }
+        }
+    }
+}
+
+int main(int argc, char **argv)
+{
+    int inputs = 400;
+    uint64_t seed = 1;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (!strcmp(argv[i], "--quick"))
+        {
+            inputs = 220;
+        }
+        else if (!strcmp(argv[i], "--inputs") && i + 1 < argc && atoi(argv[i + 1]) > 0)
+        {
+            inputs = atoi(argv[++i]);
+        }
+        else if (!strcmp(argv[i], "--seed") && i + 1 < argc)
+        {
+            seed = strtoull(argv[++i], NULL, 0);
+        }
+        else
+        {
+            fprintf(stderr, "usage: %s [--quick] [--inputs n] [--seed n]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    Verushash vh;
+    vh.initialize();
+    fprintf(stderr, "%s\n", CVerusKernels::Describe().c_str());
+
+    CBenchRandom rnd(seed);
+    verify_haraka(rnd, inputs);
+    verify_clhash(rnd, inputs / 4);
+    verify_sha256(rnd, inputs);
+    verify_hashes(rnd, inputs);
+    verify_headers(inputs, seed);
+    CVerusKernels::Select("haraka=auto,clhash=auto,sha256=auto");
+    verify_release(inputs / 10, seed);
+
+    printf("%zu checks, %zu mismatches\n", checks, mismatches);
+    return mismatches ? 1 : 0;
+}
@@ -77,14 +77,17 @@ uint256 CBlockHeader::GetVerusV2Hash() const
             int pbaasType = CConstVerusSolutionVector::HasPBaaSHeader(nSolution);
             bool debugPrint = false;
 
+            VERUS_STAGE_START(timer);
             if (pbaasType != 0 && CheckNonCanonicalData())
             {
                 CBlockHeader bh = CBlockHeader(*this);
                 bh.ClearNonCanonicalData();
+                VERUS_STAGE_END(VERUS_STAGE_PBAAS_CHECK, timer);
                 return SerializeVerusHashV2b(bh, solutionVersion);
             }
             else
             {
+                VERUS_STAGE_END(VERUS_STAGE_PBAAS_CHECK, timer);
                 return SerializeVerusHashV2b(*this, solutionVersion);
             }
         }
@@ -0,0 +1,108 @@
+package VH
+
+/*
+#include <stdint.h>
+#include "crypto/verus_counters.h"
+#include "crypto/verus_latency.h"
+#include "crypto/verus_memory.h"
+*/
+import "C"
+
+import "unsafe"
+
+// the indexes of ReadCounters, the VERUS_COUNTER_ values in crypto/verus_counters.h
+const (
+	CounterHashesV1       = C.VERUS_COUNTER_HASHES_V1
+	CounterHashesV2       = C.VERUS_COUNTER_HASHES_V2
+	CounterHashesV2B      = C.VERUS_COUNTER_HASHES_V2B
+	CounterHashesV2B1     = C.VERUS_COUNTER_HASHES_V2B1
+	CounterHashesV2B2     = C.VERUS_COUNTER_HASHES_V2B2
+	CounterBytes          = C.VERUS_COUNTER_BYTES
+	CounterKeyGenerations = C.VERUS_COUNTER_KEY_GENERATIONS
+	CounterKeyRestores    = C.VERUS_COUNTER_KEY_RESTORES
+	CounterKeyAllocations = C.VERUS_COUNTER_KEY_ALLOCATIONS
+	CounterKeyFrees       = C.VERUS_COUNTER_KEY_FREES
+	CounterParseFailures  = C.VERUS_COUNTER_PARSE_FAILURES
+	CounterKeyReleases    = C.VERUS_COUNTER_KEY_RELEASES
+	Counters              = C.VERUS_COUNTERS
+)
+
+// the kinds and fields of ReadMemory, the VERUS_MEMORY_ values in crypto/verus_memory.h
+const (
+	MemoryKeys           = C.VERUS_MEMORY_KEYS
+	MemoryKeyDescriptors = C.VERUS_MEMORY_KEY_DESCRIPTORS
+	MemoryReadBuffers    = C.VERUS_MEMORY_READ_BUFFERS
+	MemoryThreadCounters = C.VERUS_MEMORY_THREAD_COUNTERS
+	MemoryKinds          = C.VERUS_MEMORY_KINDS
+
+	MemoryLive        = C.VERUS_MEMORY_LIVE
+	MemoryBytes       = C.VERUS_MEMORY_BYTES
+	MemoryPeakBytes   = C.VERUS_MEMORY_PEAK_BYTES
+	MemoryAllocations = C.VERUS_MEMORY_ALLOCATIONS
+	MemoryFrees       = C.VERUS_MEMORY_FREES
+	MemoryFields      = C.VERUS_MEMORY_FIELDS
+)
+
+// ReadCounters returns the library's runtime counters, totalled over all threads, indexed by
+// the Counter constants
+func ReadCounters() []uint64 {
+	values := make([]uint64, Counters)
+	C.verushash_counters((*C.uint64_t)(unsafe.Pointer(&values[0])), C.int(len(values)))
+	return values
+}
+
+// CounterName returns the name of a counter, such as "hashes_v2b2", or "" for an unknown one
+func CounterName(counter int) string {
+	name := C.verushash_counter_name(C.int(counter))
+	if name == nil {
+		return ""
+	}
+	return C.GoString(name)
+}
+
+// SelectedKernels returns the kernels hashes run with, as "haraka=<name>,clhash=<name>,sha256=<name>"
+func SelectedKernels() string {
+	var buf [256]C.char
+	n := C.verushash_selected_kernels(&buf[0], C.int(len(buf)))
+	if int(n) >= len(buf) {
+		return ""
+	}
+	return C.GoStringN(&buf[0], n)
+}
+
+// PrometheusText returns the latency histograms and runtime counters in Prometheus text
+// exposition format, see crypto/verus_latency.h
+func PrometheusText() string {
+	n := C.verushash_prometheus(nil, 0)
+	for {
+		buf := make([]byte, int(n)+1)
+		m := C.verushash_prometheus((*C.char)(unsafe.Pointer(&buf[0])), C.int(len(buf)))
+		if m < C.int(len(buf)) {
+			return string(buf[:m])
+		}
+		n = m
+	}
+}
+
+// ReadMemory returns what the library holds, indexed as kind*MemoryFields + field with the
+// Memory constants
+func ReadMemory() []uint64 {
+	values := make([]uint64, MemoryKinds*MemoryFields)
+	C.verushash_memory((*C.uint64_t)(unsafe.Pointer(&values[0])), C.int(len(values)))
+	return values
+}
+
+// MemoryKindName returns the name of a memory kind, such as "keys", or "" for an unknown one
+func MemoryKindName(kind int) string {
+	name := C.verushash_memory_kind_name(C.int(kind))
+	if name == nil {
+		return ""
+	}
+	return C.GoString(name)
+}
+
+// ReleaseIdleKeys frees the keys of threads that have not hashed for idleMs milliseconds and
+// returns how many it freed
+func ReleaseIdleKeys(idleMs uint64) int {
+	return int(C.verushash_release_idle_keys(C.uint64_t(idleMs)))
+}
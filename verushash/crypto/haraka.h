@@ -37,9 +37,63 @@ typedef unsigned long u64;
 #endif
 typedef __m128i u128;
 
-extern u128 rc[40];
+/*
+Round constants, as the _mm_set_epi32() values of the reference code split into the low and
+high 64 bits. They are compile time constants rather than tables filled in at startup, so
+the compiler can fold them into the aesenc memory operands or keep them in registers, and
+there is nothing to initialize. The AES2/AES4 macros below use whatever is named rc at the
+point of use, so the keyed functions pass their own table by declaring a local rc.
+*/
+#define HARAKA_RC(lo, hi) {(long long)(lo), (long long)(hi)}
+
+static const u128 rc[40] __attribute__((aligned(64), unused)) = {
+  HARAKA_RC(0xb2c5fef075817b9dULL, 0x0684704ce620c00aULL),
+  HARAKA_RC(0x640f6ba42f08f717ULL, 0x8b66b4e188f3a06bULL),
+  HARAKA_RC(0xcf029d609f029114ULL, 0x3402de2d53f28498ULL),
+  HARAKA_RC(0xbbf3bcaffd5b4f79ULL, 0x0ed6eae62e7b4f08ULL),
+  HARAKA_RC(0x79eecd1cbe397044ULL, 0xcbcfb0cb4872448bULL),
+  HARAKA_RC(0x8d5335ed2b8a057bULL, 0x7eeacdee6e9032b7ULL),
+  HARAKA_RC(0xe2412761da4fef1bULL, 0x67c28f435e2e7cd0ULL),
+  HARAKA_RC(0x675ffde21fc70b3bULL, 0x2924d9b0afcacc07ULL),
+  HARAKA_RC(0xecdb8fcab9d465eeULL, 0xab4d63f1e6867fe9ULL),
+  HARAKA_RC(0x5b2a404fad037e33ULL, 0x1c30bf84d4b7cd64ULL),
+  HARAKA_RC(0x69028b2e8df69800ULL, 0xb2cc0bb9941723bfULL),
+  HARAKA_RC(0x4aaa9ec85c9d2d8aULL, 0xfa0478a6de6f5572ULL),
+  HARAKA_RC(0x0efa4f2e29129fd4ULL, 0xdfb49f2b6b772a12ULL),
+  HARAKA_RC(0x32d611aebb6a12eeULL, 0x1ea10344f449a236ULL),
+  HARAKA_RC(0x5f9600c99ca8eca6ULL, 0xaf0449884b050084ULL),
+  HARAKA_RC(0x78a2c7e327e593ecULL, 0x21025ed89d199c4fULL),
+  HARAKA_RC(0xb9282ecd82d40173ULL, 0xbf3aaaf8a759c9b7ULL),
+  HARAKA_RC(0x37f2efd910307d6bULL, 0x6260700d6186b017ULL),
+  HARAKA_RC(0x81c29153f6fc9ac6ULL, 0x5aca45c221300443ULL),
+  HARAKA_RC(0x2caf92e836d1943aULL, 0x9223973c226b68bbULL),
+  HARAKA_RC(0x6cbab958e51071b4ULL, 0xd3bf9238225886ebULL),
+  HARAKA_RC(0x933dfddd24e1128dULL, 0xdb863ce5aef0c677ULL),
+  HARAKA_RC(0x83e48de3cb2212b1ULL, 0xbb606268ffeba09cULL),
+  HARAKA_RC(0x2db91a4ec72bf77dULL, 0x734bd3dce2e4d19cULL),
+  HARAKA_RC(0x4b1415c42cb3924eULL, 0x43bb47c361301b43ULL),
+  HARAKA_RC(0x03b231dd16eb6899ULL, 0xdba775a8e707eff6ULL),
+  HARAKA_RC(0x8e5e23027eca472cULL, 0x6df3614b3c755977ULL),
+  HARAKA_RC(0x6d1be5b9b88617f9ULL, 0xcda75a17d6de7d77ULL),
+  HARAKA_RC(0x9d6c069da946ee5dULL, 0xec6b43f06ba8e9aaULL),
+  HARAKA_RC(0xa25311593bf327c1ULL, 0xcb1e6950f957332bULL),
+  HARAKA_RC(0xe4ed0353600ed0d9ULL, 0x2cee0c7500da619cULL),
+  HARAKA_RC(0x80bbbabc63a4a350ULL, 0xf0b1a5a196e90cabULL),
+  HARAKA_RC(0xab0dde30938dca39ULL, 0xae3db1025e962988ULL),
+  HARAKA_RC(0x8814f3a82e75b442ULL, 0x17bb8f38d554a40bULL),
+  HARAKA_RC(0xaeb6b779360a16f6ULL, 0x34bb8a5b5f427fd7ULL),
+  HARAKA_RC(0x43ce5918ffbaafdeULL, 0x26f65241cbe55438ULL),
+  HARAKA_RC(0xa2ca9cf7839ec978ULL, 0x4ce99a54b9f3026aULL),
+  HARAKA_RC(0x40c06e2822901235ULL, 0xae51a51a1bdff7beULL),
+  HARAKA_RC(0xc173bc0f48a659cfULL, 0xa0c1613cba7ed22bULL),
+  HARAKA_RC(0x4ad6bdfde9c59da1ULL, 0x756acc0302288288ULL)
+};
+
+// all zero, for haraka512_zero
+static const u128 rc0[40] __attribute__((aligned(64), unused)) = {{0, 0}};
 
 #define LOAD(src) _mm_load_si128((u128 *)(src))
+#define LOADU(src) _mm_loadu_si128((const u128 *)(src))
 #define STORE(dest,src) _mm_storeu_si128((u128 *)(dest),src)
 
 #define AES2(s0, s1, rci) \
@@ -78,6 +132,12 @@ extern u128 rc[40];
   s2 = _mm_aesenc_si128(s2, rc0[rci + 6]); \
   s3 = _mm_aesenc_si128(s3, rc0[rci + 7]); \
 
+#define AES4_zero_4x(s0, s1, s2, s3, rci) \
+  AES4_zero(s0[0], s0[1], s0[2], s0[3], rci); \
+  AES4_zero(s1[0], s1[1], s1[2], s1[3], rci); \
+  AES4_zero(s2[0], s2[1], s2[2], s2[3], rci); \
+  AES4_zero(s3[0], s3[1], s3[2], s3[3], rci);
+
 #define AES4_4x(s0, s1, s2, s3, rci) \
   AES4(s0[0], s0[1], s0[2], s0[3], rci); \
   AES4(s1[0], s1[1], s1[2], s1[3], rci); \
@@ -109,10 +169,13 @@ extern u128 rc[40];
   *(u64*)(out + 16) = *(((u64*)&(s2) + 0)); \
   *(u64*)(out + 24) = *(((u64*)&(s3) + 0));
 
-void load_constants();
-void test_implementations();
+// the same 32 bytes as TRUNCSTORE, in two 16 byte stores, so that the next call in a chain can
+// load them back without a store forwarding stall
+#define CHAINSTORE(out, s0, s1, s2, s3) \
+  _mm_store_si128((u128 *)(out), _mm_unpackhi_epi64(s0, s1)); \
+  _mm_store_si128((u128 *)(out + 16), _mm_unpacklo_epi64(s2, s3));
 
-void load_constants();
+void test_implementations();
 
 void haraka256(unsigned char *out, const unsigned char *in);
 void haraka256_keyed(unsigned char *out, const unsigned char *in, const u128 *rc);
@@ -122,7 +185,15 @@ void haraka256_8x(unsigned char *out, const unsigned char *in);
 void haraka512(unsigned char *out, const unsigned char *in);
 void haraka512_zero(unsigned char *out, const unsigned char *in);
 void haraka512_keyed(unsigned char *out, const unsigned char *in, const u128 *rc);
+void haraka512_chain(unsigned char *out, const unsigned char *cv, const unsigned char *block);
+void haraka512_zero_chain(unsigned char *out, const unsigned char *cv, const unsigned char *block);
 void haraka512_4x(unsigned char *out, const unsigned char *in);
 void haraka512_8x(unsigned char *out, const unsigned char *in);
+void haraka512_zero_4x(unsigned char *out, const unsigned char *in);
+void haraka512_zero_8x(unsigned char *out, const unsigned char *in);
+
+// haraka_vaes.c, only built and registered when the compiler supports AVX-512 and VAES
+void haraka512_zero_4x_vaes(unsigned char *out, const unsigned char *in);
+void haraka512_zero_8x_vaes(unsigned char *out, const unsigned char *in);
 
 #endif
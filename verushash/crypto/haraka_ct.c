@@ -0,0 +1,583 @@
+/*
+Constant-time, bitsliced C implementation of the Haraka256 and Haraka512
+permutations.
+
+The bitsliced AES round (S-box circuit, ShiftRows, MixColumns and the
+interleave/orthogonalization helpers) follows BearSSL's aes_ct64 by
+Thomas Pornin, MIT license. Four AES blocks are held in eight 64-bit words,
+word i holding bit i of every byte of all four blocks.
+
+Unlike the byte-wise implementation in haraka_portable.c, the state stays in
+bitsliced form for the whole permutation. The Haraka MIX steps only move
+32-bit words around, which in this layout is the same fixed bit permutation
+of every one of the eight words.
+*/
+#include <stdint.h>
+#include <string.h>
+
+#include "haraka_ct.h"
+
+static inline uint32_t dec32le(const unsigned char *src)
+{
+    return (uint32_t)src[0]
+        | ((uint32_t)src[1] << 8)
+        | ((uint32_t)src[2] << 16)
+        | ((uint32_t)src[3] << 24);
+}
+
+static inline void enc32le(unsigned char *dst, uint32_t x)
+{
+    dst[0] = (unsigned char)x;
+    dst[1] = (unsigned char)(x >> 8);
+    dst[2] = (unsigned char)(x >> 16);
+    dst[3] = (unsigned char)(x >> 24);
+}
+
+/*
+Bitsliced forms of the round constants in haraka_portable.c, as loaded by
+ct_load_key(): haraka512_ct_rc[k] holds constants 4k..4k+3 for AES round k,
+haraka256_ct_rc[k] holds constants 2k and 2k+1 in the first two blocks.
+*/
+static const uint64_t haraka512_ct_rc[10][8] = {
+    {0x24cf0ab9086f628b, 0xbdd6eeecc83b8382, 0xd96fb0306cdad0a7, 0xaace082ac8f95f89,
+     0x449d8e8870d7041f, 0x49bb2f80b2b3e2f8, 0x0569ae98d93bb258, 0x23dc9691e7d6a4b1},
+    {0xd8ba10ede0fe5b6e, 0x7ecf7dbe424c7b8e, 0x6ea9949c6df62a31, 0xbf3f3c97ec9c313e,
+     0x241d03a196a1861e, 0xead3a51116e5a2ea, 0x77d479fcad9574e3, 0x18657a1af894b7a0},
+    {0x10671e1a7f595522, 0xd9a00ff675d28c7b, 0x2f1edf0d2b9ba661, 0xb8ff58b8e3de45f9,
+     0xee29261da9865c02, 0xd1532aa4b50bdf43, 0x8bf858159b231bb1, 0xdf17439d22d4f599},
+    {0xdd4b2f0870b918c0, 0x757a81f3b39b1bb6, 0x7a5c556898952e3f, 0x7dd70a16d915d87a,
+     0x3ae61971982b8301, 0xc3ab319e030412be, 0x17c0033ac094a8cb, 0x5a0630fc1a8dc4ef},
+    {0x17708988c1632f73, 0xf92ddae090b44f4f, 0x11ac0285c43aa314, 0x509059941936b8ba,
+     0xd03e152fa2ce9b69, 0x3fbcbcb63a32998b, 0x6204696d692254f7, 0x915542ed93ec59b4},
+    {0xf4ed94aa8879236e, 0xff6cb41cd38e03c0, 0x069b38602368aeab, 0x669495b820f0ddba,
+     0xf42013b1b8bf9e3d, 0xcf935efe6439734d, 0xbc1dcf42ca29e3f8, 0x7e6d3ed29f78ad67},
+    {0xf3b0f6837ffcddaa, 0x3a76faef934ddf41, 0xcec7ae583a9c8e35, 0xe4dd18c68f0260af,
+     0x2c0e5df1ad398eaa, 0x478df5236ae22e8c, 0xfb944c46fe865f39, 0xaa48f82f028132ba},
+    {0x231b9ae2b76aca77, 0x292a76a712db0b40, 0x5850625dc8134491, 0x73137dd469810fb5,
+     0x8a12a6a202a474fd, 0xd36fd9daa78bdb80, 0xb34c5e733505706f, 0xbaf1cdca818d9d96},
+    {0x2e99781335e8c641, 0xbddfe5cce47d560e, 0xf74e9bf32e5e040c, 0x1d7a709d65996be9,
+     0x670df36a9cf66cdd, 0xd05ef84a176a2875, 0x0f888e828cb1c44e, 0x1a79e9c9727b052c},
+    {0x83497348628d84de, 0x2e9387d51f22a754, 0xb000068da2f852d6, 0x378c9e1190fd6fe5,
+     0x870027c316de7293, 0xe51a9d4462e047bb, 0x90ecf7f8c6251195, 0x655953bfbed90a9c}
+};
+
+static const uint64_t haraka256_ct_rc[10][8] = {
+    {0x2003023100232203, 0x3112222000330302, 0x1123303020121023, 0x2202002200311301,
+     0x0011020030130013, 0x0133230032332230, 0x0121221011333210, 0x2310121123122031},
+    {0x0133022202131022, 0x2331333332022020, 0x3213200013323021, 0x2233020232321322,
+     0x1123232210310103, 0x1222032020203032, 0x0112232232022012, 0x0033212031312120},
+    {0x1032102120321322, 0x3203313202003302, 0x2221101021322231, 0x3333301320103132,
+     0x2011032112210212, 0x2213211112212222, 0x3310313021113023, 0x1021321230103320},
+    {0x3222003330331213, 0x1333132310131223, 0x1322212313310200, 0x2303032133230003,
+     0x0103002021202103, 0x3230210001312032, 0x1131123323211130, 0x0211120232212120},
+    {0x1023121233111122, 0x1120033231120033, 0x2312130123132221, 0x3033103023120131,
+     0x2221221121021002, 0x1113222031031303, 0x0330101113231331, 0x1313031122103111},
+    {0x0011030213121100, 0x3220033111302312, 0x0303330302222110, 0x2233122230331132,
+     0x3302010322211300, 0x3010022121023310, 0x2232120122000220, 0x3301102300313122},
+    {0x1103230030311000, 0x3132013333131332, 0x3210112010112233, 0x3113021211111032,
+     0x3222113110230301, 0x0323311203001232, 0x1300033200102003, 0x1202303012010023},
+    {0x3312030210220230, 0x1112203020220221, 0x1213111222210303, 0x1331020132013212,
+     0x0231021022022000, 0x3022002300010023, 0x0130000230212232, 0x1201003302233133},
+    {0x1330010001232333, 0x3121122010300303, 0x1120020100322310, 0x1010111011323032,
+     0x1032112322021321, 0x3330303232321103, 0x2200212121221033, 0x1111022113201130},
+    {0x0110222230100310, 0x3203323020211313, 0x0023002131022001, 0x1020122102012222,
+     0x3003010320332212, 0x0323232102002222, 0x1001121312001131, 0x2011103320331221}
+};
+
+// Boyar-Peralta S-box circuit, applied to all 64 bytes at once
+static void ct_sbox(uint64_t *q)
+{
+    uint64_t x0, x1, x2, x3, x4, x5, x6, x7;
+    uint64_t y1, y2, y3, y4, y5, y6, y7, y8, y9;
+    uint64_t y10, y11, y12, y13, y14, y15, y16, y17, y18, y19;
+    uint64_t y20, y21;
+    uint64_t z0, z1, z2, z3, z4, z5, z6, z7, z8, z9;
+    uint64_t z10, z11, z12, z13, z14, z15, z16, z17;
+    uint64_t t0, t1, t2, t3, t4, t5, t6, t7, t8, t9;
+    uint64_t t10, t11, t12, t13, t14, t15, t16, t17, t18, t19;
+    uint64_t t20, t21, t22, t23, t24, t25, t26, t27, t28, t29;
+    uint64_t t30, t31, t32, t33, t34, t35, t36, t37, t38, t39;
+    uint64_t t40, t41, t42, t43, t44, t45, t46, t47, t48, t49;
+    uint64_t t50, t51, t52, t53, t54, t55, t56, t57, t58, t59;
+    uint64_t t60, t61, t62, t63, t64, t65, t66, t67;
+    uint64_t s0, s1, s2, s3, s4, s5, s6, s7;
+
+    x0 = q[7];
+    x1 = q[6];
+    x2 = q[5];
+    x3 = q[4];
+    x4 = q[3];
+    x5 = q[2];
+    x6 = q[1];
+    x7 = q[0];
+
+    // top linear transformation
+    y14 = x3 ^ x5;
+    y13 = x0 ^ x6;
+    y9 = x0 ^ x3;
+    y8 = x0 ^ x5;
+    t0 = x1 ^ x2;
+    y1 = t0 ^ x7;
+    y4 = y1 ^ x3;
+    y12 = y13 ^ y14;
+    y2 = y1 ^ x0;
+    y5 = y1 ^ x6;
+    y3 = y5 ^ y8;
+    t1 = x4 ^ y12;
+    y15 = t1 ^ x5;
+    y20 = t1 ^ x1;
+    y6 = y15 ^ x7;
+    y10 = y15 ^ t0;
+    y11 = y20 ^ y9;
+    y7 = x7 ^ y11;
+    y17 = y10 ^ y11;
+    y19 = y10 ^ y8;
+    y16 = t0 ^ y11;
+    y21 = y13 ^ y16;
+    y18 = x0 ^ y16;
+
+    // non-linear section
+    t2 = y12 & y15;
+    t3 = y3 & y6;
+    t4 = t3 ^ t2;
+    t5 = y4 & x7;
+    t6 = t5 ^ t2;
+    t7 = y13 & y16;
+    t8 = y5 & y1;
+    t9 = t8 ^ t7;
+    t10 = y2 & y7;
+    t11 = t10 ^ t7;
+    t12 = y9 & y11;
+    t13 = y14 & y17;
+    t14 = t13 ^ t12;
+    t15 = y8 & y10;
+    t16 = t15 ^ t12;
+    t17 = t4 ^ t14;
+    t18 = t6 ^ t16;
+    t19 = t9 ^ t14;
+    t20 = t11 ^ t16;
+    t21 = t17 ^ y20;
+    t22 = t18 ^ y19;
+    t23 = t19 ^ y21;
+    t24 = t20 ^ y18;
+
+    t25 = t21 ^ t22;
+    t26 = t21 & t23;
+    t27 = t24 ^ t26;
+    t28 = t25 & t27;
+    t29 = t28 ^ t22;
+    t30 = t23 ^ t24;
+    t31 = t22 ^ t26;
+    t32 = t31 & t30;
+    t33 = t32 ^ t24;
+    t34 = t23 ^ t33;
+    t35 = t27 ^ t33;
+    t36 = t24 & t35;
+    t37 = t36 ^ t34;
+    t38 = t27 ^ t36;
+    t39 = t29 & t38;
+    t40 = t25 ^ t39;
+
+    t41 = t40 ^ t37;
+    t42 = t29 ^ t33;
+    t43 = t29 ^ t40;
+    t44 = t33 ^ t37;
+    t45 = t42 ^ t41;
+    z0 = t44 & y15;
+    z1 = t37 & y6;
+    z2 = t33 & x7;
+    z3 = t43 & y16;
+    z4 = t40 & y1;
+    z5 = t29 & y7;
+    z6 = t42 & y11;
+    z7 = t45 & y17;
+    z8 = t41 & y10;
+    z9 = t44 & y12;
+    z10 = t37 & y3;
+    z11 = t33 & y4;
+    z12 = t43 & y13;
+    z13 = t40 & y5;
+    z14 = t29 & y2;
+    z15 = t42 & y9;
+    z16 = t45 & y14;
+    z17 = t41 & y8;
+
+    // bottom linear transformation
+    t46 = z15 ^ z16;
+    t47 = z10 ^ z11;
+    t48 = z5 ^ z13;
+    t49 = z9 ^ z10;
+    t50 = z2 ^ z12;
+    t51 = z2 ^ z5;
+    t52 = z7 ^ z8;
+    t53 = z0 ^ z3;
+    t54 = z6 ^ z7;
+    t55 = z16 ^ z17;
+    t56 = z12 ^ t48;
+    t57 = t50 ^ t53;
+    t58 = z4 ^ t46;
+    t59 = z3 ^ t54;
+    t60 = t46 ^ t57;
+    t61 = z14 ^ t57;
+    t62 = t52 ^ t58;
+    t63 = t49 ^ t58;
+    t64 = z4 ^ t59;
+    t65 = t61 ^ t62;
+    t66 = z1 ^ t63;
+    s0 = t59 ^ t63;
+    s6 = t56 ^ ~t62;
+    s7 = t48 ^ ~t60;
+    t67 = t64 ^ t65;
+    s3 = t53 ^ t66;
+    s4 = t51 ^ t66;
+    s5 = t47 ^ t65;
+    s1 = t64 ^ ~s3;
+    s2 = t55 ^ ~t67;
+
+    q[7] = s0;
+    q[6] = s1;
+    q[5] = s2;
+    q[4] = s3;
+    q[3] = s4;
+    q[2] = s5;
+    q[1] = s6;
+    q[0] = s7;
+}
+
+#define CT_SWAPN(cl, ch, s, x, y) \
+    do { \
+        uint64_t a_, b_; \
+        a_ = (x); \
+        b_ = (y); \
+        (x) = (a_ & (uint64_t)(cl)) | ((b_ & (uint64_t)(cl)) << (s)); \
+        (y) = ((a_ & (uint64_t)(ch)) >> (s)) | (b_ & (uint64_t)(ch)); \
+    } while (0)
+
+#define CT_SWAP2(x, y) CT_SWAPN(0x5555555555555555, 0xAAAAAAAAAAAAAAAA, 1, x, y)
+#define CT_SWAP4(x, y) CT_SWAPN(0x3333333333333333, 0xCCCCCCCCCCCCCCCC, 2, x, y)
+#define CT_SWAP8(x, y) CT_SWAPN(0x0F0F0F0F0F0F0F0F, 0xF0F0F0F0F0F0F0F0, 4, x, y)
+
+// transposes 8x8 bit blocks across the eight words, its own inverse
+static inline void ct_ortho(uint64_t *q)
+{
+    CT_SWAP2(q[0], q[1]);
+    CT_SWAP2(q[2], q[3]);
+    CT_SWAP2(q[4], q[5]);
+    CT_SWAP2(q[6], q[7]);
+
+    CT_SWAP4(q[0], q[2]);
+    CT_SWAP4(q[1], q[3]);
+    CT_SWAP4(q[4], q[6]);
+    CT_SWAP4(q[5], q[7]);
+
+    CT_SWAP8(q[0], q[4]);
+    CT_SWAP8(q[1], q[5]);
+    CT_SWAP8(q[2], q[6]);
+    CT_SWAP8(q[3], q[7]);
+}
+
+static inline void ct_interleave_in(uint64_t *q0, uint64_t *q1, const uint32_t *w)
+{
+    uint64_t x0, x1, x2, x3;
+
+    x0 = w[0];
+    x1 = w[1];
+    x2 = w[2];
+    x3 = w[3];
+    x0 |= (x0 << 16);
+    x1 |= (x1 << 16);
+    x2 |= (x2 << 16);
+    x3 |= (x3 << 16);
+    x0 &= (uint64_t)0x0000FFFF0000FFFF;
+    x1 &= (uint64_t)0x0000FFFF0000FFFF;
+    x2 &= (uint64_t)0x0000FFFF0000FFFF;
+    x3 &= (uint64_t)0x0000FFFF0000FFFF;
+    x0 |= (x0 << 8);
+    x1 |= (x1 << 8);
+    x2 |= (x2 << 8);
+    x3 |= (x3 << 8);
+    x0 &= (uint64_t)0x00FF00FF00FF00FF;
+    x1 &= (uint64_t)0x00FF00FF00FF00FF;
+    x2 &= (uint64_t)0x00FF00FF00FF00FF;
+    x3 &= (uint64_t)0x00FF00FF00FF00FF;
+    *q0 = x0 | (x2 << 8);
+    *q1 = x1 | (x3 << 8);
+}
+
+static inline void ct_interleave_out(uint32_t *w, uint64_t q0, uint64_t q1)
+{
+    uint64_t x0, x1, x2, x3;
+
+    x0 = q0 & (uint64_t)0x00FF00FF00FF00FF;
+    x1 = q1 & (uint64_t)0x00FF00FF00FF00FF;
+    x2 = (q0 >> 8) & (uint64_t)0x00FF00FF00FF00FF;
+    x3 = (q1 >> 8) & (uint64_t)0x00FF00FF00FF00FF;
+    x0 |= (x0 >> 8);
+    x1 |= (x1 >> 8);
+    x2 |= (x2 >> 8);
+    x3 |= (x3 >> 8);
+    x0 &= (uint64_t)0x0000FFFF0000FFFF;
+    x1 &= (uint64_t)0x0000FFFF0000FFFF;
+    x2 &= (uint64_t)0x0000FFFF0000FFFF;
+    x3 &= (uint64_t)0x0000FFFF0000FFFF;
+    w[0] = (uint32_t)x0 | (uint32_t)(x0 >> 16);
+    w[1] = (uint32_t)x1 | (uint32_t)(x1 >> 16);
+    w[2] = (uint32_t)x2 | (uint32_t)(x2 >> 16);
+    w[3] = (uint32_t)x3 | (uint32_t)(x3 >> 16);
+}
+
+// loads up to four 16 byte blocks into bitsliced form, missing blocks are zero
+static inline void ct_load(uint64_t *q, const unsigned char *in, int nblocks)
+{
+    uint32_t w[16] = {0};
+    int i;
+
+    for (i = 0; i < (nblocks << 2); i++) {
+        w[i] = dec32le(in + (i << 2));
+    }
+    for (i = 0; i < 4; i++) {
+        ct_interleave_in(&q[i], &q[i + 4], w + (i << 2));
+    }
+    ct_ortho(q);
+}
+
+static inline void ct_store(uint32_t *w, uint64_t *q)
+{
+    int i;
+
+    ct_ortho(q);
+    for (i = 0; i < 4; i++) {
+        ct_interleave_out(w + (i << 2), q[i], q[i + 4]);
+    }
+}
+
+static inline void ct_shift_rows(uint64_t *q)
+{
+    int i;
+
+    for (i = 0; i < 8; i++) {
+        uint64_t x = q[i];
+        q[i] = (x & (uint64_t)0x000000000000FFFF)
+            | ((x & (uint64_t)0x00000000FFF00000) >> 4)
+            | ((x & (uint64_t)0x00000000000F0000) << 12)
+            | ((x & (uint64_t)0x0000FF0000000000) >> 8)
+            | ((x & (uint64_t)0x000000FF00000000) << 8)
+            | ((x & (uint64_t)0xF000000000000000) >> 12)
+            | ((x & (uint64_t)0x0FFF000000000000) << 4);
+    }
+}
+
+static inline uint64_t ct_rotr32(uint64_t x)
+{
+    return (x << 32) | (x >> 32);
+}
+
+static inline void ct_mix_columns(uint64_t *q)
+{
+    uint64_t q0, q1, q2, q3, q4, q5, q6, q7;
+    uint64_t r0, r1, r2, r3, r4, r5, r6, r7;
+
+    q0 = q[0];
+    q1 = q[1];
+    q2 = q[2];
+    q3 = q[3];
+    q4 = q[4];
+    q5 = q[5];
+    q6 = q[6];
+    q7 = q[7];
+    r0 = (q0 >> 16) | (q0 << 48);
+    r1 = (q1 >> 16) | (q1 << 48);
+    r2 = (q2 >> 16) | (q2 << 48);
+    r3 = (q3 >> 16) | (q3 << 48);
+    r4 = (q4 >> 16) | (q4 << 48);
+    r5 = (q5 >> 16) | (q5 << 48);
+    r6 = (q6 >> 16) | (q6 << 48);
+    r7 = (q7 >> 16) | (q7 << 48);
+
+    q[0] = q7 ^ r7 ^ r0 ^ ct_rotr32(q0 ^ r0);
+    q[1] = q0 ^ r0 ^ q7 ^ r7 ^ r1 ^ ct_rotr32(q1 ^ r1);
+    q[2] = q1 ^ r1 ^ r2 ^ ct_rotr32(q2 ^ r2);
+    q[3] = q2 ^ r2 ^ q7 ^ r7 ^ r3 ^ ct_rotr32(q3 ^ r3);
+    q[4] = q3 ^ r3 ^ q7 ^ r7 ^ r4 ^ ct_rotr32(q4 ^ r4);
+    q[5] = q4 ^ r4 ^ r5 ^ ct_rotr32(q5 ^ r5);
+    q[6] = q5 ^ r5 ^ r6 ^ ct_rotr32(q6 ^ r6);
+    q[7] = q6 ^ r6 ^ r7 ^ ct_rotr32(q7 ^ r7);
+}
+
+// one _mm_aesenc_si128 on all four blocks, sk is the bitsliced round key or NULL for zero
+static inline void ct_aesenc(uint64_t *q, const uint64_t *sk)
+{
+    int i;
+
+    ct_sbox(q);
+    ct_shift_rows(q);
+    ct_mix_columns(q);
+    if (sk) {
+        for (i = 0; i < 8; i++) {
+            q[i] ^= sk[i];
+        }
+    }
+}
+
+// MIX4 of haraka.h, as a bit permutation of the bitsliced words
+static inline void ct_mix4(uint64_t *q)
+{
+    int i;
+
+    for (i = 0; i < 8; i++) {
+        uint64_t x = q[i];
+        q[i] = ((x & (uint64_t)0x1000100010001000) >> 12)
+            | ((x & (uint64_t)0x4000400040004000) >> 10)
+            | ((x & (uint64_t)0x2100210021002100) >> 5)
+            | ((x & (uint64_t)0x0040004000400040) >> 4)
+            | ((x & (uint64_t)0x8400840084008400) >> 3)
+            | ((x & (uint64_t)0x0004000400040004) >> 1)
+            | ((x & (uint64_t)0x0210021002100210) << 2)
+            | ((x & (uint64_t)0x0080008000800080) << 3)
+            | ((x & (uint64_t)0x0800080008000800) << 4)
+            | ((x & (uint64_t)0x0001000100010001) << 5)
+            | ((x & (uint64_t)0x0008000800080008) << 6)
+            | ((x & (uint64_t)0x0020002000200020) << 9)
+            | ((x & (uint64_t)0x0002000200020002) << 12);
+    }
+}
+
+// MIX2 of haraka.h for the first two blocks, the other two are dropped
+static inline void ct_mix2(uint64_t *q)
+{
+    int i;
+
+    for (i = 0; i < 8; i++) {
+        uint64_t x = q[i];
+        q[i] = ((x & (uint64_t)0x0100010001000100) >> 7)
+            | ((x & (uint64_t)0x0200020002000200) >> 4)
+            | ((x & (uint64_t)0x1000100010001000) >> 3)
+            | (x & (uint64_t)0x2001200120012001)
+            | ((x & (uint64_t)0x0002000200020002) << 3)
+            | ((x & (uint64_t)0x0010001000100010) << 4)
+            | ((x & (uint64_t)0x0020002000200020) << 7);
+    }
+}
+
+// converts four consecutive 16 byte round constants to a bitsliced round key
+static inline void ct_load_key(uint64_t *sk, const unsigned char *rc)
+{
+    ct_load(sk, rc, 4);
+}
+
+static void haraka512_ct_perm(uint64_t *q, const unsigned char *in, const uint64_t (*sk)[8])
+{
+    int i;
+
+    ct_load(q, in, 4);
+    for (i = 0; i < 5; i++) {
+        ct_aesenc(q, sk ? sk[i << 1] : NULL);
+        ct_aesenc(q, sk ? sk[(i << 1) + 1] : NULL);
+        ct_mix4(q);
+    }
+}
+
+static void haraka512_ct_finish(unsigned char *out, const unsigned char *in, uint64_t *q)
+{
+    uint32_t w[16];
+
+    ct_store(w, q);
+
+    /* Feed-forward and truncate to words 2, 3, 6, 7, 8, 9, 12, 13 */
+    enc32le(out,      w[2] ^ dec32le(in + 8));
+    enc32le(out + 4,  w[3] ^ dec32le(in + 12));
+    enc32le(out + 8,  w[6] ^ dec32le(in + 24));
+    enc32le(out + 12, w[7] ^ dec32le(in + 28));
+    enc32le(out + 16, w[8] ^ dec32le(in + 32));
+    enc32le(out + 20, w[9] ^ dec32le(in + 36));
+    enc32le(out + 24, w[12] ^ dec32le(in + 48));
+    enc32le(out + 28, w[13] ^ dec32le(in + 52));
+}
+
+void haraka512_ct(unsigned char *out, const unsigned char *in)
+{
+    uint64_t q[8];
+
+    haraka512_ct_perm(q, in, haraka512_ct_rc);
+    haraka512_ct_finish(out, in, q);
+}
+
+void haraka512_ct_zero(unsigned char *out, const unsigned char *in)
+{
+    uint64_t q[8];
+
+    haraka512_ct_perm(q, in, NULL);
+    haraka512_ct_finish(out, in, q);
+}
+
+void haraka512_ct_keyed(unsigned char *out, const unsigned char *in, const u128 *rc)
+{
+    uint64_t q[8], sk[10][8];
+    int i;
+
+    for (i = 0; i < 10; i++) {
+        ct_load_key(sk[i], (const unsigned char *)(rc + (i << 2)));
+    }
+    haraka512_ct_perm(q, in, (const uint64_t (*)[8])sk);
+    haraka512_ct_finish(out, in, q);
+}
+
+void haraka256_ct(unsigned char *out, const unsigned char *in)
+{
+    uint64_t q[8];
+    uint32_t w[16];
+    int i;
+
+    ct_load(q, in, 2);
+    for (i = 0; i < 5; i++) {
+        ct_aesenc(q, haraka256_ct_rc[i << 1]);
+        ct_aesenc(q, haraka256_ct_rc[(i << 1) + 1]);
+        ct_mix2(q);
+    }
+    ct_store(w, q);
+
+    /* Feed-forward */
+    for (i = 0; i < 8; i++) {
+        enc32le(out + (i << 2), w[i] ^ dec32le(in + (i << 2)));
+    }
+}
+
+/* bitsliced haraka512_ct_zero on n back to back inputs, for the multi-lane kernel entries */
+static void haraka512_ct_zero_nx(unsigned char *out, const unsigned char *in, int n)
+{
+    int i;
+
+    for (i = 0; i < n; i++) {
+        haraka512_ct_zero(out + (i << 5), in + (i << 6));
+    }
+}
+
+void haraka512_ct_zero_4x(unsigned char *out, const unsigned char *in)
+{
+    haraka512_ct_zero_nx(out, in, 4);
+}
+
+void haraka512_ct_zero_8x(unsigned char *out, const unsigned char *in)
+{
+    haraka512_ct_zero_nx(out, in, 8);
+}
+
+/* the chained form of haraka512_ct and haraka512_ct_zero, for the kernel entries. there
+   is no copy to save here, so they put the two halves together and call those */
+void haraka512_ct_chain(unsigned char *out, const unsigned char *cv, const unsigned char *block)
+{
+    unsigned char buf[64];
+
+    memcpy(buf, cv, 32);
+    memcpy(buf + 32, block, 32);
+    haraka512_ct(out, buf);
+}
+
+void haraka512_ct_zero_chain(unsigned char *out, const unsigned char *cv, const unsigned char *block)
+{
+    unsigned char buf[64];
+
+    memcpy(buf, cv, 32);
+    memcpy(buf + 32, block, 32);
+    haraka512_ct_zero(out, buf);
+}
@@ -0,0 +1,36 @@
+/*
+Constant-time, bitsliced C implementation of the Haraka256 and Haraka512
+permutations for CPUs without AES-NI.
+
+The AES round is evaluated on four blocks at once, with each bit of every
+state byte stored in one of eight 64-bit words (the layout used by BearSSL's
+aes_ct64). Haraka512 runs its four lanes in parallel this way and Haraka256
+uses two of the four slots. There are no table lookups indexed by secret
+data, and the output is bit-exact with the byte-wise haraka_portable.c code.
+*/
+#ifndef HARAKA_CT_H_
+#define HARAKA_CT_H_
+
+#include "haraka_portable.h"
+
+/* Implementation of Haraka-512 */
+void haraka512_ct(unsigned char *out, const unsigned char *in);
+
+/* Implementation of Haraka-512, with the constants supplied by the caller */
+void haraka512_ct_keyed(unsigned char *out, const unsigned char *in, const u128 *rc);
+
+/* Implementation of Haraka-512, using zero key */
+void haraka512_ct_zero(unsigned char *out, const unsigned char *in);
+
+/* Four and eight independent haraka512_ct_zero, inputs and outputs back to back */
+void haraka512_ct_zero_4x(unsigned char *out, const unsigned char *in);
+void haraka512_ct_zero_8x(unsigned char *out, const unsigned char *in);
+
+/* haraka512_ct and haraka512_ct_zero of the 32 byte cv followed by the 32 byte block */
+void haraka512_ct_chain(unsigned char *out, const unsigned char *cv, const unsigned char *block);
+void haraka512_ct_zero_chain(unsigned char *out, const unsigned char *cv, const unsigned char *block);
+
+/* Implementation of Haraka-256 */
+void haraka256_ct(unsigned char *out, const unsigned char *in);
+
+#endif
@@ -52,9 +52,8 @@ static const unsigned char haraka_rc[40][16] = {
     {0xa1, 0x9d, 0xc5, 0xe9, 0xfd, 0xbd, 0xd6, 0x4a, 0x88, 0x82, 0x28, 0x02, 0x03, 0xcc, 0x6a, 0x75}
 };
 
-static unsigned char rc[40][16];
-static unsigned char rc0[40][16];
-static unsigned char rc_sseed[40][16];
+// the zero key of haraka512_perm_zero, for every round
+static const unsigned char haraka_rc0[16] = {0};
 
 static const unsigned char sbox[256] =
 { 0x63, 0x7c, 0x77, 0x7b, 0xf2, 0x6b, 0x6f, 0xc5, 0x30, 0x01, 0x67, 0x2b, 0xfe,
@@ -122,31 +121,6 @@ void unpackhi32(unsigned char *t, unsigned char *a, unsigned char *b)
     memcpy(t, tmp, 16);
 }
 
-void load_constants_port()
-{
-    /* Use the standard constants to generate tweaked ones. */
-    memcpy(rc, haraka_rc, 40*16);
-}
-
-void tweak_constants(const unsigned char *pk_seed, const unsigned char *sk_seed,
-                     unsigned long long seed_length)
-{
-    unsigned char buf[40*16];
-
-    /* Use the standard constants to generate tweaked ones. */
-    memcpy(rc, haraka_rc, 40*16);
-
-    /* Constants for sk.seed */
-    if (sk_seed != NULL) {
-        haraka_S(buf, 40*16, sk_seed, seed_length);
-        memcpy(rc_sseed, buf, 40*16);
-    }
-
-    /* Constants for pk.seed */
-    haraka_S(buf, 40*16, pk_seed, seed_length);
-    memcpy(rc, buf, 40*16);    
-}
-
 static void haraka_S_absorb(unsigned char *s, 
                             const unsigned char *m, unsigned long long mlen,
                             unsigned char p)
@@ -226,10 +200,10 @@ void haraka512_perm(unsigned char *out, const unsigned char *in)
     for (i = 0; i < 5; ++i) {
         // aes round(s)
         for (j = 0; j < 2; ++j) {
-            aesenc(s, rc[4*2*i + 4*j]);
-            aesenc(s + 16, rc[4*2*i + 4*j + 1]);
-            aesenc(s + 32, rc[4*2*i + 4*j + 2]);
-            aesenc(s + 48, rc[4*2*i + 4*j + 3]);
+            aesenc(s, haraka_rc[4*2*i + 4*j]);
+            aesenc(s + 16, haraka_rc[4*2*i + 4*j + 1]);
+            aesenc(s + 32, haraka_rc[4*2*i + 4*j + 2]);
+            aesenc(s + 48, haraka_rc[4*2*i + 4*j + 3]);
         }
 
         // mixing
@@ -332,10 +306,10 @@ void haraka512_perm_zero(unsigned char *out, const unsigned char *in)
     for (i = 0; i < 5; ++i) {
         // aes round(s)
         for (j = 0; j < 2; ++j) {
-            aesenc(s, rc0[4*2*i + 4*j]);
-            aesenc(s + 16, rc0[4*2*i + 4*j + 1]);
-            aesenc(s + 32, rc0[4*2*i + 4*j + 2]);
-            aesenc(s + 48, rc0[4*2*i + 4*j + 3]);
+            aesenc(s, haraka_rc0);
+            aesenc(s + 16, haraka_rc0);
+            aesenc(s + 32, haraka_rc0);
+            aesenc(s + 48, haraka_rc0);
         }
 
         // mixing
@@ -383,8 +357,8 @@ void haraka256_port(unsigned char *out, const unsigned char *in)
     for (i = 0; i < 5; ++i) {
         // aes round(s)
         for (j = 0; j < 2; ++j) {
-            aesenc(s, rc[2*2*i + 2*j]);
-            aesenc(s + 16, rc[2*2*i + 2*j + 1]);
+            aesenc(s, haraka_rc[2*2*i + 2*j]);
+            aesenc(s + 16, haraka_rc[2*2*i + 2*j + 1]);
         }
 
         // mixing
@@ -399,30 +373,42 @@ void haraka256_port(unsigned char *out, const unsigned char *in)
     }
 }
 
-void haraka256_sk(unsigned char *out, const unsigned char *in)
+/* byte-wise haraka512_port_zero on n back to back inputs, for the multi-lane kernel entries */
+static void haraka512_port_zero_nx(unsigned char *out, const unsigned char *in, int n)
 {
-    int i, j;
+    int i;
 
-    unsigned char s[32], tmp[16];
+    for (i = 0; i < n; i++) {
+        haraka512_port_zero(out + (i << 5), in + (i << 6));
+    }
+}
 
-    memcpy(s, in, 16);
-    memcpy(s + 16, in + 16, 16);
+void haraka512_port_zero_4x(unsigned char *out, const unsigned char *in)
+{
+    haraka512_port_zero_nx(out, in, 4);
+}
 
-    for (i = 0; i < 5; ++i) {
-        // aes round(s)
-        for (j = 0; j < 2; ++j) {
-            aesenc(s, rc_sseed[2*2*i + 2*j]);
-            aesenc(s + 16, rc_sseed[2*2*i + 2*j + 1]);
-        }
+void haraka512_port_zero_8x(unsigned char *out, const unsigned char *in)
+{
+    haraka512_port_zero_nx(out, in, 8);
+}
 
-        // mixing
-        unpacklo32(tmp, s, s + 16);
-        unpackhi32(s + 16, s, s + 16);
-        memcpy(s, tmp, 16);
-    }
+/* the chained form of haraka512_port and haraka512_port_zero, for the kernel entries. there
+   is no copy to save here, so they put the two halves together and call those */
+void haraka512_port_chain(unsigned char *out, const unsigned char *cv, const unsigned char *block)
+{
+    unsigned char buf[64];
 
-    /* Feed-forward */
-    for (i = 0; i < 32; i++) {
-        out[i] = in[i] ^ s[i];
-    }
+    memcpy(buf, cv, 32);
+    memcpy(buf + 32, block, 32);
+    haraka512_port(out, buf);
+}
+
+void haraka512_port_zero_chain(unsigned char *out, const unsigned char *cv, const unsigned char *block)
+{
+    unsigned char buf[64];
+
+    memcpy(buf, cv, 32);
+    memcpy(buf + 32, block, 32);
+    haraka512_port_zero(out, buf);
 }
@@ -2,6 +2,7 @@
 #define SPX_HARAKA_H
 
 #include "immintrin.h"
+#include <string.h>
 
 #define NUMROUNDS 5
 
@@ -24,24 +25,30 @@ typedef unsigned int uint32_t;
 
 static inline __m128i _mm_unpacklo_epi32_emu(__m128i a, __m128i b)
 {
-    uint32_t result[4];
-    uint32_t *tmp1 = (uint32_t *)&a, *tmp2 = (uint32_t *)&b;
+    uint32_t result[4], tmp1[4], tmp2[4];
+    __m128i r;
+    memcpy(tmp1, &a, 16);
+    memcpy(tmp2, &b, 16);
     result[0] = tmp1[0];
     result[1] = tmp2[0];
     result[2] = tmp1[1];
     result[3] = tmp2[1];
-    return *(__m128i *)result;
+    memcpy(&r, result, 16);
+    return r;
 }
 
 static inline __m128i _mm_unpackhi_epi32_emu(__m128i a, __m128i b)
 {
-    uint32_t result[4];
-    uint32_t *tmp1 = (uint32_t *)&a, *tmp2 = (uint32_t *)&b;
+    uint32_t result[4], tmp1[4], tmp2[4];
+    __m128i r;
+    memcpy(tmp1, &a, 16);
+    memcpy(tmp2, &b, 16);
     result[0] = tmp1[2];
     result[1] = tmp2[2];
     result[2] = tmp1[3];
     result[3] = tmp2[3];
-    return *(__m128i *)result;
+    memcpy(&r, result, 16);
+    return r;
 }
 
 #define MIX2_EMU(s0, s1) \
@@ -49,13 +56,6 @@ static inline __m128i _mm_unpackhi_epi32_emu(__m128i a, __m128i b)
   s1 = _mm_unpackhi_epi32_emu(s0, s1); \
   s0 = tmp;
 
-/* load constants */
-void load_constants_port();
-
-/* Tweak constants with seed */
-void tweak_constants(const unsigned char *pk_seed, const unsigned char *sk_seed, 
-	                 unsigned long long seed_length);
-
 /* Haraka Sponge */
 void haraka_S(unsigned char *out, unsigned long long outlen,
               const unsigned char *in, unsigned long long inlen);
@@ -75,10 +75,15 @@ void haraka512_perm_zero(unsigned char *out, const unsigned char *in);
 /* Implementation of Haraka-512, using zero key */
 void haraka512_port_zero(unsigned char *out, const unsigned char *in);
 
+/* Four and eight independent haraka512_port_zero, inputs and outputs back to back */
+void haraka512_port_zero_4x(unsigned char *out, const unsigned char *in);
+void haraka512_port_zero_8x(unsigned char *out, const unsigned char *in);
+
+/* haraka512_port and haraka512_port_zero of the 32 byte cv followed by the 32 byte block */
+void haraka512_port_chain(unsigned char *out, const unsigned char *cv, const unsigned char *block);
+void haraka512_port_zero_chain(unsigned char *out, const unsigned char *cv, const unsigned char *block);
+
 /* Implementation of Haraka-256 */
 void haraka256_port(unsigned char *out, const unsigned char *in);
 
-/* Implementation of Haraka-256 using sk.seed constants */
-void haraka256_sk(unsigned char *out, const unsigned char *in);
-
 #endif
@@ -0,0 +1,107 @@
+// (C) 2018 The Verus Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+/*
+haraka512_zero on four and eight inputs at once with VAES, one input in each 128 bit lane of
+zmm registers, so every vaesenc does the work of four aesenc. The four 64 byte inputs of a
+group are loaded whole and transposed, so that register j holds state word j of each input,
+and transposed back before the truncated store.
+
+This file is built with -mavx512f -mvaes and only runs through the "vaes" Haraka kernel of the
+registry, on CPUs that have those extensions.
+*/
+
+#include <immintrin.h>
+
+#include "haraka.h"
+
+// 4x4 transpose of the 128 bit blocks of a, b, c and d
+#define TRANSPOSE4(a, b, c, d) \
+  t0 = _mm512_shuffle_i64x2(a, b, 0x44); \
+  t1 = _mm512_shuffle_i64x2(a, b, 0xee); \
+  t2 = _mm512_shuffle_i64x2(c, d, 0x44); \
+  t3 = _mm512_shuffle_i64x2(c, d, 0xee); \
+  a = _mm512_shuffle_i64x2(t0, t2, 0x88); \
+  b = _mm512_shuffle_i64x2(t0, t2, 0xdd); \
+  c = _mm512_shuffle_i64x2(t1, t3, 0x88); \
+  d = _mm512_shuffle_i64x2(t1, t3, 0xdd);
+
+// two rounds of AES on each word with the zero key, then the Haraka mix
+#define ROUND4_ZERO(s) \
+  s[0] = _mm512_aesenc_epi128(s[0], zero); \
+  s[1] = _mm512_aesenc_epi128(s[1], zero); \
+  s[2] = _mm512_aesenc_epi128(s[2], zero); \
+  s[3] = _mm512_aesenc_epi128(s[3], zero); \
+  s[0] = _mm512_aesenc_epi128(s[0], zero); \
+  s[1] = _mm512_aesenc_epi128(s[1], zero); \
+  s[2] = _mm512_aesenc_epi128(s[2], zero); \
+  s[3] = _mm512_aesenc_epi128(s[3], zero); \
+  tmp = _mm512_unpacklo_epi32(s[0], s[1]); \
+  s[0] = _mm512_unpackhi_epi32(s[0], s[1]); \
+  s[1] = _mm512_unpacklo_epi32(s[2], s[3]); \
+  s[2] = _mm512_unpackhi_epi32(s[2], s[3]); \
+  s[3] = _mm512_unpacklo_epi32(s[0], s[2]); \
+  s[0] = _mm512_unpackhi_epi32(s[0], s[2]); \
+  s[2] = _mm512_unpackhi_epi32(s[1], tmp); \
+  s[1] = _mm512_unpacklo_epi32(s[1], tmp);
+
+// the 64 bit words of one input's state that TRUNCSTORE keeps
+#define TRUNCSTORE4(out, s, in) \
+  TRANSPOSE4(s[0], s[1], s[2], s[3]); \
+  _mm256_storeu_si256((__m256i *)(out), _mm512_castsi512_si256(_mm512_permutexvar_epi64(trunc, _mm512_xor_si512(s[0], in[0])))); \
+  _mm256_storeu_si256((__m256i *)(out + 32), _mm512_castsi512_si256(_mm512_permutexvar_epi64(trunc, _mm512_xor_si512(s[1], in[1])))); \
+  _mm256_storeu_si256((__m256i *)(out + 64), _mm512_castsi512_si256(_mm512_permutexvar_epi64(trunc, _mm512_xor_si512(s[2], in[2])))); \
+  _mm256_storeu_si256((__m256i *)(out + 96), _mm512_castsi512_si256(_mm512_permutexvar_epi64(trunc, _mm512_xor_si512(s[3], in[3]))));
+
+#define LOAD4(s, in, src) \
+  in[0] = _mm512_loadu_si512((const void *)(src)); \
+  in[1] = _mm512_loadu_si512((const void *)((src) + 64)); \
+  in[2] = _mm512_loadu_si512((const void *)((src) + 128)); \
+  in[3] = _mm512_loadu_si512((const void *)((src) + 192)); \
+  s[0] = in[0]; \
+  s[1] = in[1]; \
+  s[2] = in[2]; \
+  s[3] = in[3]; \
+  TRANSPOSE4(s[0], s[1], s[2], s[3]);
+
+void haraka512_zero_4x_vaes(unsigned char *out, const unsigned char *in)
+{
+  const __m512i zero = _mm512_setzero_si512();
+  const __m512i trunc = _mm512_set_epi64(0, 0, 0, 0, 6, 4, 3, 1);
+  __m512i s[4], input[4], tmp, t0, t1, t2, t3;
+
+  LOAD4(s, input, in);
+
+  ROUND4_ZERO(s);
+  ROUND4_ZERO(s);
+  ROUND4_ZERO(s);
+  ROUND4_ZERO(s);
+  ROUND4_ZERO(s);
+
+  TRUNCSTORE4(out, s, input);
+}
+
+void haraka512_zero_8x_vaes(unsigned char *out, const unsigned char *in)
+{
+  const __m512i zero = _mm512_setzero_si512();
+  const __m512i trunc = _mm512_set_epi64(0, 0, 0, 0, 6, 4, 3, 1);
+  __m512i s[4], u[4], input[4], input2[4], tmp, t0, t1, t2, t3;
+
+  LOAD4(s, input, in);
+  LOAD4(u, input2, in + 256);
+
+  ROUND4_ZERO(s);
+  ROUND4_ZERO(u);
+  ROUND4_ZERO(s);
+  ROUND4_ZERO(u);
+  ROUND4_ZERO(s);
+  ROUND4_ZERO(u);
+  ROUND4_ZERO(s);
+  ROUND4_ZERO(u);
+  ROUND4_ZERO(s);
+  ROUND4_ZERO(u);
+
+  TRUNCSTORE4(out, s, input);
+  TRUNCSTORE4(out + 128, u, input2);
+}
@@ -5,6 +5,7 @@
 #include "sha256.h"
 
 #include "common.h"
+#include "verus_kernels.h"
 
 #include <string.h>
 #include <stdexcept>
@@ -131,6 +132,15 @@ void Transform(uint32_t* s, const unsigned char* chunk)
 } // namespace sha256
 } // namespace
 
+void SHA256TransformGeneric(uint32_t* s, const unsigned char* chunk, size_t blocks)
+{
+    while (blocks--) {
+        sha256::Transform(s, chunk);
+        chunk += 64;
+    }
+}
+
+#ifndef VERUS_KERNEL_SUFFIX
 
 ////// SHA-256
 
@@ -141,6 +151,7 @@ CSHA256::CSHA256() : bytes(0)
 
 CSHA256& CSHA256::Write(const unsigned char* data, size_t len)
 {
+    VerusSHA256TransformFunction Transform = CVerusKernels::SHA256()->transform;
     const unsigned char* end = data + len;
     size_t bufsize = bytes % 64;
     if (bufsize && bufsize + len >= 64) {
@@ -148,14 +159,15 @@ CSHA256& CSHA256::Write(const unsigned char* data, size_t len)
         memcpy(buf + bufsize, data, 64 - bufsize);
         bytes += 64 - bufsize;
         data += 64 - bufsize;
-        sha256::Transform(s, buf);
+        Transform(s, buf, 1);
         bufsize = 0;
     }
-    while (end >= data + 64) {
+    if (end - data >= 64) {
+        size_t blocks = (end - data) / 64;
         // Process full chunks directly from the source.
-        sha256::Transform(s, data);
-        bytes += 64;
-        data += 64;
+        Transform(s, data, blocks);
+        data += 64 * blocks;
+        bytes += 64 * blocks;
     }
     if (end > data) {
         // Fill the buffer with what remains.
@@ -197,3 +209,5 @@ CSHA256& CSHA256::Reset()
     sha256::Initialize(s);
     return *this;
 }
+
+#endif // VERUS_KERNEL_SUFFIX
@@ -29,4 +29,7 @@ private:
     void FinalizeNoPadding(unsigned char hash[OUTPUT_SIZE], bool enforce_compression);
 };
 
+/** Portable SHA-256 compression of consecutive 64 byte chunks, the "generic" kernel in verus_kernels.h. */
+void SHA256TransformGeneric(uint32_t* s, const unsigned char* chunk, size_t blocks);
+
 #endif // BITCOIN_CRYPTO_SHA256_H
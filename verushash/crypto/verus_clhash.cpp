@@ -17,7 +17,11 @@
  *
  **/
 
-#include "verus_hash.h"
+// only the kernels, this file is also built for the other feature levels, see verus_kernel_isa.h
+#define VERUS_CLHASH_KERNELS_ONLY
+#include "verus_clhash.h"
+#include "verus_clhash_step.h"
+#include "verus_clhash_stats.h"
 
 #include <assert.h>
 #include <string.h>
@@ -26,7 +30,6 @@
 #pragma warning (disable : 4146)
 #include <intrin.h>
 #endif
-int __cpuverusoptimized = 0x80;
 
 #if defined(__arm__)  || defined(__aarch64__)
 #include "crypto/SSE2NEON.h"
@@ -34,28 +37,6 @@ int __cpuverusoptimized = 0x80;
 #include <x86intrin.h>
 #endif
 
-#ifdef _WIN32
-#define posix_memalign(p, a, s) (((*(p)) = _aligned_malloc((s), (a))), *(p) ?0 :errno)
-#endif
-
-thread_local thread_specific_ptr verusclhasher_key;
-thread_local thread_specific_ptr verusclhasher_descr;
-
-#if defined(__APPLE__) || defined(_WIN32)
-// attempt to workaround horrible mingw/gcc destructor bug on Windows and Mac, which passes garbage in the this pointer
-// we use the opportunity of control here to clean up all of our tls variables. we could keep a list, but this is a safe,
-// functional hack
-thread_specific_ptr::~thread_specific_ptr() {
-    if (verusclhasher_key.ptr)
-    {
-        verusclhasher_key.reset();
-    }
-    if (verusclhasher_descr.ptr)
-    {
-        verusclhasher_descr.reset();
-    }
-}
-#endif // defined(__APPLE__) || defined(_WIN32)
 #if defined(__arm__)  || defined(__aarch64__) //intrinsics not defined in SSE2NEON.h
 
 static inline __attribute__((always_inline)) __m128i _mm_set_epi64x(uint64_t hi, uint64_t lo)
@@ -170,15 +151,6 @@ __m128i _mm_loadl_epi64(__m128i *a)
     return _mm_cvtsi128_si64(precompReduction64_si128(A));
 }
 
-    static inline __attribute__((always_inline)) void fixupkey(__m128i **pMoveScratch, verusclhash_descr *pdesc) {
-    uint32_t ofs = pdesc->keySizeInBytes >> 4;
-    for (__m128i *pfixup = *pMoveScratch; pfixup; pfixup = *++pMoveScratch)
-    {
-        const __m128i fixup = _mm_load_si128((__m128i *)(pfixup + ofs));
-        _mm_store_si128((__m128i *)pfixup, fixup);
-    }
-}
-
     static inline __attribute__((always_inline)) void haraka512_keyed_local(unsigned char *out, const unsigned char *in, const u128 *rc) {
   u128 s[4], tmp;
 
@@ -230,6 +202,7 @@ __m128i __verusclmulwithoutreduction64alignedrepeat(__m128i *randomsource, const
         // get two random locations in the key, which will be mutated and swapped
         __m128i *prand = randomsource + ((selector >> 5) & keyMask);
         __m128i *prandex = randomsource + ((selector >> 32) & keyMask);
+        VERUS_CLHASH_TRACE(VERUS_CLHASH_V2, i, selector, randomsource, prand, prandex);
 
         *(pMoveScratch++) = prand;
         *(pMoveScratch++) = prandex;        
@@ -490,6 +463,36 @@ uint64_t verusclhash_sv2_2(void * random, const unsigned char buf[64], uint64_t
     return precompReduction64(acc);
 }
 
+// four independent verusclhash_sv2_2 hashes, each with its own key and move scratch. the loops run
+// one iteration of each hash in turn, so their dependency chains can overlap in the CPU
+void verusclhash_sv2_2_x4(void *random[4], const unsigned char *buf[4], uint64_t keyMask, __m128i **pMoveScratch[4], uint64_t result[4]) {
+    __m128i pbuf_copy[4][4], acc[4];
+
+    keyMask >>= 4;
+    for (int lane = 0; lane < 4; lane++)
+    {
+        const __m128i *pbuf = (const __m128i *)buf[lane];
+        pbuf_copy[lane][0] = _mm_xor_si128(pbuf[0], pbuf[2]);
+        pbuf_copy[lane][1] = _mm_xor_si128(pbuf[1], pbuf[3]);
+        pbuf_copy[lane][2] = pbuf[2];
+        pbuf_copy[lane][3] = pbuf[3];
+        acc[lane] = _mm_load_si128((__m128i *)random[lane] + (keyMask + 2));
+    }
+
+    for (int64_t i = 0; i < 32; i++)
+    {
+        for (int lane = 0; lane < 4; lane++)
+        {
+            acc[lane] = verusclhash_sv2_2_step(acc[lane], (__m128i *)random[lane], pbuf_copy[lane], keyMask, pMoveScratch[lane] + (i << 1));
+        }
+    }
+
+    for (int lane = 0; lane < 4; lane++)
+    {
+        result[lane] = precompReduction64(_mm_xor_si128(acc[lane], lazyLengthHash(1024, 64)));
+    }
+}
+
 __m128i __verusclmulwithoutreduction64alignedrepeat_sv2_1(__m128i *randomsource, const __m128i buf[4], uint64_t keyMask, __m128i **pMoveScratch)
 {
     const __m128i pbuf_copy[4] = {_mm_xor_si128(buf[0], buf[2]), _mm_xor_si128(buf[1], buf[3]), buf[2], buf[3]};
@@ -510,6 +513,7 @@ __m128i __verusclmulwithoutreduction64alignedrepeat_sv2_1(__m128i *randomsource,
         // get two random locations in the key, which will be mutated and swapped
         __m128i *prand = randomsource + ((selector >> 5) & keyMask);
         __m128i *prandex = randomsource + ((selector >> 32) & keyMask);
+        VERUS_CLHASH_TRACE(VERUS_CLHASH_V2_1, i, selector, randomsource, prand, prandex);
 
         *(pMoveScratch++) = prand;
         *(pMoveScratch++) = prandex;        
@@ -773,7 +777,6 @@ __m128i __verusclmulwithoutreduction64alignedrepeat_sv2_1(__m128i *randomsource,
 __m128i __verusclmulwithoutreduction64alignedrepeat_sv2_2(__m128i *randomsource, const __m128i buf[4], uint64_t keyMask, __m128i **pMoveScratch)
 {
     const __m128i pbuf_copy[4] = {_mm_xor_si128(buf[0], buf[2]), _mm_xor_si128(buf[1], buf[3]), buf[2], buf[3]};
-    const __m128i *pbuf;
 
     // divide key mask by 16 from bytes to __m128i
     keyMask >>= 4;
@@ -783,286 +786,12 @@ __m128i __verusclmulwithoutreduction64alignedrepeat_sv2_2(__m128i *randomsource,
     // be used to xor into the accumulator before it is hashed with other values first
     __m128i acc = _mm_load_si128(randomsource + (keyMask + 2));
 
-    for (int64_t i = 0; i < 32; i++)
+    // the loop body is verusclhash_sv2_2_step, which the four lane kernels run too
+    for (int64_t i = 0; i < 32; i++, pMoveScratch += 2)
     {
         const uint64_t selector = _mm_cvtsi128_si64(acc);
-
-        // get two random locations in the key, which will be mutated and swapped
-        __m128i *prand = randomsource + ((selector >> 5) & keyMask);
-        __m128i *prandex = randomsource + ((selector >> 32) & keyMask);
-
-        *(pMoveScratch++) = prand;
-        *(pMoveScratch++) = prandex;        
-
-        // select random start and order of pbuf processing
-        pbuf = pbuf_copy + (selector & 3);
-
-        switch (selector & 0x1c)
-        {
-            case 0:
-            {
-                const __m128i temp1 = _mm_load_si128(prandex);
-                const __m128i temp2 = _mm_load_si128(pbuf - (((selector & 1) << 1) - 1));
-                const __m128i add1 = _mm_xor_si128(temp1, temp2);
-                const __m128i clprod1 = _mm_clmulepi64_si128(add1, add1, 0x10);
-                acc = _mm_xor_si128(clprod1, acc);
-
-                const __m128i tempa1 = _mm_mulhrs_epi16(acc, temp1);
-                const __m128i tempa2 = _mm_xor_si128(tempa1, temp1);
-
-                const __m128i temp12 = _mm_load_si128(prand);
-                _mm_store_si128(prand, tempa2);
-
-                const __m128i temp22 = _mm_load_si128(pbuf);
-                const __m128i add12 = _mm_xor_si128(temp12, temp22);
-                const __m128i clprod12 = _mm_clmulepi64_si128(add12, add12, 0x10);
-                acc = _mm_xor_si128(clprod12, acc);
-
-                const __m128i tempb1 = _mm_mulhrs_epi16(acc, temp12);
-                const __m128i tempb2 = _mm_xor_si128(tempb1, temp12);
-                _mm_store_si128(prandex, tempb2);
-                break;
-            }
-            case 4:
-            {
-                const __m128i temp1 = _mm_load_si128(prand);
-                const __m128i temp2 = _mm_load_si128(pbuf);
-                const __m128i add1 = _mm_xor_si128(temp1, temp2);
-                const __m128i clprod1 = _mm_clmulepi64_si128(add1, add1, 0x10);
-                acc = _mm_xor_si128(clprod1, acc);
-                const __m128i clprod2 = _mm_clmulepi64_si128(temp2, temp2, 0x10);
-                acc = _mm_xor_si128(clprod2, acc);
-
-                const __m128i tempa1 = _mm_mulhrs_epi16(acc, temp1);
-                const __m128i tempa2 = _mm_xor_si128(tempa1, temp1);
-
-                const __m128i temp12 = _mm_load_si128(prandex);
-                _mm_store_si128(prandex, tempa2);
-
-                const __m128i temp22 = _mm_load_si128(pbuf - (((selector & 1) << 1) - 1));
-                const __m128i add12 = _mm_xor_si128(temp12, temp22);
-                acc = _mm_xor_si128(add12, acc);
-
-                const __m128i tempb1 = _mm_mulhrs_epi16(acc, temp12);
-                const __m128i tempb2 = _mm_xor_si128(tempb1, temp12);
-                _mm_store_si128(prand, tempb2);
-                break;
-            }
-            case 8:
-            {
-                const __m128i temp1 = _mm_load_si128(prandex);
-                const __m128i temp2 = _mm_load_si128(pbuf);
-                const __m128i add1 = _mm_xor_si128(temp1, temp2);
-                acc = _mm_xor_si128(add1, acc);
-
-                const __m128i tempa1 = _mm_mulhrs_epi16(acc, temp1);
-                const __m128i tempa2 = _mm_xor_si128(tempa1, temp1);
-
-                const __m128i temp12 = _mm_load_si128(prand);
-                _mm_store_si128(prand, tempa2);
-
-                const __m128i temp22 = _mm_load_si128(pbuf - (((selector & 1) << 1) - 1));
-                const __m128i add12 = _mm_xor_si128(temp12, temp22);
-                const __m128i clprod12 = _mm_clmulepi64_si128(add12, add12, 0x10);
-                acc = _mm_xor_si128(clprod12, acc);
-                const __m128i clprod22 = _mm_clmulepi64_si128(temp22, temp22, 0x10);
-                acc = _mm_xor_si128(clprod22, acc);
-
-                const __m128i tempb1 = _mm_mulhrs_epi16(acc, temp12);
-                const __m128i tempb2 = _mm_xor_si128(tempb1, temp12);
-                _mm_store_si128(prandex, tempb2);
-                break;
-            }
-            case 0xc:
-            {
-                const __m128i temp1 = _mm_load_si128(prand);
-                const __m128i temp2 = _mm_load_si128(pbuf - (((selector & 1) << 1) - 1));
-                const __m128i add1 = _mm_xor_si128(temp1, temp2);
-
-                // cannot be zero here
-                const int32_t divisor = (uint32_t)selector;
-
-                acc = _mm_xor_si128(add1, acc);
-
-                const int64_t dividend = _mm_cvtsi128_si64(acc);
-                const __m128i modulo = _mm_cvtsi32_si128(dividend % divisor);
-                acc = _mm_xor_si128(modulo, acc);
-
-                const __m128i tempa1 = _mm_mulhrs_epi16(acc, temp1);
-                const __m128i tempa2 = _mm_xor_si128(tempa1, temp1);
-
-                if (dividend & 1)
-                {
-                    const __m128i temp12 = _mm_load_si128(prandex);
-                    _mm_store_si128(prandex, tempa2);
-
-                    const __m128i temp22 = _mm_load_si128(pbuf);
-                    const __m128i add12 = _mm_xor_si128(temp12, temp22);
-                    const __m128i clprod12 = _mm_clmulepi64_si128(add12, add12, 0x10);
-                    acc = _mm_xor_si128(clprod12, acc);
-                    const __m128i clprod22 = _mm_clmulepi64_si128(temp22, temp22, 0x10);
-                    acc = _mm_xor_si128(clprod22, acc);
-
-                    const __m128i tempb1 = _mm_mulhrs_epi16(acc, temp12);
-                    const __m128i tempb2 = _mm_xor_si128(tempb1, temp12);
-                    _mm_store_si128(prand, tempb2);
-                }
-                else
-                {
-                    const __m128i tempb3 = _mm_load_si128(prandex);
-                    _mm_store_si128(prandex, tempa2);
-                    _mm_store_si128(prand, tempb3);
-                    const __m128i tempb4 = _mm_load_si128(pbuf);
-                    acc = _mm_xor_si128(tempb4, acc);
-                }
-                break;
-            }
-            case 0x10:
-            {
-                // a few AES operations
-                const __m128i *rc = prand;
-                __m128i tmp;
-
-                __m128i temp1 = _mm_load_si128(pbuf - (((selector & 1) << 1) - 1));
-                __m128i temp2 = _mm_load_si128(pbuf);
-
-                AES2(temp1, temp2, 0);
-                MIX2(temp1, temp2);
-
-                AES2(temp1, temp2, 4);
-                MIX2(temp1, temp2);
-
-                AES2(temp1, temp2, 8);
-                MIX2(temp1, temp2);
-
-                acc = _mm_xor_si128(temp2, _mm_xor_si128(temp1, acc));
-
-                const __m128i tempa1 = _mm_load_si128(prand);
-                const __m128i tempa2 = _mm_mulhrs_epi16(acc, tempa1);
-                const __m128i tempa3 = _mm_xor_si128(tempa1, tempa2);
-
-                const __m128i tempa4 = _mm_load_si128(prandex);
-                _mm_store_si128(prandex, tempa3);
-                _mm_store_si128(prand, tempa4);
-                break;
-            }
-            case 0x14:
-            {
-                // we'll just call this one the monkins loop, inspired by Chris - modified to cast to uint64_t on shift for more variability in the loop
-                const __m128i *buftmp = pbuf - (((selector & 1) << 1) - 1);
-                __m128i tmp; // used by MIX2
-
-                uint64_t rounds = selector >> 61; // loop randomly between 1 and 8 times
-                __m128i *rc = prand;
-                uint64_t aesroundoffset = 0;
-                __m128i onekey;
-
-                do
-                {
-                    if (selector & (((uint64_t)0x10000000) << rounds))
-                    {
-                        onekey = _mm_load_si128(rc++);
-                        const __m128i temp2 = _mm_load_si128(rounds & 1 ? pbuf : buftmp);
-                        const __m128i add1 = _mm_xor_si128(onekey, temp2);
-                        const __m128i clprod1 = _mm_clmulepi64_si128(add1, add1, 0x10);
-                        acc = _mm_xor_si128(clprod1, acc);
-                    }
-                    else
-                    {
-                        onekey = _mm_load_si128(rc++);
-                        __m128i temp2 = _mm_load_si128(rounds & 1 ? buftmp : pbuf);
-                        AES2(onekey, temp2, aesroundoffset);
-                        aesroundoffset += 4;
-                        MIX2(onekey, temp2);
-                        acc = _mm_xor_si128(onekey, acc);
-                        acc = _mm_xor_si128(temp2, acc);
-                    }
-                } while (rounds--);
-
-                const __m128i tempa1 = _mm_load_si128(prand);
-                const __m128i tempa2 = _mm_mulhrs_epi16(acc, tempa1);
-                const __m128i tempa3 = _mm_xor_si128(tempa1, tempa2);
-
-                const __m128i tempa4 = _mm_load_si128(prandex);
-                _mm_store_si128(prandex, tempa3);
-                _mm_store_si128(prand, tempa4);
-                break;
-            }
-            case 0x18:
-            {
-                const __m128i *buftmp = pbuf - (((selector & 1) << 1) - 1);
-
-                uint64_t rounds = selector >> 61; // loop randomly between 1 and 8 times
-                __m128i *rc = prand;
-                __m128i onekey;
-
-                do
-                {
-                    if (selector & (((uint64_t)0x10000000) << rounds))
-                    {
-                        onekey = _mm_load_si128(rc++);
-                        const __m128i temp2 = _mm_load_si128(rounds & 1 ? pbuf : buftmp);
-                        onekey = _mm_xor_si128(onekey, temp2);
-                        // cannot be zero here, may be negative
-                        const int32_t divisor = (uint32_t)selector;
-                        const int64_t dividend = _mm_cvtsi128_si64(onekey);
-                        const __m128i modulo = _mm_cvtsi32_si128(dividend % divisor);
-                        acc = _mm_xor_si128(modulo, acc);
-                    }
-                    else
-                    {
-                        onekey = _mm_load_si128(rc++);
-                        __m128i temp2 = _mm_load_si128(rounds & 1 ? buftmp : pbuf);
-                        const __m128i add1 = _mm_xor_si128(onekey, temp2);
-                        onekey = _mm_clmulepi64_si128(add1, add1, 0x10);
-                        const __m128i clprod2 = _mm_mulhrs_epi16(acc, onekey);
-                        acc = _mm_xor_si128(clprod2, acc);
-                    }
-                } while (rounds--);
-
-                const __m128i tempa3 = _mm_load_si128(prandex);
-                const __m128i tempa4 = _mm_xor_si128(tempa3, acc);
-
-                _mm_store_si128(prandex, onekey);
-                _mm_store_si128(prand, tempa4);
-                break;
-            }
-            case 0x1c:
-            {
-                const __m128i temp1 = _mm_load_si128(pbuf);
-                const __m128i temp2 = _mm_load_si128(prandex);
-                const __m128i add1 = _mm_xor_si128(temp1, temp2);
-                const __m128i clprod1 = _mm_clmulepi64_si128(add1, add1, 0x10);
-                acc = _mm_xor_si128(clprod1, acc);
-
-                const __m128i tempa1 = _mm_mulhrs_epi16(acc, temp2);
-                const __m128i tempa2 = _mm_xor_si128(tempa1, temp2);
-
-                const __m128i tempa3 = _mm_load_si128(prand);
-                _mm_store_si128(prand, tempa2);
-
-                acc = _mm_xor_si128(tempa3, acc);
-                const __m128i temp4 = _mm_load_si128(pbuf - (((selector & 1) << 1) - 1)); 
-                acc = _mm_xor_si128(temp4,acc);  
-                const __m128i tempb1 = _mm_mulhrs_epi16(acc, tempa3);
-                const __m128i tempb2 = _mm_xor_si128(tempb1, tempa3);
-                _mm_store_si128(prandex, tempb2);
-                break;
-            }
-        }
+        acc = verusclhash_sv2_2_step(acc, randomsource, pbuf_copy, keyMask, pMoveScratch);
+        VERUS_CLHASH_TRACE(VERUS_CLHASH_V2_2, i, selector, randomsource, pMoveScratch[0], pMoveScratch[1]);
     }
     return acc;
 }
-
-void *alloc_aligned_buffer(uint64_t bufSize)
-{
-    void *answer = NULL;
-    if (posix_memalign(&answer, sizeof(__m128i)*2, bufSize))
-    {
-        return NULL;
-    }
-    else
-    {
-        return answer;
-    }
-}
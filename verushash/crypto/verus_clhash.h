@@ -52,23 +52,79 @@ enum {
     SOLUTION_VERUSHHASH_V2_2 = 4
 };
 
+__m128i __verusclmulwithoutreduction64alignedrepeat(__m128i *randomsource, const __m128i buf[4], uint64_t keyMask, __m128i **pMoveScratch);
+__m128i __verusclmulwithoutreduction64alignedrepeat_sv2_1(__m128i *randomsource, const __m128i buf[4], uint64_t keyMask, __m128i **pMoveScratch);
+__m128i __verusclmulwithoutreduction64alignedrepeat_sv2_2(__m128i *randomsource, const __m128i buf[4], uint64_t keyMask, __m128i **pMoveScratch);
+__m128i __verusclmulwithoutreduction64alignedrepeat_port(__m128i *randomsource, const __m128i buf[4], uint64_t keyMask, __m128i **pMoveScratch);
+__m128i __verusclmulwithoutreduction64alignedrepeat_sv2_1_port(__m128i *randomsource, const __m128i buf[4], uint64_t keyMask, __m128i **pMoveScratch);
+__m128i __verusclmulwithoutreduction64alignedrepeat_sv2_2_port(__m128i *randomsource, const __m128i buf[4], uint64_t keyMask, __m128i **pMoveScratch);
+
+uint64_t verusclhash(void * random, const unsigned char buf[64], uint64_t keyMask, __m128i **pMoveScratch);
+uint64_t verusclhash_port(void * random, const unsigned char buf[64], uint64_t keyMask, __m128i **pMoveScratch);
+uint64_t verusclhash_sv2_1(void * random, const unsigned char buf[64], uint64_t keyMask, __m128i **pMoveScratch);
+uint64_t verusclhash_sv2_1_port(void * random, const unsigned char buf[64], uint64_t keyMask, __m128i **pMoveScratch);
+uint64_t verusclhash_sv2_2(void * random, const unsigned char buf[64], uint64_t keyMask, __m128i **pMoveScratch);
+uint64_t verusclhash_sv2_2_port(void * random, const unsigned char buf[64], uint64_t keyMask, __m128i **pMoveScratch);
+
+// four independent sv2_2 hashes at once, each with its own key, buffer and move scratch. the
+// keys must not overlap. the _avx512 version is experimental and needs AVX-512BW, VAES and
+// VPCLMULQDQ, see verus_clhash_avx512.cpp
+void verusclhash_sv2_2_x4(void *random[4], const unsigned char *buf[4], uint64_t keyMask, __m128i **pMoveScratch[4], uint64_t result[4]);
+void verusclhash_sv2_2_x4_port(void *random[4], const unsigned char *buf[4], uint64_t keyMask, __m128i **pMoveScratch[4], uint64_t result[4]);
+void verusclhash_sv2_2_x4_avx512(void *random[4], const unsigned char *buf[4], uint64_t keyMask, __m128i **pMoveScratch[4], uint64_t result[4]);
+void *alloc_aligned_buffer(uint64_t bufSize);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+// the key buffers and the hasher, which the kernel sources leave out with
+// VERUS_CLHASH_KERNELS_ONLY. those are also built for other feature levels, and inline code of
+// these headers compiled there could be picked over the baseline copy by the linker
+#if defined(__cplusplus) && !defined(VERUS_CLHASH_KERNELS_ONLY)
+#include <new>
+
+#include "uint256.h"
+#include "verus_counters.h"
+#include "verus_kernels.h"
+#include "verus_memory.h"
+#include "verus_probes.h"
+
 struct verusclhash_descr
 {
     uint256 seed;
     uint32_t keySizeInBytes;
+    bool generated;             // the key holds the one of seed, false for a new, uninitialized key
 };
 
 struct thread_specific_ptr {
     void *ptr;
-    thread_specific_ptr() { ptr = NULL; }
-    void reset(void *newptr = NULL)
+    int freeCounter;            // the runtime counter of frees, or -1
+    int memoryKind;             // the VERUS_MEMORY_ kind the buffer is accounted as
+    uint64_t bytes;
+    thread_specific_ptr(int counter, int kind) { ptr = NULL; freeCounter = counter; memoryKind = kind; bytes = 0; }
+    void reset(void *newptr = NULL, uint64_t newBytes = 0)
     {
-        if (ptr && ptr != newptr)
+        if (ptr == newptr)
+        {
+            return;
+        }
+        if (ptr)
         {
             std::free(ptr);
+            CVerusMemory::Free(memoryKind, bytes);
+            if (freeCounter >= 0)
+            {
+                CVerusCounters::AddShared(freeCounter);
+                VERUS_PROBE1(key_free, ptr);
+            }
+        }
+        if (newptr)
+        {
+            CVerusMemory::Alloc(memoryKind, newBytes);
         }
         ptr = newptr;
-
+        bytes = newBytes;
     }
     void *get() { return ptr; }
 #if defined(__APPLE__) || defined(_WIN32)
@@ -81,63 +137,11 @@ struct thread_specific_ptr {
 #endif
 };
 
+extern "C" {
 extern thread_local thread_specific_ptr verusclhasher_key;
 extern thread_local thread_specific_ptr verusclhasher_descr;
+}
 
-extern int __cpuverusoptimized;
-
-__m128i __verusclmulwithoutreduction64alignedrepeat(__m128i *randomsource, const __m128i buf[4], uint64_t keyMask, __m128i **pMoveScratch);
-__m128i __verusclmulwithoutreduction64alignedrepeat_sv2_1(__m128i *randomsource, const __m128i buf[4], uint64_t keyMask, __m128i **pMoveScratch);
-__m128i __verusclmulwithoutreduction64alignedrepeat_sv2_2(__m128i *randomsource, const __m128i buf[4], uint64_t keyMask, __m128i **pMoveScratch);
-__m128i __verusclmulwithoutreduction64alignedrepeat_port(__m128i *randomsource, const __m128i buf[4], uint64_t keyMask, __m128i **pMoveScratch);
-__m128i __verusclmulwithoutreduction64alignedrepeat_sv2_1_port(__m128i *randomsource, const __m128i buf[4], uint64_t keyMask, __m128i **pMoveScratch);
-__m128i __verusclmulwithoutreduction64alignedrepeat_sv2_2_port(__m128i *randomsource, const __m128i buf[4], uint64_t keyMask, __m128i **pMoveScratch);
-
-inline bool IsCPUVerusOptimized()
-{
-    #if defined(__arm__)  || defined(__aarch64__)
-    long hwcaps= getauxval(AT_HWCAP);
-
-    if((hwcaps & HWCAP_AES) && (hwcaps & HWCAP_PMULL))
-        __cpuverusoptimized = true;
-    else
-        __cpuverusoptimized = false;
-        
-    #else
-    if (__cpuverusoptimized & 0x80)
-    {
-        unsigned int eax,ebx,ecx,edx;
-        if (!__get_cpuid(1,&eax,&ebx,&ecx,&edx))
-        {
-            __cpuverusoptimized = false;
-        }
-        else
-        {
-            __cpuverusoptimized = ((ecx & (bit_AVX | bit_AES | bit_PCLMUL)) == (bit_AVX | bit_AES | bit_PCLMUL));
-        }
-    }
-    #endif
-    return __cpuverusoptimized;
-};
-
-inline void ForceCPUVerusOptimized(bool trueorfalse)
-{
-    __cpuverusoptimized = trueorfalse;
-};
-
-uint64_t verusclhash(void * random, const unsigned char buf[64], uint64_t keyMask, __m128i **pMoveScratch);
-uint64_t verusclhash_port(void * random, const unsigned char buf[64], uint64_t keyMask, __m128i **pMoveScratch);
-uint64_t verusclhash_sv2_1(void * random, const unsigned char buf[64], uint64_t keyMask, __m128i **pMoveScratch);
-uint64_t verusclhash_sv2_1_port(void * random, const unsigned char buf[64], uint64_t keyMask, __m128i **pMoveScratch);
-uint64_t verusclhash_sv2_2(void * random, const unsigned char buf[64], uint64_t keyMask, __m128i **pMoveScratch);
-uint64_t verusclhash_sv2_2_port(void * random, const unsigned char buf[64], uint64_t keyMask, __m128i **pMoveScratch);
-void *alloc_aligned_buffer(uint64_t bufSize);
-
-#ifdef __cplusplus
-} // extern "C"
-#endif
-
-#ifdef __cplusplus
 // special high speed hasher for VerusHash 2.0
 struct verusclhasher {
     uint64_t keySizeInBytes;
@@ -161,49 +165,31 @@ struct verusclhasher {
 #ifdef __APPLE__
        __tls_init();
 #endif
-        if (IsCPUVerusOptimized())
+        const CVerusCLHashKernel *pkernel = CVerusKernels::CLHash();
+        int clhashVersion = solutionVersion >= SOLUTION_VERUSHHASH_V2_2 ? VERUS_CLHASH_V2_2 :
+                            solutionVersion >= SOLUTION_VERUSHHASH_V2_1 ? VERUS_CLHASH_V2_1 : VERUS_CLHASH_V2;
+        verusclhashfunction = pkernel->clhash[clhashVersion];
+        verusinternalclhashfunction = pkernel->clhashInternal[clhashVersion];
+
+        CVerusKeyClaim claim;
+        if (allockey())
         {
-            if (solutionVersion >= SOLUTION_VERUSHHASH_V2_1)
-            {
-                if (solutionVersion >= SOLUTION_VERUSHHASH_V2_2)
-                {
-                    verusclhashfunction = &verusclhash_sv2_2;
-                    verusinternalclhashfunction = &__verusclmulwithoutreduction64alignedrepeat_sv2_2;
-                }
-                else
-                {
-                    verusclhashfunction = &verusclhash_sv2_1;
-                    verusinternalclhashfunction = &__verusclmulwithoutreduction64alignedrepeat_sv2_1;
-                }
-            }
-            else
-            {
-                verusclhashfunction = &verusclhash;
-                verusinternalclhashfunction = &__verusclmulwithoutreduction64alignedrepeat;
-            }
+            keyMask = keymask(keySizeInBytes);
         }
         else
         {
-            if (solutionVersion >= SOLUTION_VERUSHHASH_V2_1)
-            {
-                if (solutionVersion >= SOLUTION_VERUSHHASH_V2_2)
-                {
-                    verusclhashfunction = &verusclhash_sv2_2_port;
-                    verusinternalclhashfunction = &__verusclmulwithoutreduction64alignedrepeat_sv2_2_port;
-                }
-                else
-                {
-                    verusclhashfunction = &verusclhash_sv2_1_port;
-                    verusinternalclhashfunction = &__verusclmulwithoutreduction64alignedrepeat_sv2_1_port;
-                }
-            }
-            else
-            {
-                verusclhashfunction = &verusclhash_port;
-                verusinternalclhashfunction = &__verusclmulwithoutreduction64alignedrepeat_port;
-            }
+            keyMask = 0;
+            keySizeInBytes = 0;
         }
+#ifdef VERUSHASHDEBUG
+        printf("New hasher, keyMask: %lx, newKeySize: %lx\n", keyMask, keySizeInBytes);
+#endif
+    }
 
+    // the calling thread's key buffer, allocated with its descriptor if the thread has none or
+    // one of another size, or NULL if that fails. the thread must hold a CVerusKeyClaim
+    inline void *allockey()
+    {
         // if we changed, change it
         if (verusclhasher_key.get() && keySizeInBytes != ((verusclhash_descr *)verusclhasher_descr.get())->keySizeInBytes)
         {
@@ -213,10 +199,16 @@ struct verusclhasher {
         // get buffer space for mutating and refresh keys
         void *key = NULL;
         if (!(key = verusclhasher_key.get()) &&
-            (verusclhasher_key.reset((unsigned char *)alloc_aligned_buffer(keySizeInBytes << 1)), key = verusclhasher_key.get()))
+            (verusclhasher_key.reset((unsigned char *)alloc_aligned_buffer(keySizeInBytes << 1), keySizeInBytes << 1),
+             key = verusclhasher_key.get()))
         {
+            CVerusCounters::AddShared(VERUS_COUNTER_KEY_ALLOCATIONS);
+            VERUS_PROBE2(key_alloc, key, keySizeInBytes << 1);
+            // malloc'd like the key, as thread_specific_ptr frees both with free
             verusclhash_descr *pdesc;
-            if (verusclhasher_descr.reset(new verusclhash_descr()), pdesc = (verusclhash_descr *)verusclhasher_descr.get())
+            void *descr = std::malloc(sizeof(verusclhash_descr));
+            if (verusclhasher_descr.reset(descr ? new (descr) verusclhash_descr() : NULL, sizeof(verusclhash_descr)),
+                pdesc = (verusclhash_descr *)verusclhasher_descr.get())
             {
                 pdesc->keySizeInBytes = keySizeInBytes;
             }
@@ -226,18 +218,7 @@ struct verusclhasher {
                 key = NULL;
             }
         }
-        if (key)
-        {
-            keyMask = keymask(keySizeInBytes);
-        }
-        else
-        {
-            keyMask = 0;
-            keySizeInBytes = 0;
-        }
-#ifdef VERUSHASHDEBUG
-        printf("New hasher, keyMask: %lx, newKeySize: %lx\n", keyMask, keySizeInBytes);
-#endif
+        return key;
     }
 
     inline void *gethasherrefresh()
@@ -299,6 +280,6 @@ struct verusclhasher {
     }
 };
 
-#endif // #ifdef __cplusplus
+#endif // defined(__cplusplus) && !defined(VERUS_CLHASH_KERNELS_ONLY)
 
 #endif // INCLUDE_VERUS_CLHASH_H
@@ -0,0 +1,257 @@
+/*
+ * This uses variations of the clhash algorithm for Verus Coin, licensed
+ * with the Apache-2.0 open source license.
+ *
+ * Copyright (c) 2018 Michael Toutonghi
+ * Distributed under the Apache 2.0 software license, available in the original form for clhash
+ * here: https://github.com/lemire/clhash/commit/934da700a2a54d8202929a826e2763831bd43cf7#diff-9879d6db96fd29134fc802214163b95a
+ *
+ **/
+
+/*
+Experimental AVX-512 version of verusclhash_sv2_2_x4, with the four hashes in the four 128 bit
+lanes of zmm registers. Every loop iteration takes its case from each lane's accumulator, so
+the lanes rarely agree. The straight line cases (0, 4, 8, 0x10 and 0x1c) are computed at full
+width for the lanes that need them and merged with masked blends, the cases with a division or
+a variable length loop (0xc, 0x14 and 0x18) run verusclhash_sv2_2_step on their own lanes.
+
+This file is built with -mavx512f -mavx512bw -mvaes -mvpclmulqdq and only runs through the
+"avx512-x4" CLHash kernel of the registry, on CPUs that have those extensions.
+*/
+
+// only the kernels, see verus_clhash.cpp
+#define VERUS_CLHASH_KERNELS_ONLY
+#include "verus_clhash.h"
+#include "verus_clhash_step.h"
+
+#include <immintrin.h>
+
+// 64 bit element mask of a 128 bit lane
+#define LANE_MASK(lane) ((__mmask8)(3 << ((lane) << 1)))
+
+static inline __attribute__((always_inline)) __m512i load_x4(const __m128i *const p[4], int offset)
+{
+    __m512i v = _mm512_castsi128_si512(_mm_load_si128(p[0] + offset));
+    v = _mm512_inserti32x4(v, _mm_load_si128(p[1] + offset), 1);
+    v = _mm512_inserti32x4(v, _mm_load_si128(p[2] + offset), 2);
+    return _mm512_inserti32x4(v, _mm_load_si128(p[3] + offset), 3);
+}
+
+static inline __attribute__((always_inline)) __m512i clmul_x4(__m512i a)
+{
+    return _mm512_clmulepi64_epi128(a, a, 0x10);
+}
+
+static inline __attribute__((always_inline)) __m512i mulhrs_xor_x4(__m512i acc, __m512i t)
+{
+    return _mm512_xor_si512(_mm512_mulhrs_epi16(acc, t), t);
+}
+
+#define AES2_X4(s0, s1, k) \
+  s0 = _mm512_aesenc_epi128(s0, k[0]); \
+  s1 = _mm512_aesenc_epi128(s1, k[1]); \
+  s0 = _mm512_aesenc_epi128(s0, k[2]); \
+  s1 = _mm512_aesenc_epi128(s1, k[3]);
+
+#define MIX2_X4(s0, s1) \
+  tmp = _mm512_unpacklo_epi32(s0, s1); \
+  s1 = _mm512_unpackhi_epi32(s0, s1); \
+  s0 = tmp;
+
+void verusclhash_sv2_2_x4_avx512(void *random[4], const unsigned char *buf[4], uint64_t keyMask, __m128i **pMoveScratch[4], uint64_t result[4])
+{
+    alignas(64) __m128i pbuf_copy[4][4];
+    alignas(64) __m128i lanes[4];
+    __m128i *key[4];
+
+    keyMask >>= 4;
+    for (int lane = 0; lane < 4; lane++)
+    {
+        const __m128i *pbuf = (const __m128i *)buf[lane];
+        pbuf_copy[lane][0] = _mm_xor_si128(pbuf[0], pbuf[2]);
+        pbuf_copy[lane][1] = _mm_xor_si128(pbuf[1], pbuf[3]);
+        pbuf_copy[lane][2] = pbuf[2];
+        pbuf_copy[lane][3] = pbuf[3];
+        key[lane] = (__m128i *)random[lane];
+        lanes[lane] = _mm_load_si128(key[lane] + (keyMask + 2));
+    }
+    __m512i acc = _mm512_load_si512(lanes);
+
+    for (int64_t i = 0; i < 32; i++)
+    {
+        alignas(64) uint64_t selectors[8];
+        const __m128i *prand[4], *prandex[4], *pbuf[4], *pbufalt[4];
+        __mmask8 case0 = 0, case4 = 0, case8 = 0, case10 = 0, case1c = 0, scalar = 0;
+
+        _mm512_store_si512(selectors, acc);
+        for (int lane = 0; lane < 4; lane++)
+        {
+            const uint64_t selector = selectors[lane << 1];
+
+            prand[lane] = key[lane] + ((selector >> 5) & keyMask);
+            prandex[lane] = key[lane] + ((selector >> 32) & keyMask);
+            pbuf[lane] = pbuf_copy[lane] + (selector & 3);
+            pbufalt[lane] = pbuf[lane] - (((selector & 1) << 1) - 1);
+
+            pMoveScratch[lane][i << 1] = (__m128i *)prand[lane];
+            pMoveScratch[lane][(i << 1) + 1] = (__m128i *)prandex[lane];
+
+            switch (selector & 0x1c)
+            {
+                case 0:
+                    case0 |= LANE_MASK(lane);
+                    break;
+                case 4:
+                    case4 |= LANE_MASK(lane);
+                    break;
+                case 8:
+                    case8 |= LANE_MASK(lane);
+                    break;
+                case 0x10:
+                    case10 |= LANE_MASK(lane);
+                    break;
+                case 0x1c:
+                    case1c |= LANE_MASK(lane);
+                    break;
+                default:
+                    scalar |= LANE_MASK(lane);
+                    break;
+            }
+        }
+
+        __m512i nextAcc = acc;
+
+        if (scalar != 0xff)
+        {
+            const __m512i R = load_x4(prand, 0);
+            const __m512i X = load_x4(prandex, 0);
+            const __m512i B = load_x4(pbuf, 0);
+            const __m512i A = load_x4(pbufalt, 0);
+            __m512i newR = R, newX = X;
+            __mmask8 prandLast = 0;         // lanes whose prand store comes after prandex
+
+            if (case0)
+            {
+                __m512i a = _mm512_xor_si512(clmul_x4(_mm512_xor_si512(X, A)), acc);
+                const __m512i tempa2 = mulhrs_xor_x4(a, X);
+                a = _mm512_xor_si512(clmul_x4(_mm512_xor_si512(R, B)), a);
+                const __m512i tempb2 = mulhrs_xor_x4(a, R);
+                nextAcc = _mm512_mask_blend_epi64(case0, nextAcc, a);
+                newR = _mm512_mask_blend_epi64(case0, newR, tempa2);
+                newX = _mm512_mask_blend_epi64(case0, newX, tempb2);
+            }
+            if (case4)
+            {
+                __m512i a = _mm512_xor_si512(clmul_x4(_mm512_xor_si512(R, B)), acc);
+                a = _mm512_xor_si512(clmul_x4(B), a);
+                const __m512i tempa2 = mulhrs_xor_x4(a, R);
+                a = _mm512_xor_si512(_mm512_xor_si512(X, A), a);
+                const __m512i tempb2 = mulhrs_xor_x4(a, X);
+                nextAcc = _mm512_mask_blend_epi64(case4, nextAcc, a);
+                newX = _mm512_mask_blend_epi64(case4, newX, tempa2);
+                newR = _mm512_mask_blend_epi64(case4, newR, tempb2);
+                prandLast |= case4;
+            }
+            if (case8)
+            {
+                __m512i a = _mm512_xor_si512(_mm512_xor_si512(X, B), acc);
+                const __m512i tempa2 = mulhrs_xor_x4(a, X);
+                a = _mm512_xor_si512(clmul_x4(_mm512_xor_si512(R, A)), a);
+                a = _mm512_xor_si512(clmul_x4(A), a);
+                const __m512i tempb2 = mulhrs_xor_x4(a, R);
+                nextAcc = _mm512_mask_blend_epi64(case8, nextAcc, a);
+                newR = _mm512_mask_blend_epi64(case8, newR, tempa2);
+                newX = _mm512_mask_blend_epi64(case8, newX, tempb2);
+            }
+            if (case10)
+            {
+                // a few AES operations, keyed with the 12 key entries at prand of each lane
+                __m512i rc[12], tmp;
+                for (int j = 0; j < 12; j++)
+                {
+                    rc[j] = load_x4(prand, j);
+                }
+                __m512i temp1 = A, temp2 = B;
+
+                AES2_X4(temp1, temp2, rc);
+                MIX2_X4(temp1, temp2);
+
+                AES2_X4(temp1, temp2, (rc + 4));
+                MIX2_X4(temp1, temp2);
+
+                AES2_X4(temp1, temp2, (rc + 8));
+                MIX2_X4(temp1, temp2);
+
+                const __m512i a = _mm512_xor_si512(temp2, _mm512_xor_si512(temp1, acc));
+                const __m512i tempa3 = mulhrs_xor_x4(a, R);
+                nextAcc = _mm512_mask_blend_epi64(case10, nextAcc, a);
+                newX = _mm512_mask_blend_epi64(case10, newX, tempa3);
+                newR = _mm512_mask_blend_epi64(case10, newR, X);
+                prandLast |= case10;
+            }
+            if (case1c)
+            {
+                __m512i a = _mm512_xor_si512(clmul_x4(_mm512_xor_si512(B, X)), acc);
+                const __m512i tempa2 = mulhrs_xor_x4(a, X);
+                a = _mm512_xor_si512(_mm512_xor_si512(R, A), a);
+                const __m512i tempb2 = mulhrs_xor_x4(a, R);
+                nextAcc = _mm512_mask_blend_epi64(case1c, nextAcc, a);
+                newR = _mm512_mask_blend_epi64(case1c, newR, tempa2);
+                newX = _mm512_mask_blend_epi64(case1c, newX, tempb2);
+            }
+
+            // the two locations may be the same, so store in the order of the scalar code
+            alignas(64) __m128i storeR[4], storeX[4];
+            _mm512_store_si512(storeR, newR);
+            _mm512_store_si512(storeX, newX);
+            for (int lane = 0; lane < 4; lane++)
+            {
+                if (scalar & LANE_MASK(lane))
+                {
+                    continue;
+                }
+                if (prandLast & LANE_MASK(lane))
+                {
+                    _mm_store_si128((__m128i *)prandex[lane], storeX[lane]);
+                    _mm_store_si128((__m128i *)prand[lane], storeR[lane]);
+                }
+                else
+                {
+                    _mm_store_si128((__m128i *)prand[lane], storeR[lane]);
+                    _mm_store_si128((__m128i *)prandex[lane], storeX[lane]);
+                }
+            }
+        }
+
+        if (scalar)
+        {
+            _mm512_store_si512(lanes, acc);
+            for (int lane = 0; lane < 4; lane++)
+            {
+                if (scalar & LANE_MASK(lane))
+                {
+                    lanes[lane] = verusclhash_sv2_2_step(lanes[lane], key[lane], pbuf_copy[lane], keyMask, pMoveScratch[lane] + (i << 1));
+                }
+            }
+            nextAcc = _mm512_mask_blend_epi64(scalar, nextAcc, _mm512_load_si512(lanes));
+        }
+        acc = nextAcc;
+    }
+
+    // lazyLengthHash(1024, 64) and precompReduction64 on all four lanes
+    const __m128i lengthvector = _mm_set_epi64x(1024, 64);
+    acc = _mm512_xor_si512(acc, _mm512_broadcast_i32x4(_mm_clmulepi64_si128(lengthvector, lengthvector, 0x10)));
+
+    const __m512i C = _mm512_broadcast_i32x4(_mm_cvtsi64_si128((1U<<4)+(1U<<3)+(1U<<1)+(1U<<0)));
+    const __m512i Q2 = _mm512_clmulepi64_epi128(acc, C, 0x01);
+    const __m512i Q3 = _mm512_shuffle_epi8(_mm512_broadcast_i32x4(_mm_setr_epi8(0, 27, 54, 45, 108, 119, 90, 65, (char)216, (char)195, (char)238, (char)245, (char)180, (char)175, (char)130, (char)153)),
+                                           _mm512_bsrli_epi128(Q2, 8));
+    const __m512i final = _mm512_xor_si512(Q3, _mm512_xor_si512(Q2, acc));
+
+    alignas(64) uint64_t finals[8];
+    _mm512_store_si512(finals, final);
+    for (int lane = 0; lane < 4; lane++)
+    {
+        result[lane] = finals[lane << 1];
+    }
+}
@@ -40,268 +40,176 @@
 #include <intrin.h>
 #endif
 
-void clmul64(uint64_t a, uint64_t b, uint64_t* r)
+// The emulated intrinsics below only touch vector lanes through memcpy, so values stay in
+// registers and nothing is read through a pointer of another type. Type-punned access to
+// __m128i is undefined and GCC's strict aliasing optimizations have been seen to reorder it,
+// which silently produced wrong hashes at -O2.
+static inline __attribute__((always_inline)) uint64_t _mm_lane64_emu(const __m128i &a, int lane)
 {
-    uint8_t s = 4,i; //window size
-    uint64_t two_s = 1 << s; //2^s
-    uint64_t smask = two_s-1; //s 1 bits
-    uint64_t u[16];
-    uint64_t tmp;
-    uint64_t ifmask;
-    //Precomputation
-    u[0] = 0;
-    u[1] = b;
-    for(i = 2 ; i < two_s; i += 2){
-        u[i] = u[i >> 1] << 1; //even indices: left shift
-        u[i + 1] = u[i] ^ b; //odd indices: xor b
-    }
-    //Multiply
-    r[0] = u[a & smask]; //first window only affects lower word
-    r[1] = 0;
-    for(i = s ; i < 64 ; i += s){
-        tmp = u[a >> i & smask];     
-        r[0] ^= tmp << i;
-        r[1] ^= tmp >> (64 - i);
-    }
-    //Repair
-    uint64_t m = 0xEEEEEEEEEEEEEEEE; //s=4 => 16 times 1110
-    for(i = 1 ; i < s ; i++){
-        tmp = ((a & m) >> i);
-        m &= m << 1; //shift mask to exclude all bit j': j' mod s = i
-        ifmask = -((b >> (64-i)) & 1); //if the (64-i)th bit of b is 1
-        r[1] ^= (tmp & ifmask);
-    }
+    uint64_t v[2];
+    memcpy(v, &a, 16);
+    return v[lane];
 }
 
-u128 _mm_clmulepi64_si128_emu(const __m128i &a, const __m128i &b, int imm)
+static inline __attribute__((always_inline)) __m128i _mm_set_epi64x_emu(uint64_t hi, uint64_t lo)
 {
-    uint64_t result[2];
-    clmul64(*((uint64_t*)&a + (imm & 1)), *((uint64_t*)&b + ((imm & 0x10) >> 4)), result);
-
-    /*
-    // TEST
-    const __m128i tmp1 = _mm_load_si128(&a);
-    const __m128i tmp2 = _mm_load_si128(&b);
-    imm = imm & 0x11;
-    const __m128i testresult = (imm == 0x10) ? _mm_clmulepi64_si128(tmp1, tmp2, 0x10) : ((imm == 0x01) ? _mm_clmulepi64_si128(tmp1, tmp2, 0x01) : ((imm == 0x00) ? _mm_clmulepi64_si128(tmp1, tmp2, 0x00) : _mm_clmulepi64_si128(tmp1, tmp2, 0x11)));
-    if (!memcmp(&testresult, &result, 16))
-    {
-        printf("_mm_clmulepi64_si128_emu: Portable version passed!\n");
-    }
-    else
-    {
-        printf("_mm_clmulepi64_si128_emu: Portable version failed! a: %lxh %lxl, b: %lxh %lxl, imm: %x, emu: %lxh %lxl, intrin: %lxh %lxl\n", 
-               *((uint64_t *)&a + 1), *(uint64_t *)&a,
-               *((uint64_t *)&b + 1), *(uint64_t *)&b,
-               imm,
-               *((uint64_t *)result + 1), *(uint64_t *)result,
-               *((uint64_t *)&testresult + 1), *(uint64_t *)&testresult);
-        return testresult;
-    }
-    */
-
-    return *(__m128i *)result;
+    __m128i result;
+    uint64_t v[2] = { lo, hi };
+    memcpy(&result, v, 16);
+    return result;
 }
 
-u128 _mm_mulhrs_epi16_emu(__m128i _a, __m128i _b)
+// carry-less multiply of two 64 bit values, using a 4 bit window over a with the 16
+// multiples of b precomputed. a shifted out window can lose the top bits of b, which are
+// added back to the high word in the repair step.
+static inline __attribute__((always_inline)) void clmul64(uint64_t a, uint64_t b, uint64_t &lo, uint64_t &hi)
 {
-    int16_t result[8];
-    int16_t *a = (int16_t*)&_a, *b = (int16_t*)&_b;
-    for (int i = 0; i < 8; i ++)
-    {
-        result[i] = (int16_t)((((int32_t)(a[i]) * (int32_t)(b[i])) + 0x4000) >> 15);
-    }
+    uint64_t u[16];
+    uint64_t tmp, l, h;
 
-    /*
-    const __m128i testresult = _mm_mulhrs_epi16(_a, _b);
-    if (!memcmp(&testresult, &result, 16))
+    // precomputation
+    u[0] = 0;
+    u[1] = b;
+    u[2] = b << 1;
+    u[3] = u[2] ^ b;
+    u[4] = b << 2;
+    u[5] = u[4] ^ b;
+    u[6] = u[3] << 1;
+    u[7] = u[6] ^ b;
+    u[8] = b << 3;
+    u[9] = u[8] ^ b;
+    u[10] = u[5] << 1;
+    u[11] = u[10] ^ b;
+    u[12] = u[6] << 1;
+    u[13] = u[12] ^ b;
+    u[14] = u[7] << 1;
+    u[15] = u[14] ^ b;
+
+    // multiply, the first window only affects the lower word
+    l = u[a & 0xf];
+    h = 0;
+    for (int i = 4; i < 64; i += 4)
     {
-        printf("_mm_mulhrs_epi16_emu: Portable version passed!\n");
+        tmp = u[(a >> i) & 0xf];
+        l ^= tmp << i;
+        h ^= tmp >> (64 - i);
     }
-    else
+
+    // repair, for each of the top 3 bits of b that are set, add the bits of a that
+    // multiplied it without their product reaching the high word
+    uint64_t m = 0xEEEEEEEEEEEEEEEE;
+    for (int i = 1; i < 4; i++)
     {
-        printf("_mm_mulhrs_epi16_emu: Portable version failed! a: %lxh %lxl, b: %lxh %lxl, emu: %lxh %lxl, intrin: %lxh %lxl\n", 
-               *((uint64_t *)&a + 1), *(uint64_t *)&a,
-               *((uint64_t *)&b + 1), *(uint64_t *)&b,
-               *((uint64_t *)result + 1), *(uint64_t *)result,
-               *((uint64_t *)&testresult + 1), *(uint64_t *)&testresult);
+        tmp = (a & m) >> i;
+        m &= m << 1;
+        h ^= tmp & (0 - ((b >> (64 - i)) & 1));
     }
-    */
-
-    return *(__m128i *)result;
+    lo = l;
+    hi = h;
 }
 
-inline u128 _mm_set_epi64x_emu(uint64_t hi, uint64_t lo)
+static inline __attribute__((always_inline)) __m128i _mm_clmulepi64_si128_emu(const __m128i &a, const __m128i &b, int imm)
 {
-    __m128i result;
-    ((uint64_t *)&result)[0] = lo;
-    ((uint64_t *)&result)[1] = hi;
-    return result;
+    uint64_t lo, hi;
+    clmul64(_mm_lane64_emu(a, imm & 1), _mm_lane64_emu(b, (imm & 0x10) >> 4), lo, hi);
+    return _mm_set_epi64x_emu(hi, lo);
 }
 
-inline u128 _mm_cvtsi64_si128_emu(uint64_t lo)
+static inline __attribute__((always_inline)) __m128i _mm_mulhrs_epi16_emu(__m128i _a, __m128i _b)
 {
-    __m128i result;
-    ((uint64_t *)&result)[0] = lo;
-    ((uint64_t *)&result)[1] = 0;
-    return result;
+    int16_t a[8], b[8], result[8];
+    __m128i r;
+    memcpy(a, &_a, 16);
+    memcpy(b, &_b, 16);
+    for (int i = 0; i < 8; i++)
+    {
+        result[i] = (int16_t)((((int32_t)(a[i]) * (int32_t)(b[i])) + 0x4000) >> 15);
+    }
+    memcpy(&r, result, 16);
+    return r;
 }
 
-inline int64_t _mm_cvtsi128_si64_emu(const __m128i &a)
+static inline __attribute__((always_inline)) __m128i _mm_cvtsi64_si128_emu(uint64_t lo)
 {
-    return *(int64_t *)&a;
+    return _mm_set_epi64x_emu(0, lo);
 }
 
-inline int32_t _mm_cvtsi128_si32_emu(const __m128i &a)
+static inline __attribute__((always_inline)) int64_t _mm_cvtsi128_si64_emu(const __m128i &a)
 {
-    return *(int32_t *)&a;
+    return (int64_t)_mm_lane64_emu(a, 0);
 }
 
-inline u128 _mm_cvtsi32_si128_emu(uint32_t lo)
+static inline __attribute__((always_inline)) int32_t _mm_cvtsi128_si32_emu(const __m128i &a)
 {
-    __m128i result;
-    ((uint32_t *)&result)[0] = lo;
-    ((uint32_t *)&result)[1] = 0;
-    ((uint64_t *)&result)[1] = 0;
-
-    /*
-    const __m128i testresult = _mm_cvtsi32_si128(lo);
-    if (!memcmp(&testresult, &result, 16))
-    {
-        printf("_mm_cvtsi32_si128_emu: Portable version passed!\n");
-    }
-    else
-    {
-        printf("_mm_cvtsi32_si128_emu: Portable version failed!\n");
-    }
-    */
+    return (int32_t)_mm_lane64_emu(a, 0);
+}
 
-    return result;
+static inline __attribute__((always_inline)) __m128i _mm_cvtsi32_si128_emu(uint32_t lo)
+{
+    return _mm_set_epi64x_emu(0, lo);
 }
 
-u128 _mm_setr_epi8_emu(u_char c0, u_char c1, u_char c2, u_char c3, u_char c4, u_char c5, u_char c6, u_char c7, u_char c8, u_char c9, u_char c10, u_char c11, u_char c12, u_char c13, u_char c14, u_char c15)
+static inline __m128i _mm_setr_epi8_emu(uint8_t c0, uint8_t c1, uint8_t c2, uint8_t c3, uint8_t c4, uint8_t c5, uint8_t c6, uint8_t c7, uint8_t c8, uint8_t c9, uint8_t c10, uint8_t c11, uint8_t c12, uint8_t c13, uint8_t c14, uint8_t c15)
 {
+    const uint8_t bytes[16] = { c0, c1, c2, c3, c4, c5, c6, c7, c8, c9, c10, c11, c12, c13, c14, c15 };
     __m128i result;
-    ((uint8_t *)&result)[0] = c0;
-    ((uint8_t *)&result)[1] = c1;
-    ((uint8_t *)&result)[2] = c2;
-    ((uint8_t *)&result)[3] = c3;
-    ((uint8_t *)&result)[4] = c4;
-    ((uint8_t *)&result)[5] = c5;
-    ((uint8_t *)&result)[6] = c6;
-    ((uint8_t *)&result)[7] = c7;
-    ((uint8_t *)&result)[8] = c8;
-    ((uint8_t *)&result)[9] = c9;
-    ((uint8_t *)&result)[10] = c10;
-    ((uint8_t *)&result)[11] = c11;
-    ((uint8_t *)&result)[12] = c12;
-    ((uint8_t *)&result)[13] = c13;
-    ((uint8_t *)&result)[14] = c14;
-    ((uint8_t *)&result)[15] = c15;
-
-    /*
-    const __m128i testresult = _mm_setr_epi8(c0,c1,c2,c3,c4,c5,c6,c7,c8,c9,c10,c11,c12,c13,c14,c15);
-    if (!memcmp(&testresult, &result, 16))
-    {
-        printf("_mm_setr_epi8_emu: Portable version passed!\n");
-    }
-    else
-    {
-        printf("_mm_setr_epi8_emu: Portable version failed!\n");
-    }
-    */
-
+    memcpy(&result, bytes, 16);
     return result;
 }
 
-inline __m128i _mm_srli_si128_emu(__m128i a, int imm8)
+static inline __attribute__((always_inline)) __m128i _mm_srli_si128_emu(__m128i a, int imm8)
 {
-    unsigned char result[16];
-    uint8_t shift = imm8 & 0xff;
-    if (shift > 15) shift = 16;
+    uint64_t lo = _mm_lane64_emu(a, 0), hi = _mm_lane64_emu(a, 1);
+    unsigned int shift = imm8 & 0xff;
 
-    int i;
-    for (i = 0; i < (16 - shift); i++)
-    {
-        result[i] = ((unsigned char *)&a)[shift + i];
-    }
-    for ( ; i < 16; i++)
+    if (shift > 15)
     {
-        result[i] = 0;
+        return _mm_set_epi64x_emu(0, 0);
     }
-
-    /*
-    const __m128i tmp1 = _mm_load_si128(&a);
-    __m128i testresult = _mm_srli_si128(tmp1, imm8);
-    if (!memcmp(&testresult, result, 16))
+    else if (shift >= 8)
     {
-        printf("_mm_srli_si128_emu: Portable version passed!\n");
+        return _mm_set_epi64x_emu(0, hi >> ((shift - 8) << 3));
     }
-    else
+    else if (shift)
     {
-        printf("_mm_srli_si128_emu: Portable version failed! val: %lx%lx imm: %x emu: %lx%lx, intrin: %lx%lx\n", 
-               *((uint64_t *)&a + 1), *(uint64_t *)&a,
-               imm8,
-               *((uint64_t *)result + 1), *(uint64_t *)result,
-               *((uint64_t *)&testresult + 1), *(uint64_t *)&testresult);
+        return _mm_set_epi64x_emu(hi >> (shift << 3), (lo >> (shift << 3)) | (hi << ((8 - shift) << 3)));
     }
-    */
-
-    return *(__m128i *)result;
+    return a;
 }
 
-inline __m128i _mm_xor_si128_emu(__m128i a, __m128i b)
+static inline __attribute__((always_inline)) __m128i _mm_xor_si128_emu(__m128i a, __m128i b)
 {
 #ifdef _WIN32
-    uint64_t result[2];
-    result[0] = *(uint64_t *)&a ^ *(uint64_t *)&b;
-    result[1] = *((uint64_t *)&a + 1) ^ *((uint64_t *)&b + 1);
-    return *(__m128i *)result;
+    return _mm_set_epi64x_emu(_mm_lane64_emu(a, 1) ^ _mm_lane64_emu(b, 1), _mm_lane64_emu(a, 0) ^ _mm_lane64_emu(b, 0));
 #else
     return a ^ b;
 #endif
 }
 
-inline __m128i _mm_load_si128_emu(const void *p)
+static inline __attribute__((always_inline)) __m128i _mm_load_si128_emu(const void *p)
 {
-    return *(__m128i *)p;
+    __m128i result;
+    memcpy(&result, p, 16);
+    return result;
 }
 
-inline void _mm_store_si128_emu(void *p, __m128i val)
+static inline __attribute__((always_inline)) void _mm_store_si128_emu(void *p, __m128i val)
 {
-    *(__m128i *)p = val;
+    memcpy(p, &val, 16);
 }
 
-__m128i _mm_shuffle_epi8_emu(__m128i a, __m128i b)
+static inline __m128i _mm_shuffle_epi8_emu(__m128i a, __m128i b)
 {
-    __m128i result;
+    uint8_t ab[16], bb[16], result[16];
+    __m128i r;
+    memcpy(ab, &a, 16);
+    memcpy(bb, &b, 16);
     for (int i = 0; i < 16; i++)
     {
-        if (((uint8_t *)&b)[i] & 0x80)
-        {
-            ((uint8_t *)&result)[i] = 0;
-        }
-        else
-        {
-            ((uint8_t *)&result)[i] = ((uint8_t *)&a)[((uint8_t *)&b)[i] & 0xf];
-        }
-    }
-
-    /*
-    const __m128i tmp1 = _mm_load_si128(&a);
-    const __m128i tmp2 = _mm_load_si128(&b);
-    __m128i testresult = _mm_shuffle_epi8(tmp1, tmp2);
-    if (!memcmp(&testresult, &result, 16))
-    {
-        printf("_mm_shuffle_epi8_emu: Portable version passed!\n");
+        result[i] = (bb[i] & 0x80) ? 0 : ab[bb[i] & 0xf];
     }
-    else
-    {
-        printf("_mm_shuffle_epi8_emu: Portable version failed!\n");
-    }
-    */
-
-    return result;
+    memcpy(&r, result, 16);
+    return r;
 }
 
 // portable
@@ -1197,3 +1105,10 @@ uint64_t verusclhash_sv2_2_port(void * random, const unsigned char buf[64], uint
     acc = _mm_xor_si128_emu(acc, lazyLengthHash_port(1024, 64));
     return precompReduction64_port(acc);
 }
+
+void verusclhash_sv2_2_x4_port(void *random[4], const unsigned char *buf[4], uint64_t keyMask, __m128i **pMoveScratch[4], uint64_t result[4]) {
+    for (int lane = 0; lane < 4; lane++)
+    {
+        result[lane] = verusclhash_sv2_2_port(random[lane], buf[lane], keyMask, pMoveScratch[lane]);
+    }
+}
@@ -0,0 +1,225 @@
+// (C) 2018 The Verus Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+/*
+Per thread CLHash case and key access counters for CVerusCLHashStats, see verus_clhash_stats.h.
+*/
+
+#include <stdio.h>
+#include <string.h>
+
+#include <algorithm>
+#include <mutex>
+#include <vector>
+
+#include "verus_clhash_stats.h"
+#include "verus_thread_counters.h"
+
+// loop iterations and key accesses of one hash
+static const int CLHASH_ITERATIONS = 32;
+static const int CLHASH_ACCESSES = CLHASH_ITERATIONS * 2;
+
+struct CVerusCLHashCounters
+{
+    std::atomic<uint64_t> hashes[VERUS_CLHASH_VERSIONS];
+    std::atomic<uint64_t> cases[VERUS_CLHASH_VERSIONS][8];
+    std::atomic<uint64_t> prand[VERUS_CLHASH_STATS_ENTRIES];
+    std::atomic<uint64_t> prandex[VERUS_CLHASH_STATS_ENTRIES];
+    std::atomic<uint64_t> reuse[CLHASH_ACCESSES];
+    std::atomic<uint64_t> lines[CLHASH_ACCESSES + 1];
+
+    // the key entries accessed so far in the current hash, only used by the owning thread
+    uint64_t trace[CLHASH_ACCESSES];
+    int traced = 0;
+
+    CVerusCLHashCounters()
+    {
+        std::atomic<uint64_t> *all[] = {&hashes[0], &cases[0][0], prand, prandex, reuse, lines};
+        size_t sizes[] = {VERUS_CLHASH_VERSIONS, VERUS_CLHASH_VERSIONS * 8, VERUS_CLHASH_STATS_ENTRIES,
+                          VERUS_CLHASH_STATS_ENTRIES, CLHASH_ACCESSES, CLHASH_ACCESSES + 1};
+        for (int i = 0; i < 6; i++)
+        {
+            for (size_t j = 0; j < sizes[i]; j++)
+            {
+                all[i][j].store(0, std::memory_order_relaxed);
+            }
+        }
+    }
+
+    void Access(uint64_t entry)
+    {
+        int distance = 0;
+        for (int j = traced - 1; j >= 0; j--)
+        {
+            if (trace[j] == entry)
+            {
+                distance = traced - j;
+                break;
+            }
+        }
+        VerusCounterAdd(reuse[distance], 1);
+        if (traced < CLHASH_ACCESSES)
+        {
+            trace[traced++] = entry;
+        }
+    }
+
+    // distinct 64 byte lines in the trace, four entries each
+    int Lines() const
+    {
+        uint64_t line[CLHASH_ACCESSES];
+        for (int j = 0; j < traced; j++)
+        {
+            line[j] = trace[j] >> 2;
+        }
+        std::sort(line, line + traced);
+        return std::unique(line, line + traced) - line;
+    }
+};
+
+typedef CVerusThreadCounters<CVerusCLHashCounters> CVerusCLHashThreads;
+
+// the totals at the last Reset, see verus_stage_stats.cpp
+static std::mutex &resetLock = *new std::mutex;
+static CVerusCLHashStatsSnapshot &resetTotals = *new CVerusCLHashStatsSnapshot();
+
+static void sum_counters(CVerusCLHashStatsSnapshot &s)
+{
+    memset(&s, 0, sizeof(s));
+    CVerusCLHashThreads::ForEach([&](const CVerusCLHashCounters &c) {
+        for (int v = 0; v < VERUS_CLHASH_VERSIONS; v++)
+        {
+            s.hashes[v] += c.hashes[v].load(std::memory_order_relaxed);
+            for (int j = 0; j < 8; j++)
+            {
+                s.cases[v][j] += c.cases[v][j].load(std::memory_order_relaxed);
+            }
+        }
+        for (int j = 0; j < VERUS_CLHASH_STATS_ENTRIES; j++)
+        {
+            s.prand[j] += c.prand[j].load(std::memory_order_relaxed);
+            s.prandex[j] += c.prandex[j].load(std::memory_order_relaxed);
+        }
+        for (int j = 0; j <= CLHASH_ACCESSES; j++)
+        {
+            if (j < CLHASH_ACCESSES)
+            {
+                s.reuse[j] += c.reuse[j].load(std::memory_order_relaxed);
+            }
+            s.lines[j] += c.lines[j].load(std::memory_order_relaxed);
+        }
+    });
+}
+
+bool CVerusCLHashStats::Enabled()
+{
+#ifdef VERUSHASH_CLHASH_STATS
+    return true;
+#else
+    return false;
+#endif
+}
+
+void CVerusCLHashStats::Step(int version, int iteration, uint64_t selector, uint64_t prand, uint64_t prandex)
+{
+    CVerusCLHashCounters &c = CVerusCLHashThreads::Local();
+    if (iteration == 0)
+    {
+        c.traced = 0;
+        VerusCounterAdd(c.hashes[version], 1);
+    }
+    VerusCounterAdd(c.cases[version][(selector & 0x1c) >> 2], 1);
+    VerusCounterAdd(c.prand[prand % VERUS_CLHASH_STATS_ENTRIES], 1);
+    VerusCounterAdd(c.prandex[prandex % VERUS_CLHASH_STATS_ENTRIES], 1);
+    c.Access(prand);
+    c.Access(prandex);
+    if (iteration == CLHASH_ITERATIONS - 1)
+    {
+        VerusCounterAdd(c.lines[c.Lines()], 1);
+    }
+}
+
+void CVerusCLHashStats::Snapshot(CVerusCLHashStatsSnapshot &snapshot)
+{
+    std::lock_guard<std::mutex> lock(resetLock);
+    sum_counters(snapshot);
+
+    uint64_t *now = (uint64_t *)&snapshot;
+    const uint64_t *base = (const uint64_t *)&resetTotals;
+    for (size_t i = 0; i < sizeof(snapshot) / sizeof(uint64_t); i++)
+    {
+        now[i] -= base[i];
+    }
+}
+
+std::string CVerusCLHashStats::Report()
+{
+    static const char *versionNames[VERUS_CLHASH_VERSIONS] = {"sv2", "sv2_1", "sv2_2"};
+    std::vector<CVerusCLHashStatsSnapshot> snapshot(1);
+    CVerusCLHashStatsSnapshot &s = snapshot[0];
+    std::string report;
+    char line[200];
+
+    Snapshot(s);
+    for (int v = 0; v < VERUS_CLHASH_VERSIONS; v++)
+    {
+        if (!s.hashes[v])
+        {
+            continue;
+        }
+        snprintf(line, sizeof(line), "%-5s %10llu hashes, cases", versionNames[v], (unsigned long long)s.hashes[v]);
+        report += line;
+        for (int j = 0; j < 8; j++)
+        {
+            snprintf(line, sizeof(line), " 0x%02x %.1f%%", j << 2, 100.0 * s.cases[v][j] / (s.hashes[v] * CLHASH_ITERATIONS));
+            report += line;
+        }
+        report += "\n";
+    }
+
+    uint64_t accesses = 0, hashes = 0, lines = 0, near = 0;
+    for (int j = 0; j < CLHASH_ACCESSES; j++)
+    {
+        accesses += s.reuse[j];
+        near += (j > 0 && j <= 8) ? s.reuse[j] : 0;
+    }
+    for (int j = 0; j <= CLHASH_ACCESSES; j++)
+    {
+        hashes += s.lines[j];
+        lines += s.lines[j] * j;
+    }
+    if (!accesses || !hashes)
+    {
+        return report;
+    }
+
+    // how evenly the key entries are used
+    const uint64_t *counts[2] = {s.prand, s.prandex};
+    const char *names[2] = {"prand", "prandex"};
+    for (int k = 0; k < 2; k++)
+    {
+        uint64_t least = counts[k][0], most = counts[k][0];
+        for (int j = 1; j < VERUS_CLHASH_STATS_ENTRIES; j++)
+        {
+            least = std::min(least, counts[k][j]);
+            most = std::max(most, counts[k][j]);
+        }
+        snprintf(line, sizeof(line), "%-7s entries used %llu to %llu times, %.1f average\n", names[k],
+                 (unsigned long long)least, (unsigned long long)most, (double)accesses / 2 / VERUS_CLHASH_STATS_ENTRIES);
+        report += line;
+    }
+    snprintf(line, sizeof(line), "reuse   %.1f%% first accesses, %.1f%% within 8 accesses\n",
+             100.0 * s.reuse[0] / accesses, 100.0 * near / accesses);
+    report += line;
+    snprintf(line, sizeof(line), "lines   %.1f distinct 64 byte key lines per hash, %d bytes\n",
+             (double)lines / hashes, (int)(64 * lines / hashes));
+    report += line;
+    return report;
+}
+
+void CVerusCLHashStats::Reset()
+{
+    std::lock_guard<std::mutex> lock(resetLock);
+    sum_counters(resetTotals);
+}
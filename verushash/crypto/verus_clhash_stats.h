@@ -0,0 +1,71 @@
+// (C) 2018 The Verus Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+/*
+What the CLHash loops do with their input, for deciding which kernel cases are worth optimizing
+and how much of the key a hash really touches. It only exists in builds configured with
+-DVERUSHASH_CLHASH_STATS=ON, which defines VERUSHASH_CLHASH_STATS for every file. Without it
+VERUS_CLHASH_TRACE is empty and the loops are unchanged.
+
+Every iteration of the sv2, sv2_1 and sv2_2 loops of the pclmul kernels, in verus_clhash.cpp
+and its x86-64-v3 and v4 builds, records into counters of the calling thread:
+
+    cases       the selector & 0x1c case taken, per CLHash version
+    prand       how often each 16 byte key entry is prand, the entry read and written first
+    prandex     the same for prandex
+    reuse       for each of the 64 key accesses of a hash, prand then prandex of each iteration,
+                how many accesses ago the same entry was last accessed in that hash, or 0 if this
+                is the first access
+    lines       the number of distinct 64 byte cache lines of the key each hash touches
+
+The portable kernel and the four lane sv2_2 kernels are not instrumented. Recording costs a
+call per iteration, so timings from these builds are not representative.
+*/
+#ifndef VERUS_CLHASH_STATS_H_
+#define VERUS_CLHASH_STATS_H_
+
+#include <stdint.h>
+#include <string>
+
+#include "verus_kernels.h"
+
+// key entries counted separately, a key with more wraps around onto these
+#define VERUS_CLHASH_STATS_ENTRIES 512
+
+struct CVerusCLHashStatsSnapshot
+{
+    uint64_t hashes[VERUS_CLHASH_VERSIONS];
+    uint64_t cases[VERUS_CLHASH_VERSIONS][8];           // by (selector & 0x1c) >> 2
+    uint64_t prand[VERUS_CLHASH_STATS_ENTRIES];
+    uint64_t prandex[VERUS_CLHASH_STATS_ENTRIES];
+    uint64_t reuse[64];
+    uint64_t lines[65];
+};
+
+class CVerusCLHashStats
+{
+    public:
+        // true if the library was built with VERUSHASH_CLHASH_STATS
+        static bool Enabled();
+
+        // one loop iteration, with the offsets of prand and prandex in 16 byte entries
+        static void Step(int version, int iteration, uint64_t selector, uint64_t prand, uint64_t prandex);
+
+        // totals of all threads since the last Reset
+        static void Snapshot(CVerusCLHashStatsSnapshot &snapshot);
+
+        // the case mix, the most used key entries and the reuse and footprint summaries as text
+        static std::string Report();
+
+        static void Reset();
+};
+
+#ifdef VERUSHASH_CLHASH_STATS
+#define VERUS_CLHASH_TRACE(version, iteration, selector, randomsource, prand, prandex) \
+    CVerusCLHashStats::Step(version, iteration, selector, (prand) - (randomsource), (prandex) - (randomsource))
+#else
+#define VERUS_CLHASH_TRACE(version, iteration, selector, randomsource, prand, prandex)
+#endif
+
+#endif
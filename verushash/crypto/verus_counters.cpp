@@ -0,0 +1,80 @@
+// (C) 2018 The Verus Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+/*
+Totals and the C API of the runtime counters, see verus_counters.h.
+*/
+
+#include <string.h>
+
+#include <string>
+
+#include "verus_counters.h"
+#include "verus_kernels.h"
+
+static const char *counterNames[VERUS_COUNTERS] = {
+    "hashes_v1", "hashes_v2", "hashes_v2b", "hashes_v2b1", "hashes_v2b2", "bytes",
+    "key_generations", "key_restores", "key_allocations", "key_frees", "parse_failures", "key_releases"
+};
+
+static std::atomic<uint64_t> sharedCounters[VERUS_COUNTERS];
+
+void CVerusCounters::AddShared(int counter, uint64_t n)
+{
+    sharedCounters[counter].fetch_add(n, std::memory_order_relaxed);
+}
+
+uint64_t CVerusCounters::Get(int counter)
+{
+    if (counter < 0 || counter >= VERUS_COUNTERS)
+    {
+        return 0;
+    }
+    uint64_t total = sharedCounters[counter].load(std::memory_order_relaxed);
+    CVerusThreadCounters<CVerusCounterSet>::ForEach([&](const CVerusCounterSet &c) {
+        total += c.values[counter].load(std::memory_order_relaxed);
+    });
+    return total;
+}
+
+uint64_t verushash_counter(int counter)
+{
+    return CVerusCounters::Get(counter);
+}
+
+int verushash_counters(uint64_t *values, int count)
+{
+    if (count > VERUS_COUNTERS)
+    {
+        count = VERUS_COUNTERS;
+    }
+    for (int i = 0; i < count; i++)
+    {
+        values[i] = sharedCounters[i].load(std::memory_order_relaxed);
+    }
+    CVerusThreadCounters<CVerusCounterSet>::ForEach([&](const CVerusCounterSet &c) {
+        for (int i = 0; i < count; i++)
+        {
+            values[i] += c.values[i].load(std::memory_order_relaxed);
+        }
+    });
+    return VERUS_COUNTERS;
+}
+
+const char *verushash_counter_name(int counter)
+{
+    return (counter >= 0 && counter < VERUS_COUNTERS) ? counterNames[counter] : NULL;
+}
+
+int verushash_selected_kernels(char *buf, int len)
+{
+    std::string kernels = std::string("haraka=") + CVerusKernels::Haraka()->name +
+                          ",clhash=" + CVerusKernels::CLHash()->name +
+                          ",sha256=" + CVerusKernels::SHA256()->name;
+    if (buf && len > (int)kernels.size())
+    {
+        memcpy(buf, kernels.c_str(), kernels.size() + 1);
+    }
+    return kernels.size();
+}
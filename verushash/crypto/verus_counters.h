@@ -0,0 +1,107 @@
+// (C) 2018 The Verus Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+/*
+Runtime counters of what the library does, always built in, for watching it in production:
+
+    hashes      finished hashes of each version, one-shot, streaming or batched
+    bytes       input bytes absorbed by all versions
+    key         GenNewCLKey calls that generated a new key and those that only restored the
+                current one for the same seed, and the thread local key buffers allocated and
+                freed, which climb together when threads come and go, and the keys of idle
+                threads released early, see verus_memory.h
+    parse       serialized headers that verushash_v2b2 could not deserialize
+
+Hashing threads count into counters of their own, see verus_thread_counters.h, and a read adds
+up all threads. The totals are since the process started and never go down.
+
+The C API is for the Go binding and other foreign callers:
+
+    uint64_t values[VERUS_COUNTERS];
+    verushash_counters(values, VERUS_COUNTERS);
+    printf("%s %llu\n", verushash_counter_name(0), (unsigned long long)values[0]);
+*/
+#ifndef VERUS_COUNTERS_H_
+#define VERUS_COUNTERS_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+enum {
+    VERUS_COUNTER_HASHES_V1 = 0,
+    VERUS_COUNTER_HASHES_V2 = 1,
+    VERUS_COUNTER_HASHES_V2B = 2,
+    VERUS_COUNTER_HASHES_V2B1 = 3,
+    VERUS_COUNTER_HASHES_V2B2 = 4,
+    VERUS_COUNTER_BYTES = 5,
+    VERUS_COUNTER_KEY_GENERATIONS = 6,  // GenNewCLKey for a new seed, the full Haraka256 chain
+    VERUS_COUNTER_KEY_RESTORES = 7,     // GenNewCLKey for the current seed, a copy of the mutated part
+    VERUS_COUNTER_KEY_ALLOCATIONS = 8,
+    VERUS_COUNTER_KEY_FREES = 9,
+    VERUS_COUNTER_PARSE_FAILURES = 10,
+    VERUS_COUNTER_KEY_RELEASES = 11,    // idle thread keys freed by verushash_release_idle_keys
+    VERUS_COUNTERS = 12
+};
+
+// the total of one counter, or 0 for an unknown one
+uint64_t verushash_counter(int counter);
+
+// the totals of the first count counters into values, returning VERUS_COUNTERS
+int verushash_counters(uint64_t *values, int count);
+
+// a lower case name for each counter, such as "hashes_v2b2", or NULL for an unknown one
+const char *verushash_counter_name(int counter);
+
+// the selected kernels as "haraka=<name>,clhash=<name>,sha256=<name>", written to buf with a
+// terminating zero if it fits in len bytes. returns the length without the terminator
+int verushash_selected_kernels(char *buf, int len);
+
+#ifdef __cplusplus
+} // extern "C"
+
+#include "verus_thread_counters.h"
+
+struct CVerusCounterSet
+{
+    std::atomic<uint64_t> values[VERUS_COUNTERS];
+
+    CVerusCounterSet()
+    {
+        for (int i = 0; i < VERUS_COUNTERS; i++)
+        {
+            values[i].store(0, std::memory_order_relaxed);
+        }
+    }
+};
+
+class CVerusCounters
+{
+    public:
+        // counts into the calling thread's counters
+        static inline void Add(int counter, uint64_t n = 1)
+        {
+            VerusCounterAdd(CVerusThreadCounters<CVerusCounterSet>::Local().values[counter], n);
+        }
+
+        // counts into one shared atomic counter, for rare events and for thread exit, when
+        // the thread's own counters may already be gone
+        static void AddShared(int counter, uint64_t n = 1);
+
+        // one finished hash and its input bytes
+        static inline void AddHash(int counter, uint64_t bytes)
+        {
+            CVerusCounterSet &c = CVerusThreadCounters<CVerusCounterSet>::Local();
+            VerusCounterAdd(c.values[counter], 1);
+            VerusCounterAdd(c.values[VERUS_COUNTER_BYTES], bytes);
+        }
+
+        static uint64_t Get(int counter);
+};
+#endif
+
+#endif
@@ -11,63 +11,226 @@ bit output.
 #include <string.h>
 #include "common.h"
 #include "verus_hash.h"
+#include "verus_latency.h"
 
-void (*CVerusHash::haraka512Function)(unsigned char *out, const unsigned char *in);
+// the CLHash key of each thread, here rather than with the kernels in verus_clhash.cpp, which
+// is also built for other feature levels
+thread_local thread_specific_ptr verusclhasher_key(VERUS_COUNTER_KEY_FREES, VERUS_MEMORY_KEYS);
+thread_local thread_specific_ptr verusclhasher_descr(-1, VERUS_MEMORY_KEY_DESCRIPTORS);
 
-void CVerusHash::Hash(void *result, const void *data, size_t _len)
+#if defined(__APPLE__) || defined(_WIN32)
+// attempt to workaround horrible mingw/gcc destructor bug on Windows and Mac, which passes garbage in the this pointer
+// we use the opportunity of control here to clean up all of our tls variables. we could keep a list, but this is a safe,
+// functional hack
+thread_specific_ptr::~thread_specific_ptr() {
+    if (verusclhasher_key.ptr)
+    {
+        verusclhasher_key.reset();
+    }
+    if (verusclhasher_descr.ptr)
+    {
+        verusclhasher_descr.reset();
+    }
+}
+#endif // defined(__APPLE__) || defined(_WIN32)
+
+void *alloc_aligned_buffer(uint64_t bufSize)
 {
-    unsigned char buf[128];
-    unsigned char *bufPtr = buf;
-    int nextOffset = 64;
-    uint32_t pos = 0, len = _len;
-    unsigned char *bufPtr2 = bufPtr + nextOffset;
-    unsigned char *ptr = (unsigned char *)data;
+    void *answer = NULL;
+    if (posix_memalign(&answer, sizeof(__m128i)*2, bufSize))
+    {
+        return NULL;
+    }
+    else
+    {
+        return answer;
+    }
+}
 
-    // put our last result or zero at beginning of buffer each time
-    memset(bufPtr, 0, 32);
+// chains Haraka512 over the input 32 bytes at a time, each block hashed after the last result,
+// or zero for the first. the chaining value stays in result and full blocks are read where they
+// are, only a short last block is zero padded in a copy
+static inline void verus_hash_chain(VerusHarakaChainFunction haraka512Function, unsigned char *result, const unsigned char *data, size_t len)
+{
+    size_t full = len & ~(size_t)31;
 
-    // digest up to 32 bytes at a time
-    for ( ; pos < len; pos += 32)
+    memset(result, 0, 32);
+    for (size_t pos = 0; pos < full; pos += 32)
+    {
+        (*haraka512Function)(result, result, data + pos);
+    }
+    if (len > full)
+    {
+        alignas(16) unsigned char last[32] = {0};
+        memcpy(last, data + full, len - full);
+        (*haraka512Function)(result, result, last);
+    }
+}
+
+void CVerusHash::Hash(void *result, const void *data, size_t len)
+{
+    CVerusCounters::AddHash(VERUS_COUNTER_HASHES_V1, len);
+    alignas(32) unsigned char hash[32];
+    verus_hash_chain(CVerusKernels::Haraka()->haraka512ZeroChain, hash, (const unsigned char *)data, len);
+    memcpy(result, hash, 32);
+}
+
+void CVerusHash::HashAligned(unsigned char *result, const void *data, size_t len)
+{
+    CVerusCounters::AddHash(VERUS_COUNTER_HASHES_V1, len);
+    verus_hash_chain(CVerusKernels::Haraka()->haraka512ZeroChain, result, (const unsigned char *)data, len);
+}
+
+// the Haraka kernels store each result as four 8 byte words. reading them back the same way
+// lets the stores forward to the loads, a 16 or 32 byte load from them would stall. the 8 byte
+// loads go through the may_alias vector type, as memcpy is merged into 16 byte loads
+static inline __m128i load_words(const unsigned char *src)
+{
+    return _mm_unpacklo_epi64(_mm_loadl_epi64((const __m128i *)src), _mm_loadl_epi64((const __m128i *)(src + 8)));
+}
+
+static inline void copy_result(unsigned char *dest, const unsigned char *src)
+{
+    _mm_store_si128((__m128i *)dest, load_words(src));
+    _mm_store_si128((__m128i *)dest + 1, load_words(src + 16));
+}
+
+void CVerusHash::HashBatch(unsigned char *results, const unsigned char *const *data, const size_t *len, size_t count)
+{
+    CVerusLatencyTimer latency(VERUS_LATENCY_HASH_BATCH, VERUS_COUNTER_HASHES_V1);
+    const CVerusHarakaKernel *pk = CVerusKernels::Haraka();
+    VerusHarakaFunction harakaLanes = count >= 8 ? pk->haraka512Zero8x : pk->haraka512Zero4x;
+    int lanes = count >= 8 ? 8 : 4;
+
+    size_t bytes = 0;
+    for (size_t i = 0; i < count; i++)
+    {
+        bytes += len[i];
+    }
+    VERUS_PROBE2(batch_start, count, bytes);
+
+    if (count < 4)
     {
-        if (len - pos >= 32)
+        for (size_t i = 0; i < count; i++)
         {
-            memcpy(bufPtr + 32, ptr + pos, 32);
+            Hash(results + (i << 5), data[i], len[i]);
         }
-        else
+        VERUS_PROBE1(batch_end, count);
+        return;
+    }
+
+    CVerusCounters::Add(VERUS_COUNTER_HASHES_V1, count);
+    CVerusCounters::Add(VERUS_COUNTER_BYTES, bytes);
+
+    // each lane chains one input at a time, 32 bytes of the last result, or zero, then the next
+    // 32 bytes of input, as in Hash. a lane that finishes takes the next input
+    alignas(32) unsigned char buf[8 * 64] = {0}, out[8 * 32];
+    size_t input[8], pos[8];
+    size_t next = 0;
+    int active = 0;
+
+    auto start = [&](int lane) -> bool
+    {
+        // empty inputs hash to zero and never take a lane
+        while (next < count && !len[next])
         {
-            int i = (int)(len - pos);
-            memcpy(bufPtr + 32, ptr + pos, i);
-            memset(bufPtr + 32 + i, 0, 32 - i);
+            memset(results + (next++ << 5), 0, 32);
         }
-        (*haraka512Function)(bufPtr2, bufPtr);
-        bufPtr2 = bufPtr;
-        bufPtr += nextOffset;
-        nextOffset *= -1;
-    }
-    memcpy(result, bufPtr, 32);
-};
+        if (next == count)
+        {
+            return false;
+        }
+        input[lane] = next++;
+        pos[lane] = 0;
+        memset(buf + (lane << 6), 0, 32);
+        return true;
+    };
 
-void CVerusHash::init()
-{
-    if (IsCPUVerusOptimized())
+    for (int lane = 0; lane < lanes; lane++)
     {
-        haraka512Function = &haraka512_zero;
+        active += start(lane) ? 1 << lane : 0;
     }
-    else
+
+    while (active)
     {
-        haraka512Function = &haraka512_port_zero;
+        for (int lane = 0; lane < lanes; lane++)
+        {
+            if (active & (1 << lane))
+            {
+                size_t left = len[input[lane]] - pos[lane];
+                unsigned char *block = buf + (lane << 6) + 32;
+                if (left >= 32)
+                {
+                    memcpy(block, data[input[lane]] + pos[lane], 32);
+                }
+                else
+                {
+                    memcpy(block, data[input[lane]] + pos[lane], left);
+                    memset(block + left, 0, 32 - left);
+                }
+            }
+        }
+
+        (*harakaLanes)(out, buf);
+
+        for (int lane = 0; lane < lanes; lane++)
+        {
+            if (active & (1 << lane))
+            {
+                copy_result(buf + (lane << 6), out + (lane << 5));
+                pos[lane] += 32;
+                if (pos[lane] >= len[input[lane]])
+                {
+                    memcpy(results + (input[lane] << 5), out + (lane << 5), 32);
+                    if (!start(lane))
+                    {
+                        active &= ~(1 << lane);
+                    }
+                }
+            }
+        }
+
+        // once only the tail is left, move it into four lanes if it fits
+        if (lanes == 8 && next == count && __builtin_popcount(active) <= 4)
+        {
+            for (int lane = 4, free = 0; lane < 8; lane++)
+            {
+                if (active & (1 << lane))
+                {
+                    while (active & (1 << free))
+                    {
+                        free++;
+                    }
+                    memcpy(buf + (free << 6), buf + (lane << 6), 32);
+                    input[free] = input[lane];
+                    pos[free] = pos[lane];
+                    active = (active & ~(1 << lane)) | (1 << free);
+                }
+            }
+            lanes = 4;
+            harakaLanes = pk->haraka512Zero4x;
+        }
     }
+    VERUS_PROBE1(batch_end, count);
+}
+
+void CVerusHash::init()
+{
+    CVerusKernels::Init();
 }
 
 CVerusHash &CVerusHash::Write(const unsigned char *data, size_t _len)
 {
     unsigned char *tmp;
-    uint32_t pos, len = _len;
+    size_t pos, len = _len;
+    VerusHarakaFunction haraka512Function = CVerusKernels::Haraka()->haraka512Zero;
+
+    CVerusCounters::Add(VERUS_COUNTER_BYTES, len);
 
     // digest up to 32 bytes at a time
     for ( pos = 0; pos < len; )
     {
-        uint32_t room = 32 - curPos;
+        size_t room = 32 - curPos;
 
         if (len - pos >= room)
         {
@@ -95,70 +258,37 @@ void verus_hash(void *result, const void *data, size_t len)
     return CVerusHash::Hash(result, data, len);
 }
 
-void (*CVerusHashV2::haraka512Function)(unsigned char *out, const unsigned char *in);
-void (*CVerusHashV2::haraka512KeyedFunction)(unsigned char *out, const unsigned char *in, const u128 *rc);
-void (*CVerusHashV2::haraka256Function)(unsigned char *out, const unsigned char *in);
-
 void CVerusHashV2::init()
 {
-    if (IsCPUVerusOptimized())
-    {
-        load_constants();
-        haraka512Function = &haraka512;
-        haraka512KeyedFunction = &haraka512_keyed;
-        haraka256Function = &haraka256;
-    }
-    else
-    {
-        // load the haraka constants
-        load_constants_port();
-        haraka512Function = &haraka512_port;
-        haraka512KeyedFunction = &haraka512_port_keyed;
-        haraka256Function = &haraka256_port;
-    }
+    CVerusKernels::Init();
 }
 
-void CVerusHashV2::Hash(void *result, const void *data, size_t _len)
+void CVerusHashV2::Hash(void *result, const void *data, size_t len)
 {
-    unsigned char buf[128];
-    unsigned char *bufPtr = buf;
-    int len = _len, pos = 0, nextOffset = 64;
-    unsigned char *bufPtr2 = bufPtr + nextOffset;
-    unsigned char *ptr = (unsigned char *)data;
-
-    // put our last result or zero at beginning of buffer each time
-    memset(bufPtr, 0, 32);
+    CVerusCounters::AddHash(VERUS_COUNTER_HASHES_V2, len);
+    alignas(32) unsigned char hash[32];
+    verus_hash_chain(CVerusKernels::Haraka()->haraka512Chain, hash, (const unsigned char *)data, len);
+    memcpy(result, hash, 32);
+}
 
-    // digest up to 32 bytes at a time
-    for ( ; pos < len; pos += 32)
-    {
-        if (len - pos >= 32)
-        {
-            memcpy(bufPtr + 32, ptr + pos, 32);
-        }
-        else
-        {
-            int i = (int)(len - pos);
-            memcpy(bufPtr + 32, ptr + pos, i);
-            memset(bufPtr + 32 + i, 0, 32 - i);
-        }
-        (*haraka512Function)(bufPtr2, bufPtr);
-        bufPtr2 = bufPtr;
-        bufPtr += nextOffset;
-        nextOffset *= -1;
-    }
-    memcpy(result, bufPtr, 32);
-};
+void CVerusHashV2::HashAligned(unsigned char *result, const void *data, size_t len)
+{
+    CVerusCounters::AddHash(VERUS_COUNTER_HASHES_V2, len);
+    verus_hash_chain(CVerusKernels::Haraka()->haraka512Chain, result, (const unsigned char *)data, len);
+}
 
 CVerusHashV2 &CVerusHashV2::Write(const unsigned char *data, size_t _len)
 {
     unsigned char *tmp;
-    int len = _len;
+    size_t len = _len;
+    VerusHarakaFunction haraka512Function = CVerusKernels::Haraka()->haraka512;
+
+    CVerusCounters::Add(VERUS_COUNTER_BYTES, len);
 
     // digest up to 32 bytes at a time
-    for (int pos = 0; pos < len; )
+    for (size_t pos = 0; pos < len; )
     {
-        int room = 32 - curPos;
+        size_t room = 32 - curPos;
 
         if (len - pos >= room)
         {
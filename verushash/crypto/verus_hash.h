@@ -16,19 +16,30 @@ This provides the PoW hash function for Verus, enabling CPU mining.
 
 #include "uint256.h"
 #include "verus_clhash.h"
+#include "verus_counters.h"
+#include "verus_probes.h"
+#include "verus_stage_stats.h"
 
 extern "C" 
 {
 #include "haraka.h"
 #include "haraka_portable.h"
+#include "haraka_ct.h"
 }
 
 class CVerusHash
 {
     public:
         static void Hash(void *result, const void *data, size_t len);
-        static void (*haraka512Function)(unsigned char *out, const unsigned char *in);
 
+        // Hash, chaining in result itself, which must be 16 byte aligned
+        static void HashAligned(unsigned char *result, const void *data, size_t len);
+
+        // Hash of count independent inputs, 32 bytes each to results. Up to eight run at a time
+        // through the multi-lane haraka512Zero kernels, for rehashing V1 history in bulk
+        static void HashBatch(unsigned char *results, const unsigned char *const *data, const size_t *len, size_t count);
+
+        // Haraka comes from the selected kernel in CVerusKernels, this only makes sure it is initialized
         static void init();
 
         CVerusHash() { }
@@ -52,14 +63,15 @@ class CVerusHash
                 std::fill(curBuf + 32 + curPos, curBuf + 64, 0);
             }
         }
-        void ExtraHash(unsigned char hash[32]) { (*haraka512Function)(hash, curBuf); }
+        void ExtraHash(unsigned char hash[32]) { (*CVerusKernels::Haraka()->haraka512Zero)(hash, curBuf); }
 
         void Finalize(unsigned char hash[32])
         {
+            CVerusCounters::Add(VERUS_COUNTER_HASHES_V1);
             if (curPos)
             {
                 std::fill(curBuf + 32 + curPos, curBuf + 64, 0);
-                (*haraka512Function)(hash, curBuf);
+                (*CVerusKernels::Haraka()->haraka512Zero)(hash, curBuf);
             }
             else
                 std::memcpy(hash, curBuf, 32);
@@ -67,7 +79,7 @@ class CVerusHash
 
     private:
         // only buf1, the first source, needs to be zero initialized
-        unsigned char buf1[64] = {0}, buf2[64];
+        alignas(32) unsigned char buf1[64] = {0}, buf2[64];
         unsigned char *curBuf = buf1, *result = buf2;
         size_t curPos = 0;
 };
@@ -76,17 +88,20 @@ class CVerusHashV2
 {
     public:
         static void Hash(void *result, const void *data, size_t len);
-        static void (*haraka512Function)(unsigned char *out, const unsigned char *in);
-        static void (*haraka512KeyedFunction)(unsigned char *out, const unsigned char *in, const u128 *rc);
-        static void (*haraka256Function)(unsigned char *out, const unsigned char *in);
 
+        // Hash, chaining in result itself, which must be 16 byte aligned
+        static void HashAligned(unsigned char *result, const void *data, size_t len);
+
+        // Haraka and CLHash come from the selected kernels in CVerusKernels, this only makes sure they are initialized
         static void init();
 
         verusclhasher vclh;
 
-        CVerusHashV2(int solutionVerusion=SOLUTION_VERUSHHASH_V2) : vclh(VERUSKEYSIZE, solutionVerusion) {
+        CVerusHashV2(int solutionVerusion=SOLUTION_VERUSHHASH_V2) : vclh(VERUSKEYSIZE, solutionVerusion),
+            hashCounter(solutionVerusion >= SOLUTION_VERUSHHASH_V2_2 ? VERUS_COUNTER_HASHES_V2B2 :
+                        solutionVerusion >= SOLUTION_VERUSHHASH_V2_1 ? VERUS_COUNTER_HASHES_V2B1 : VERUS_COUNTER_HASHES_V2B) {
             // we must have allocated key space, or can't run
-            if (!verusclhasher_key.get())
+            if (!vclh.keySizeInBytes)
             {
                 printf("ERROR: failed to allocate hash buffer - terminating\n");
                 assert(false);
@@ -127,15 +142,16 @@ class CVerusHashV2
                 left -= len;
             } while (left > 0);
         }
-        inline void ExtraHash(unsigned char hash[32]) { (*haraka512Function)(hash, curBuf); }
-        inline void ExtraHashKeyed(unsigned char hash[32], u128 *key) { (*haraka512KeyedFunction)(hash, curBuf, key); }
+        inline void ExtraHash(unsigned char hash[32]) { (*CVerusKernels::Haraka()->haraka512)(hash, curBuf); }
+        inline void ExtraHashKeyed(unsigned char hash[32], u128 *key) { (*CVerusKernels::Haraka()->haraka512Keyed)(hash, curBuf, key); }
 
         void Finalize(unsigned char hash[32])
         {
+            CVerusCounters::Add(VERUS_COUNTER_HASHES_V2);
             if (curPos)
             {
                 std::fill(curBuf + 32 + curPos, curBuf + 64, 0);
-                (*haraka512Function)(hash, curBuf);
+                (*CVerusKernels::Haraka()->haraka512)(hash, curBuf);
             }
             else
                 std::memcpy(hash, curBuf, 32);
@@ -144,14 +160,24 @@ class CVerusHashV2
         // chains Haraka256 from 32 bytes to fill the key
         static u128 *GenNewCLKey(unsigned char *seedBytes32)
         {
+            VERUS_STAGE_START(timer);
             unsigned char *key = (unsigned char *)verusclhasher_key.get();
             verusclhash_descr *pdesc = (verusclhash_descr *)verusclhasher_descr.get();
             int size = pdesc->keySizeInBytes;
             int refreshsize = verusclhasher::keymask(size) + 1;
-            // skip keygen if it is the current key
-            if (pdesc->seed != *((uint256 *)seedBytes32))
+#ifdef VERUSHASH_STAGE_STATS
+            int stage = VERUS_STAGE_KEY_RESTORE;
+#endif
+            int counter = VERUS_COUNTER_KEY_RESTORES;
+            // skip keygen if it is the current key, never for a key allocated since the last one
+            if (!pdesc->generated || pdesc->seed != *((uint256 *)seedBytes32))
             {
+#ifdef VERUSHASH_STAGE_STATS
+                stage = VERUS_STAGE_KEYGEN;
+#endif
+                counter = VERUS_COUNTER_KEY_GENERATIONS;
                 // generate a new key by chain hashing with Haraka256 from the last curbuf
+                VerusHarakaFunction haraka256Function = CVerusKernels::Haraka()->haraka256;
                 int n256blks = size >> 5;
                 int nbytesExtra = size & 0x1f;
                 unsigned char *pkey = key;
@@ -169,14 +195,19 @@ class CVerusHashV2
                     memcpy(pkey, buf, nbytesExtra);
                 }
                 pdesc->seed = *((uint256 *)seedBytes32);
+                pdesc->generated = true;
                 memcpy(key + size, key, refreshsize);
+                VERUS_PROBE2(key_generate, key, size);
             }
             else
             {
                 memcpy(key, key + size, refreshsize);
+                VERUS_PROBE2(key_restore, key, refreshsize);
             }
 
             memset((unsigned char *)key + (size + refreshsize), 0, size - refreshsize);
+            VERUS_STAGE_END(stage, timer);
+            CVerusCounters::Add(counter);
             return (u128 *)key;
         }
 
@@ -189,6 +220,14 @@ class CVerusHashV2
 
         void Finalize2b(unsigned char hash[32])
         {
+            // the key may have been released while this thread was idle, see verus_memory.h
+            CVerusKeyClaim claim;
+            if (!verusclhasher_key.get() && !vclh.allockey())
+            {
+                printf("ERROR: failed to allocate hash buffer - terminating\n");
+                assert(false);
+            }
+
             // fill buffer to the end with the beginning of it to prevent any foreknowledge of
             // bits that may contain zero
             FillExtra((u128 *)curBuf);
@@ -203,7 +242,9 @@ class CVerusHashV2
             u128 *key = GenNewCLKey(curBuf);
 
             // run verusclhash on the buffer
+            VERUS_STAGE_START(timer);
             uint64_t intermediate = vclh(curBuf, key);
+            VERUS_STAGE_NEXT(VERUS_STAGE_CLHASH, timer);
 
             // fill buffer to the end with the result
             FillExtra(&intermediate);
@@ -217,7 +258,9 @@ class CVerusHashV2
 #endif
 
             // get the final hash with a mutated dynamic key for each hash result
-            (*haraka512KeyedFunction)(hash, curBuf, key + IntermediateTo128Offset(intermediate));
+            (*CVerusKernels::Haraka()->haraka512Keyed)(hash, curBuf, key + IntermediateTo128Offset(intermediate));
+            VERUS_STAGE_END(VERUS_STAGE_FINAL_HARAKA, timer);
+            CVerusCounters::Add(hashCounter);
         }
 
         inline unsigned char *CurBuffer()
@@ -230,6 +273,7 @@ class CVerusHashV2
         alignas(32) unsigned char buf1[64] = {0}, buf2[64];
         unsigned char *curBuf = buf1, *result = buf2;
         size_t curPos = 0;
+        int hashCounter;                // the VERUS_COUNTER_HASHES_ counter of Finalize2b
 };
 
 extern void verus_hash(void *result, const void *data, size_t len);
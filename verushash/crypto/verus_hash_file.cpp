@@ -0,0 +1,315 @@
+// (C) 2018 The Verus Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+/*
+File and descriptor hashing for CVerusFileHasher, see verus_hash_file.h.
+*/
+
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <future>
+#include <new>
+
+#include "verus_hash_file.h"
+
+static const char *versionNames[VERUS_FILE_HASH_VERSIONS] = {"v1", "v2", "v2b", "v2b1", "v2b2"};
+
+static size_t page_size()
+{
+    static const size_t size = sysconf(_SC_PAGESIZE) > 0 ? sysconf(_SC_PAGESIZE) : 4096;
+    return size;
+}
+
+static bool fail(std::string *error, const std::string &what, int err)
+{
+    if (error)
+    {
+        *error = err ? what + ": " + strerror(err) : what;
+    }
+    return false;
+}
+
+// madvise on the pages holding [p, p + len)
+static void advise(const unsigned char *p, size_t len, int advice)
+{
+    uintptr_t start = (uintptr_t)p & ~(uintptr_t)(page_size() - 1);
+    madvise((void *)start, (uintptr_t)p + len - start, advice);
+}
+
+// one page aligned read buffer, freed when it goes out of scope
+struct CVerusReadBuffer
+{
+    unsigned char *data = NULL;
+    size_t size;
+
+    CVerusReadBuffer(size_t size) : size(size)
+    {
+        if (posix_memalign((void **)&data, page_size(), size))
+        {
+            data = NULL;
+        }
+        else
+        {
+            CVerusMemory::Alloc(VERUS_MEMORY_READ_BUFFERS, size);
+        }
+    }
+    ~CVerusReadBuffer()
+    {
+        if (data)
+        {
+            free(data);
+            CVerusMemory::Free(VERUS_MEMORY_READ_BUFFERS, size);
+        }
+    }
+};
+
+// fills buf up to len bytes, returning fewer only at the end of the input, or -errno
+static ssize_t read_full(int fd, unsigned char *buf, size_t len, uint64_t offset, bool positioned)
+{
+    size_t got = 0;
+    while (got < len)
+    {
+        ssize_t n = positioned ? pread(fd, buf + got, len - got, offset + got) : read(fd, buf + got, len - got);
+        if (n < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            return -errno;
+        }
+        if (n == 0)
+        {
+            break;
+        }
+        got += n;
+    }
+    return got;
+}
+
+const char *CVerusFileHasher::VersionName(int version)
+{
+    return (version >= 0 && version < VERUS_FILE_HASH_VERSIONS) ? versionNames[version] : "unknown";
+}
+
+int CVerusFileHasher::VersionFromName(const std::string &name)
+{
+    for (int i = 0; i < VERUS_FILE_HASH_VERSIONS; i++)
+    {
+        if (name == versionNames[i])
+        {
+            return i;
+        }
+    }
+    return -1;
+}
+
+CVerusFileHasher::CVerusFileHasher(int _version) : version(_version)
+{
+    assert(version >= 0 && version < VERUS_FILE_HASH_VERSIONS);
+    if (version == VERUS_FILE_HASH_V1)
+    {
+        new (&vh) CVerusHash();
+    }
+    else
+    {
+        new (&vh2) CVerusHashV2(version == VERUS_FILE_HASH_V2B2 ? SOLUTION_VERUSHHASH_V2_2 :
+                                version == VERUS_FILE_HASH_V2B1 ? SOLUTION_VERUSHHASH_V2_1 : SOLUTION_VERUSHHASH_V2);
+    }
+}
+
+CVerusFileHasher::~CVerusFileHasher()
+{
+    if (version == VERUS_FILE_HASH_V1)
+    {
+        vh.~CVerusHash();
+    }
+    else
+    {
+        vh2.~CVerusHashV2();
+    }
+}
+
+CVerusFileHasher &CVerusFileHasher::Reset()
+{
+    if (version == VERUS_FILE_HASH_V1)
+    {
+        vh.Reset();
+    }
+    else
+    {
+        vh2.Reset();
+    }
+    bytesHashed = 0;
+    return *this;
+}
+
+CVerusFileHasher &CVerusFileHasher::Write(const unsigned char *data, size_t len)
+{
+    bytesHashed += len;
+    if (version == VERUS_FILE_HASH_V1)
+    {
+        vh.Write(data, len);
+    }
+    else
+    {
+        vh2.Write(data, len);
+    }
+    return *this;
+}
+
+void CVerusFileHasher::Finalize(unsigned char hash[32])
+{
+    switch (version)
+    {
+        case VERUS_FILE_HASH_V1:
+            vh.Finalize(hash);
+            break;
+        case VERUS_FILE_HASH_V2:
+            vh2.Finalize(hash);
+            break;
+        default:
+            vh2.Finalize2b(hash);
+            break;
+    }
+}
+
+void CVerusFileHasher::SetChunkSize(size_t size)
+{
+    size_t page = page_size();
+    chunkSize = size < page ? page : (size + page - 1) & ~(page - 1);
+}
+
+bool CVerusFileHasher::HashFile(const std::string &path, unsigned char hash[32], int method, std::string *error)
+{
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+    {
+        return fail(error, path, errno);
+    }
+    bool ok = HashDescriptor(fd, hash, method, error);
+    if (!ok && error)
+    {
+        *error = path + ": " + *error;
+    }
+    close(fd);
+    return ok;
+}
+
+bool CVerusFileHasher::HashDescriptor(int fd, unsigned char hash[32], int method, std::string *error)
+{
+    struct stat st;
+
+    Reset();
+    if (fstat(fd, &st))
+    {
+        return fail(error, "fstat", errno);
+    }
+
+    // regular files are hashed from the current offset with mmap or pread, and their offset
+    // is not moved. Anything else is read to the end
+    off_t offset = S_ISREG(st.st_mode) ? lseek(fd, 0, SEEK_CUR) : -1;
+    if (offset < 0 || offset > st.st_size)
+    {
+        if (method == VERUS_FILE_READ_MMAP)
+        {
+            return fail(error, "mmap", ENODEV);
+        }
+        return HashBuffered(fd, 0, false, hash, error);
+    }
+
+    if (method != VERUS_FILE_READ_BUFFERED && offset < st.st_size)
+    {
+        unsigned char *base = (unsigned char *)mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (base != MAP_FAILED)
+        {
+            bool ok = HashMapped(base, st.st_size, offset, hash, error);
+            munmap(base, st.st_size);
+            return ok;
+        }
+        if (method == VERUS_FILE_READ_MMAP)
+        {
+            return fail(error, "mmap", errno);
+        }
+    }
+    return HashBuffered(fd, st.st_size - offset, true, hash, error);
+}
+
+bool CVerusFileHasher::HashMapped(const unsigned char *base, uint64_t size, uint64_t offset, unsigned char hash[32], std::string *error)
+{
+    madvise((void *)base, size, MADV_SEQUENTIAL);
+
+    uint64_t total = size - offset, done = 0;
+    for (const unsigned char *p = base + offset; done < total; )
+    {
+        size_t len = total - done < chunkSize ? total - done : chunkSize;
+        if (done + len < total)
+        {
+            advise(p + len, total - done - len < chunkSize ? total - done - len : chunkSize, MADV_WILLNEED);
+        }
+        Write(p, len);
+        // already hashed, so keep the mapping from growing to the whole file
+        advise(p, len, MADV_DONTNEED);
+        p += len;
+        done += len;
+        if (progress && !(*progress)(done, total, progressContext))
+        {
+            return fail(error, "cancelled", 0);
+        }
+    }
+    Finalize(hash);
+    return true;
+}
+
+bool CVerusFileHasher::HashBuffered(int fd, uint64_t total, bool positioned, unsigned char hash[32], std::string *error)
+{
+    CVerusReadBuffer buffer0(chunkSize), buffer1(chunkSize);
+    unsigned char *buffers[2] = {buffer0.data, buffer1.data};
+    if (!buffers[0] || !buffers[1])
+    {
+        return fail(error, "read buffer", ENOMEM);
+    }
+
+    uint64_t offset = positioned ? lseek(fd, 0, SEEK_CUR) : 0, done = 0;
+    size_t size = chunkSize;
+    std::future<ssize_t> next = std::async(std::launch::async, read_full, fd, buffers[0], size, offset, positioned);
+    VERUS_PROBE2(chunk_enqueue, offset, size);
+
+    for (int cur = 0; ; cur ^= 1)
+    {
+        ssize_t n = next.get();
+        VERUS_PROBE1(chunk_dequeue, n);
+        if (n < 0)
+        {
+            return fail(error, positioned ? "pread" : "read", -n);
+        }
+
+        // start reading the next chunk unless this one ended the input
+        if ((size_t)n == size)
+        {
+            next = std::async(std::launch::async, read_full, fd, buffers[cur ^ 1], size, offset + done + n, positioned);
+            VERUS_PROBE2(chunk_enqueue, offset + done + n, size);
+        }
+        Write(buffers[cur], n);
+        done += n;
+        if (n && progress && !(*progress)(done, total, progressContext))
+        {
+            // the future, if any, waits for its read before the buffers go
+            return fail(error, "cancelled", 0);
+        }
+        if ((size_t)n < size)
+        {
+            break;
+        }
+    }
+    Finalize(hash);
+    return true;
+}
@@ -0,0 +1,95 @@
+// (C) 2018 The Verus Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+/*
+VerusHash of inputs too large to hold in memory, such as snapshot files of several GB. The
+input goes through the streaming Write of CVerusHash or CVerusHashV2 in chunks, so the result
+is the same as hashing the whole input in one buffer with the same version.
+
+Files are memory mapped when possible. Otherwise, and for pipes and other descriptors that
+cannot be mapped, they are read in large aligned chunks into two buffers, the next chunk
+being read on a second thread while the current one is hashed. Hashing itself always runs on
+the calling thread, which owns the thread local CLHash key.
+
+A progress callback, if given, is called after every chunk with the bytes hashed so far and
+the total, or 0 if the total is not known. Returning false from it cancels the hash.
+*/
+#ifndef VERUS_HASH_FILE_H_
+#define VERUS_HASH_FILE_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string>
+
+#include "verus_hash.h"
+
+enum VerusFileHashVersion {
+    VERUS_FILE_HASH_V1 = 0,             // CVerusHash
+    VERUS_FILE_HASH_V2 = 1,             // CVerusHashV2, Finalize
+    VERUS_FILE_HASH_V2B = 2,            // CVerusHashV2, Finalize2b
+    VERUS_FILE_HASH_V2B1 = 3,           // CVerusHashV2 for SOLUTION_VERUSHHASH_V2_1, Finalize2b
+    VERUS_FILE_HASH_V2B2 = 4,           // CVerusHashV2 for SOLUTION_VERUSHHASH_V2_2, Finalize2b
+    VERUS_FILE_HASH_VERSIONS = 5
+};
+
+enum VerusFileReadMethod {
+    VERUS_FILE_READ_AUTO = 0,           // mmap, or the double buffer if the file cannot be mapped
+    VERUS_FILE_READ_MMAP = 1,
+    VERUS_FILE_READ_BUFFERED = 2        // double buffered pread, or read for descriptors without offsets
+};
+
+typedef bool (*VerusHashProgressFunction)(uint64_t done, uint64_t total, void *context);
+
+class CVerusFileHasher
+{
+    public:
+        static const size_t DEFAULT_CHUNK_SIZE = 4 << 20;
+
+        // name of each version, as used by the command line tool, and the version for a name or -1
+        static const char *VersionName(int version);
+        static int VersionFromName(const std::string &name);
+
+        CVerusFileHasher(int version);
+        ~CVerusFileHasher();
+        CVerusFileHasher(const CVerusFileHasher &) = delete;
+        CVerusFileHasher &operator=(const CVerusFileHasher &) = delete;
+
+        CVerusFileHasher &Reset();
+        CVerusFileHasher &Write(const unsigned char *data, size_t len);
+        void Finalize(unsigned char hash[32]);
+
+        int Version() const { return version; }
+        uint64_t BytesHashed() const { return bytesHashed; }
+
+        // bytes per Write and per progress call, rounded up to a multiple of the page size
+        void SetChunkSize(size_t size);
+        void SetProgress(VerusHashProgressFunction function, void *context)
+        {
+            progress = function;
+            progressContext = context;
+        }
+
+        // hash a whole file or everything left in a descriptor, after a Reset. On failure they
+        // return false, and if error is not NULL, describe the failure in it
+        bool HashFile(const std::string &path, unsigned char hash[32], int method = VERUS_FILE_READ_AUTO, std::string *error = NULL);
+        bool HashDescriptor(int fd, unsigned char hash[32], int method = VERUS_FILE_READ_AUTO, std::string *error = NULL);
+
+    private:
+        int version;
+        size_t chunkSize = DEFAULT_CHUNK_SIZE;
+        uint64_t bytesHashed = 0;
+        VerusHashProgressFunction progress = NULL;
+        void *progressContext = NULL;
+        // only the hasher of the version is constructed, so V1 allocates no CLHash key
+        union
+        {
+            CVerusHash vh;
+            CVerusHashV2 vh2;
+        };
+
+        bool HashMapped(const unsigned char *base, uint64_t size, uint64_t offset, unsigned char hash[32], std::string *error);
+        bool HashBuffered(int fd, uint64_t total, bool positioned, unsigned char hash[32], std::string *error);
+};
+
+#endif
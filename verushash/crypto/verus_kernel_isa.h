@@ -0,0 +1,90 @@
+// (C) 2018 The Verus Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+/*
+The hot kernel sources (haraka.c, verus_clhash.cpp, sha256.cpp) are compiled once for the
+baseline target and again for each x86-64 feature level in CMakeLists.txt. Those extra
+builds force-include this file with VERUS_KERNEL_SUFFIX set, for example to _v3, which
+gives every kernel entry point a name of its own, such as haraka512_v3. They are built with
+hidden visibility, so those names stay inside the library, for the registry in
+verus_kernels.cpp. Shared state (thread local keys, the CSHA256 class) is only defined by
+the baseline build, see the #ifndef VERUS_KERNEL_SUFFIX guards in those files.
+
+Those builds must not include headers with inline C++ code either, such as verus_counters.h.
+The linker keeps one copy of each inline function of all the objects, and could keep the
+one compiled for v4. verus_clhash.cpp takes only the kernel declarations of verus_clhash.h
+for this, and the isa_check test, bench/isa_check.cmake, fails on any such copy.
+
+Without VERUS_KERNEL_SUFFIX, it declares the renamed entry points for the registry.
+*/
+#ifndef VERUS_KERNEL_ISA_H_
+#define VERUS_KERNEL_ISA_H_
+
+#define VERUS_KERNEL_PASTE2(name, suffix) name##suffix
+#define VERUS_KERNEL_PASTE(name, suffix) VERUS_KERNEL_PASTE2(name, suffix)
+
+#ifdef VERUS_KERNEL_SUFFIX
+
+#define VERUS_KERNEL_NAME(name) VERUS_KERNEL_PASTE(name, VERUS_KERNEL_SUFFIX)
+
+// haraka.c
+#define haraka256 VERUS_KERNEL_NAME(haraka256)
+#define haraka256_keyed VERUS_KERNEL_NAME(haraka256_keyed)
+#define haraka256_4x VERUS_KERNEL_NAME(haraka256_4x)
+#define haraka256_8x VERUS_KERNEL_NAME(haraka256_8x)
+#define haraka512 VERUS_KERNEL_NAME(haraka512)
+#define haraka512_zero VERUS_KERNEL_NAME(haraka512_zero)
+#define haraka512_keyed VERUS_KERNEL_NAME(haraka512_keyed)
+#define haraka512_chain VERUS_KERNEL_NAME(haraka512_chain)
+#define haraka512_zero_chain VERUS_KERNEL_NAME(haraka512_zero_chain)
+#define haraka512_4x VERUS_KERNEL_NAME(haraka512_4x)
+#define haraka512_8x VERUS_KERNEL_NAME(haraka512_8x)
+#define haraka512_zero_4x VERUS_KERNEL_NAME(haraka512_zero_4x)
+#define haraka512_zero_8x VERUS_KERNEL_NAME(haraka512_zero_8x)
+
+// verus_clhash.cpp
+#define __verusclmulwithoutreduction64alignedrepeat VERUS_KERNEL_NAME(__verusclmulwithoutreduction64alignedrepeat)
+#define __verusclmulwithoutreduction64alignedrepeat_sv2_1 VERUS_KERNEL_NAME(__verusclmulwithoutreduction64alignedrepeat_sv2_1)
+#define __verusclmulwithoutreduction64alignedrepeat_sv2_2 VERUS_KERNEL_NAME(__verusclmulwithoutreduction64alignedrepeat_sv2_2)
+#define verusclhash VERUS_KERNEL_NAME(verusclhash)
+#define verusclhash_sv2_1 VERUS_KERNEL_NAME(verusclhash_sv2_1)
+#define verusclhash_sv2_2 VERUS_KERNEL_NAME(verusclhash_sv2_2)
+#define verusclhash_sv2_2_x4 VERUS_KERNEL_NAME(verusclhash_sv2_2_x4)
+
+// sha256.cpp
+#define SHA256TransformGeneric VERUS_KERNEL_NAME(SHA256TransformGeneric)
+
+#elif defined(VERUS_MULTI_ISA) && defined(__cplusplus)
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define VERUS_DECLARE_KERNELS(suffix) \
+    _Pragma("GCC visibility push(hidden)") \
+    extern "C" { \
+    void VERUS_KERNEL_PASTE(haraka256, suffix)(unsigned char *out, const unsigned char *in); \
+    void VERUS_KERNEL_PASTE(haraka512, suffix)(unsigned char *out, const unsigned char *in); \
+    void VERUS_KERNEL_PASTE(haraka512_zero, suffix)(unsigned char *out, const unsigned char *in); \
+    void VERUS_KERNEL_PASTE(haraka512_zero_4x, suffix)(unsigned char *out, const unsigned char *in); \
+    void VERUS_KERNEL_PASTE(haraka512_zero_8x, suffix)(unsigned char *out, const unsigned char *in); \
+    void VERUS_KERNEL_PASTE(haraka512_keyed, suffix)(unsigned char *out, const unsigned char *in, const __m128i *rc); \
+    void VERUS_KERNEL_PASTE(haraka512_chain, suffix)(unsigned char *out, const unsigned char *cv, const unsigned char *block); \
+    void VERUS_KERNEL_PASTE(haraka512_zero_chain, suffix)(unsigned char *out, const unsigned char *cv, const unsigned char *block); \
+    __m128i VERUS_KERNEL_PASTE(__verusclmulwithoutreduction64alignedrepeat, suffix)(__m128i *randomsource, const __m128i buf[4], uint64_t keyMask, __m128i **pMoveScratch); \
+    __m128i VERUS_KERNEL_PASTE(__verusclmulwithoutreduction64alignedrepeat_sv2_1, suffix)(__m128i *randomsource, const __m128i buf[4], uint64_t keyMask, __m128i **pMoveScratch); \
+    __m128i VERUS_KERNEL_PASTE(__verusclmulwithoutreduction64alignedrepeat_sv2_2, suffix)(__m128i *randomsource, const __m128i buf[4], uint64_t keyMask, __m128i **pMoveScratch); \
+    uint64_t VERUS_KERNEL_PASTE(verusclhash, suffix)(void *random, const unsigned char buf[64], uint64_t keyMask, __m128i **pMoveScratch); \
+    uint64_t VERUS_KERNEL_PASTE(verusclhash_sv2_1, suffix)(void *random, const unsigned char buf[64], uint64_t keyMask, __m128i **pMoveScratch); \
+    uint64_t VERUS_KERNEL_PASTE(verusclhash_sv2_2, suffix)(void *random, const unsigned char buf[64], uint64_t keyMask, __m128i **pMoveScratch); \
+    void VERUS_KERNEL_PASTE(verusclhash_sv2_2_x4, suffix)(void *random[4], const unsigned char *buf[4], uint64_t keyMask, __m128i **pMoveScratch[4], uint64_t result[4]); \
+    } \
+    void VERUS_KERNEL_PASTE(SHA256TransformGeneric, suffix)(uint32_t *s, const unsigned char *chunk, size_t blocks); \
+    _Pragma("GCC visibility pop")
+
+VERUS_DECLARE_KERNELS(_v3)
+VERUS_DECLARE_KERNELS(_v4)
+
+#endif
+
+#endif
@@ -0,0 +1,408 @@
+// (C) 2018 The Verus Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+/*
+CPU detection and the table of kernel variants, see verus_kernels.h.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <mutex>
+
+#include "verus_kernels.h"
+#include "verus_hash.h"
+#include "sha256.h"
+#include "verus_kernel_isa.h"
+
+#if defined(__arm__) || defined(__aarch64__)
+#include <sys/auxv.h>
+#include <asm/hwcap.h>
+#elif !defined(_WIN32)
+#include <cpuid.h>
+#endif
+
+// best first, the last entry of each table must run on any CPU. the _v3 and _v4 variants are
+// the same sources built for those x86-64 feature levels, see verus_kernel_isa.h
+static const CVerusHarakaKernel harakaKernels[] = {
+#ifdef VERUS_HARAKA_VAES
+    // the best aesni kernel, except for the multi-lane haraka512Zero, which runs four inputs in
+    // each VAES instruction
+#ifdef VERUS_MULTI_ISA
+    CVerusHarakaKernel("vaes", VERUS_CPU_OPTIMIZED | VERUS_CPU_X86_64_V4 | VERUS_CPU_VAES,
+                       &haraka512_v4, &haraka512_keyed_v4, &haraka512_zero_v4, &haraka256_v4,
+                       &haraka512_zero_4x_vaes, &haraka512_zero_8x_vaes,
+                       &haraka512_chain_v4, &haraka512_zero_chain_v4),
+#else
+    CVerusHarakaKernel("vaes", VERUS_CPU_OPTIMIZED | VERUS_CPU_AVX512 | VERUS_CPU_VAES,
+                       &haraka512, &haraka512_keyed, &haraka512_zero, &haraka256,
+                       &haraka512_zero_4x_vaes, &haraka512_zero_8x_vaes,
+                       &haraka512_chain, &haraka512_zero_chain),
+#endif
+#endif
+#ifdef VERUS_MULTI_ISA
+    CVerusHarakaKernel("aesni-v4", VERUS_CPU_OPTIMIZED | VERUS_CPU_X86_64_V4, &haraka512_v4, &haraka512_keyed_v4, &haraka512_zero_v4, &haraka256_v4,
+                       &haraka512_zero_4x_v4, &haraka512_zero_8x_v4,
+                       &haraka512_chain_v4, &haraka512_zero_chain_v4),
+    CVerusHarakaKernel("aesni-v3", VERUS_CPU_OPTIMIZED | VERUS_CPU_X86_64_V3, &haraka512_v3, &haraka512_keyed_v3, &haraka512_zero_v3, &haraka256_v3,
+                       &haraka512_zero_4x_v3, &haraka512_zero_8x_v3,
+                       &haraka512_chain_v3, &haraka512_zero_chain_v3),
+#endif
+    CVerusHarakaKernel("aesni", VERUS_CPU_OPTIMIZED, &haraka512, &haraka512_keyed, &haraka512_zero, &haraka256,
+                       &haraka512_zero_4x, &haraka512_zero_8x,
+                       &haraka512_chain, &haraka512_zero_chain),
+    CVerusHarakaKernel("ct", 0, &haraka512_ct, &haraka512_ct_keyed, &haraka512_ct_zero, &haraka256_ct,
+                       &haraka512_ct_zero_4x, &haraka512_ct_zero_8x,
+                       &haraka512_ct_chain, &haraka512_ct_zero_chain),
+    CVerusHarakaKernel("port", 0, &haraka512_port, &haraka512_port_keyed, &haraka512_port_zero, &haraka256_port,
+                       &haraka512_port_zero_4x, &haraka512_port_zero_8x,
+                       &haraka512_port_chain, &haraka512_port_zero_chain)
+};
+
+static const CVerusCLHashKernel clhashKernels[] = {
+#ifdef VERUS_MULTI_ISA
+    CVerusCLHashKernel("pclmul-v4", VERUS_CPU_OPTIMIZED | VERUS_CPU_X86_64_V4,
+                       &verusclhash_v4, &__verusclmulwithoutreduction64alignedrepeat_v4,
+                       &verusclhash_sv2_1_v4, &__verusclmulwithoutreduction64alignedrepeat_sv2_1_v4,
+                       &verusclhash_sv2_2_v4, &__verusclmulwithoutreduction64alignedrepeat_sv2_2_v4,
+                       &verusclhash_sv2_2_x4_v4),
+    CVerusCLHashKernel("pclmul-v3", VERUS_CPU_OPTIMIZED | VERUS_CPU_X86_64_V3,
+                       &verusclhash_v3, &__verusclmulwithoutreduction64alignedrepeat_v3,
+                       &verusclhash_sv2_1_v3, &__verusclmulwithoutreduction64alignedrepeat_sv2_1_v3,
+                       &verusclhash_sv2_2_v3, &__verusclmulwithoutreduction64alignedrepeat_sv2_2_v3,
+                       &verusclhash_sv2_2_x4_v3),
+#endif
+    CVerusCLHashKernel("pclmul", VERUS_CPU_OPTIMIZED,
+                       &verusclhash, &__verusclmulwithoutreduction64alignedrepeat,
+                       &verusclhash_sv2_1, &__verusclmulwithoutreduction64alignedrepeat_sv2_1,
+                       &verusclhash_sv2_2, &__verusclmulwithoutreduction64alignedrepeat_sv2_2,
+                       &verusclhash_sv2_2_x4),
+#ifdef VERUS_CLHASH_AVX512
+    // experimental, the same as pclmul except for four hashes at once. never chosen by "auto",
+    // as any CPU that can run it also runs pclmul
+    CVerusCLHashKernel("avx512-x4", VERUS_CPU_OPTIMIZED | VERUS_CPU_AVX512 | VERUS_CPU_VAES | VERUS_CPU_VPCLMULQDQ,
+                       &verusclhash, &__verusclmulwithoutreduction64alignedrepeat,
+                       &verusclhash_sv2_1, &__verusclmulwithoutreduction64alignedrepeat_sv2_1,
+                       &verusclhash_sv2_2, &__verusclmulwithoutreduction64alignedrepeat_sv2_2,
+                       &verusclhash_sv2_2_x4_avx512),
+#endif
+    CVerusCLHashKernel("port", 0,
+                       &verusclhash_port, &__verusclmulwithoutreduction64alignedrepeat_port,
+                       &verusclhash_sv2_1_port, &__verusclmulwithoutreduction64alignedrepeat_sv2_1_port,
+                       &verusclhash_sv2_2_port, &__verusclmulwithoutreduction64alignedrepeat_sv2_2_port,
+                       &verusclhash_sv2_2_x4_port)
+};
+
+static const CVerusSHA256Kernel sha256Kernels[] = {
+#ifdef VERUS_MULTI_ISA
+    CVerusSHA256Kernel("generic-v4", VERUS_CPU_X86_64_V4, &SHA256TransformGeneric_v4),
+    CVerusSHA256Kernel("generic-v3", VERUS_CPU_X86_64_V3, &SHA256TransformGeneric_v3),
+#endif
+    CVerusSHA256Kernel("generic", 0, &SHA256TransformGeneric)
+};
+
+static const char *kernelTypeNames[VERUS_KERNEL_TYPES] = { "haraka", "clhash", "sha256" };
+
+static const struct
+{
+    uint32_t feature;
+    const char *name;
+} cpuFeatureNames[] = {
+    { VERUS_CPU_SSSE3, "ssse3" },
+    { VERUS_CPU_SSE41, "sse4.1" },
+    { VERUS_CPU_SSE42, "sse4.2" },
+    { VERUS_CPU_AES, "aes" },
+    { VERUS_CPU_PCLMUL, "pclmul" },
+    { VERUS_CPU_AVX, "avx" },
+    { VERUS_CPU_AVX2, "avx2" },
+    { VERUS_CPU_AVX512, "avx512" },
+    { VERUS_CPU_VAES, "vaes" },
+    { VERUS_CPU_VPCLMULQDQ, "vpclmulqdq" },
+    { VERUS_CPU_SHA, "sha" },
+    { VERUS_CPU_X86_64_V3, "x86-64-v3" },
+    { VERUS_CPU_X86_64_V4, "x86-64-v4" }
+};
+
+std::atomic<const CVerusKernel *> CVerusKernels::selected[VERUS_KERNEL_TYPES];
+
+static std::once_flag kernelsInitFlag;
+static uint32_t cpuFeatures = 0;
+
+#if !defined(__arm__) && !defined(__aarch64__)
+static void VerusCPUID(uint32_t leaf, uint32_t subleaf, uint32_t regs[4])
+{
+#ifdef _WIN32
+    int r[4];
+    __cpuidex(r, leaf, subleaf);
+    regs[0] = r[0]; regs[1] = r[1]; regs[2] = r[2]; regs[3] = r[3];
+#else
+    __cpuid_count(leaf, subleaf, regs[0], regs[1], regs[2], regs[3]);
+#endif
+}
+
+static uint64_t VerusXGETBV()
+{
+#ifdef _WIN32
+    return _xgetbv(0);
+#else
+    uint32_t lo, hi;
+    __asm__ __volatile__("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+    return ((uint64_t)hi << 32) | lo;
+#endif
+}
+#endif
+
+static uint32_t DetectCPUFeatures()
+{
+    uint32_t features = 0;
+
+#if defined(__arm__) || defined(__aarch64__)
+    // the x86 kernels run through SSE2NEON, which needs the crypto extensions
+    long hwcaps = getauxval(AT_HWCAP);
+    if ((hwcaps & HWCAP_AES) && (hwcaps & HWCAP_PMULL))
+    {
+        features = VERUS_CPU_OPTIMIZED;
+    }
+#else
+    uint32_t regs[4];
+    VerusCPUID(0, 0, regs);
+    uint32_t maxLeaf = regs[0];
+    if (maxLeaf < 1)
+    {
+        return 0;
+    }
+
+    VerusCPUID(1, 0, regs);
+    uint32_t ecx1 = regs[2];
+    if (ecx1 & (1 << 9)) features |= VERUS_CPU_SSSE3;
+    if (ecx1 & (1 << 19)) features |= VERUS_CPU_SSE41;
+    if (ecx1 & (1 << 20)) features |= VERUS_CPU_SSE42;
+    if (ecx1 & (1 << 25)) features |= VERUS_CPU_AES;
+    if (ecx1 & (1 << 1)) features |= VERUS_CPU_PCLMUL;
+
+    // wider registers are only usable when the OS saves them
+    uint64_t xcr0 = (ecx1 & (1 << 27)) ? VerusXGETBV() : 0;
+    bool osYMM = (xcr0 & 0x6) == 0x6;
+    bool osZMM = (xcr0 & 0xe6) == 0xe6;
+    if ((ecx1 & (1 << 28)) && osYMM) features |= VERUS_CPU_AVX;
+
+    if (maxLeaf >= 7)
+    {
+        VerusCPUID(7, 0, regs);
+        uint32_t ebx7 = regs[1], ecx7 = regs[2];
+        const uint32_t avx512Bits = (1 << 16) | (1 << 17) | (1 << 30) | (1u << 31);    // F, DQ, BW, VL
+        if (ebx7 & (1 << 29)) features |= VERUS_CPU_SHA;
+        if (osYMM)
+        {
+            if (ebx7 & (1 << 5)) features |= VERUS_CPU_AVX2;
+            if (ecx7 & (1 << 9)) features |= VERUS_CPU_VAES;
+            if (ecx7 & (1 << 10)) features |= VERUS_CPU_VPCLMULQDQ;
+        }
+        if (osZMM && (ebx7 & avx512Bits) == avx512Bits) features |= VERUS_CPU_AVX512;
+
+        // the rest of x86-64-v3: BMI1, BMI2 and LZCNT here, F16C, FMA and MOVBE in leaf 1
+        VerusCPUID(0x80000000, 0, regs);
+        uint32_t ecxExt = 0;
+        if (regs[0] >= 0x80000001)
+        {
+            VerusCPUID(0x80000001, 0, regs);
+            ecxExt = regs[2];
+        }
+        const uint32_t v3Leaf1 = (1 << 12) | (1 << 22) | (1 << 29);                    // FMA, MOVBE, F16C
+        const uint32_t v3Leaf7 = (1 << 3) | (1 << 8);                                   // BMI1, BMI2
+        if ((features & VERUS_CPU_AVX) && (features & VERUS_CPU_AVX2) &&
+            (ecx1 & v3Leaf1) == v3Leaf1 && (ebx7 & v3Leaf7) == v3Leaf7 && (ecxExt & (1 << 5)))
+        {
+            features |= VERUS_CPU_X86_64_V3;
+            if ((features & VERUS_CPU_AVX512) && (ebx7 & (1 << 28)))                   // CD
+            {
+                features |= VERUS_CPU_X86_64_V4;
+            }
+        }
+    }
+#endif
+    return features;
+}
+
+static size_t KernelCount(VerusKernelType type)
+{
+    switch (type)
+    {
+        case VERUS_KERNEL_HARAKA:
+            return sizeof(harakaKernels) / sizeof(harakaKernels[0]);
+        case VERUS_KERNEL_CLHASH:
+            return sizeof(clhashKernels) / sizeof(clhashKernels[0]);
+        case VERUS_KERNEL_SHA256:
+            return sizeof(sha256Kernels) / sizeof(sha256Kernels[0]);
+        default:
+            return 0;
+    }
+}
+
+static const CVerusKernel *KernelAt(VerusKernelType type, size_t index)
+{
+    if (index >= KernelCount(type))
+    {
+        return NULL;
+    }
+    switch (type)
+    {
+        case VERUS_KERNEL_HARAKA:
+            return &harakaKernels[index];
+        case VERUS_KERNEL_CLHASH:
+            return &clhashKernels[index];
+        case VERUS_KERNEL_SHA256:
+            return &sha256Kernels[index];
+        default:
+            return NULL;
+    }
+}
+
+static bool KernelSupported(const CVerusKernel *pk)
+{
+    return pk && (cpuFeatures & pk->cpuFeatures) == pk->cpuFeatures;
+}
+
+static const CVerusKernel *FindKernel(VerusKernelType type, const std::string &name)
+{
+    for (size_t i = 0; i < KernelCount(type); i++)
+    {
+        const CVerusKernel *pk = KernelAt(type, i);
+        if (name == "auto" ? KernelSupported(pk) : name == pk->name)
+        {
+            return pk;
+        }
+    }
+    return NULL;
+}
+
+// selection without the init check, so it can be used while initializing
+static bool SelectKernel(std::atomic<const CVerusKernel *> *selected, VerusKernelType type, const std::string &name)
+{
+    const CVerusKernel *pk = FindKernel(type, name);
+    if (!KernelSupported(pk))
+    {
+        return false;
+    }
+    selected[type].store(pk, std::memory_order_release);
+    return true;
+}
+
+static bool SelectKernels(std::atomic<const CVerusKernel *> *selected, const std::string &spec)
+{
+    bool ok = true;
+    size_t pos = 0;
+    while (pos < spec.size())
+    {
+        size_t end = spec.find(',', pos);
+        if (end == std::string::npos)
+        {
+            end = spec.size();
+        }
+        std::string item = spec.substr(pos, end - pos);
+        size_t eq = item.find('=');
+        int type = VERUS_KERNEL_TYPES;
+        if (eq != std::string::npos)
+        {
+            for (type = 0; type < VERUS_KERNEL_TYPES; type++)
+            {
+                if (item.compare(0, eq, kernelTypeNames[type]) == 0 && strlen(kernelTypeNames[type]) == eq)
+                {
+                    break;
+                }
+            }
+        }
+        if (type == VERUS_KERNEL_TYPES || !SelectKernel(selected, (VerusKernelType)type, item.substr(eq + 1)))
+        {
+            ok = false;
+        }
+        pos = end + 1;
+    }
+    return ok;
+}
+
+void CVerusKernels::Init()
+{
+    std::call_once(kernelsInitFlag, []() {
+        cpuFeatures = DetectCPUFeatures();
+
+        for (int type = 0; type < VERUS_KERNEL_TYPES; type++)
+        {
+            SelectKernel(selected, (VerusKernelType)type, "auto");
+        }
+
+        const char *env = getenv("VERUSHASH_KERNELS");
+        if (env && !SelectKernels(selected, env))
+        {
+            fprintf(stderr, "verushash: ignoring unknown or unsupported kernels in VERUSHASH_KERNELS=\"%s\"\n", env);
+        }
+    });
+}
+
+uint32_t CVerusKernels::CPUFeatures()
+{
+    Init();
+    return cpuFeatures;
+}
+
+std::string CVerusKernels::CPUFeatureString()
+{
+    uint32_t features = CPUFeatures();
+    std::string result;
+    for (size_t i = 0; i < sizeof(cpuFeatureNames) / sizeof(cpuFeatureNames[0]); i++)
+    {
+        if (features & cpuFeatureNames[i].feature)
+        {
+            if (!result.empty())
+            {
+                result += " ";
+            }
+            result += cpuFeatureNames[i].name;
+        }
+    }
+    return result;
+}
+
+size_t CVerusKernels::Count(VerusKernelType type)
+{
+    return KernelCount(type);
+}
+
+const CVerusKernel *CVerusKernels::Get(VerusKernelType type, size_t index)
+{
+    return KernelAt(type, index);
+}
+
+bool CVerusKernels::IsSupported(const CVerusKernel *pk)
+{
+    Init();
+    return KernelSupported(pk);
+}
+
+bool CVerusKernels::Select(VerusKernelType type, const std::string &name)
+{
+    Init();
+    return type < VERUS_KERNEL_TYPES && SelectKernel(selected, type, name);
+}
+
+bool CVerusKernels::Select(const std::string &spec)
+{
+    Init();
+    return SelectKernels(selected, spec);
+}
+
+const char *CVerusKernels::TypeName(VerusKernelType type)
+{
+    return type < VERUS_KERNEL_TYPES ? kernelTypeNames[type] : "";
+}
+
+std::string CVerusKernels::Describe()
+{
+    std::string result = "cpu: " + CPUFeatureString() + ";";
+    for (int type = 0; type < VERUS_KERNEL_TYPES; type++)
+    {
+        result += std::string(" ") + kernelTypeNames[type] + "=" + Selected((VerusKernelType)type)->name;
+    }
+    return result;
+}
@@ -0,0 +1,202 @@
+// (C) 2018 The Verus Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+/*
+This is the registry of the hash kernels that the library can run, and the CPU features
+each of them needs. CPU detection and the initial selection happen exactly once, on first
+use from any thread. After that the selection can be pinned to a named variant, either
+with the VERUSHASH_KERNELS environment variable, for example:
+
+    VERUSHASH_KERNELS="haraka=ct,clhash=port"
+
+or from code with CVerusKernels::Select(). All variants of a kernel produce identical
+output, so switching only changes speed.
+*/
+#ifndef VERUS_KERNELS_H_
+#define VERUS_KERNELS_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+#include <string>
+
+#if defined(__arm__) || defined(__aarch64__)
+#include "crypto/SSE2NEON.h"
+#elif defined(_WIN32)
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+
+// CPU features, as reported by CVerusKernels::CPUFeatures()
+enum {
+    VERUS_CPU_SSSE3 = 0x1,
+    VERUS_CPU_SSE41 = 0x2,
+    VERUS_CPU_SSE42 = 0x4,
+    VERUS_CPU_AES = 0x8,
+    VERUS_CPU_PCLMUL = 0x10,
+    VERUS_CPU_AVX = 0x20,
+    VERUS_CPU_AVX2 = 0x40,
+    VERUS_CPU_AVX512 = 0x80,            // F, BW, DQ and VL, with OS support for the zmm state
+    VERUS_CPU_VAES = 0x100,
+    VERUS_CPU_VPCLMULQDQ = 0x200,
+    VERUS_CPU_SHA = 0x400,
+    VERUS_CPU_X86_64_V3 = 0x800,        // AVX2, BMI1, BMI2, F16C, FMA, LZCNT and MOVBE, what -march=x86-64-v3 assumes
+    VERUS_CPU_X86_64_V4 = 0x1000,       // x86-64-v3 plus AVX-512 F, BW, CD, DQ and VL
+
+    // what the original AES-NI code paths have always required
+    VERUS_CPU_OPTIMIZED = VERUS_CPU_AES | VERUS_CPU_PCLMUL | VERUS_CPU_AVX
+};
+
+enum VerusKernelType {
+    VERUS_KERNEL_HARAKA = 0,
+    VERUS_KERNEL_CLHASH = 1,
+    VERUS_KERNEL_SHA256 = 2,
+    VERUS_KERNEL_TYPES = 3
+};
+
+// index of the CLHash functions for each hash solution version
+enum {
+    VERUS_CLHASH_V2 = 0,
+    VERUS_CLHASH_V2_1 = 1,
+    VERUS_CLHASH_V2_2 = 2,
+    VERUS_CLHASH_VERSIONS = 3
+};
+
+typedef void (*VerusHarakaFunction)(unsigned char *out, const unsigned char *in);
+typedef void (*VerusHarakaKeyedFunction)(unsigned char *out, const unsigned char *in, const __m128i *rc);
+typedef void (*VerusHarakaChainFunction)(unsigned char *out, const unsigned char *cv, const unsigned char *block);
+typedef uint64_t (*VerusCLHashFunction)(void *random, const unsigned char buf[64], uint64_t keyMask, __m128i **pMoveScratch);
+typedef __m128i (*VerusCLHashInternalFunction)(__m128i *randomsource, const __m128i buf[4], uint64_t keyMask, __m128i **pMoveScratch);
+typedef void (*VerusCLHashX4Function)(void *random[4], const unsigned char *buf[4], uint64_t keyMask, __m128i **pMoveScratch[4], uint64_t result[4]);
+typedef void (*VerusSHA256TransformFunction)(uint32_t *s, const unsigned char *chunk, size_t blocks);
+
+// common head of every kernel descriptor
+struct CVerusKernel
+{
+    const char *name;
+    uint32_t cpuFeatures;               // all of these must be present
+
+    constexpr CVerusKernel(const char *Name, uint32_t CPUFeatures) : name(Name), cpuFeatures(CPUFeatures) {}
+};
+
+struct CVerusHarakaKernel : public CVerusKernel
+{
+    VerusHarakaFunction haraka512;
+    VerusHarakaKeyedFunction haraka512Keyed;
+    VerusHarakaFunction haraka512Zero;
+    VerusHarakaFunction haraka256;
+    VerusHarakaFunction haraka512Zero4x;    // four and eight independent haraka512Zero, for CVerusHash::HashBatch
+    VerusHarakaFunction haraka512Zero8x;
+    VerusHarakaChainFunction haraka512Chain;        // haraka512 and haraka512Zero of a chaining value and
+    VerusHarakaChainFunction haraka512ZeroChain;    // a block in separate places, for the one-shot Hash
+
+    constexpr CVerusHarakaKernel(const char *Name, uint32_t CPUFeatures,
+                                 VerusHarakaFunction Haraka512, VerusHarakaKeyedFunction Haraka512Keyed,
+                                 VerusHarakaFunction Haraka512Zero, VerusHarakaFunction Haraka256,
+                                 VerusHarakaFunction Haraka512Zero4x, VerusHarakaFunction Haraka512Zero8x,
+                                 VerusHarakaChainFunction Haraka512Chain, VerusHarakaChainFunction Haraka512ZeroChain) :
+        CVerusKernel(Name, CPUFeatures), haraka512(Haraka512), haraka512Keyed(Haraka512Keyed),
+        haraka512Zero(Haraka512Zero), haraka256(Haraka256),
+        haraka512Zero4x(Haraka512Zero4x), haraka512Zero8x(Haraka512Zero8x),
+        haraka512Chain(Haraka512Chain), haraka512ZeroChain(Haraka512ZeroChain) {}
+};
+
+struct CVerusCLHashKernel : public CVerusKernel
+{
+    VerusCLHashFunction clhash[VERUS_CLHASH_VERSIONS];
+    VerusCLHashInternalFunction clhashInternal[VERUS_CLHASH_VERSIONS];
+    VerusCLHashX4Function clhashV2_2x4;     // four independent V2_2 hashes, see verusclhash_sv2_2_x4
+
+    constexpr CVerusCLHashKernel(const char *Name, uint32_t CPUFeatures,
+                                 VerusCLHashFunction CLHashV2, VerusCLHashInternalFunction CLHashInternalV2,
+                                 VerusCLHashFunction CLHashV2_1, VerusCLHashInternalFunction CLHashInternalV2_1,
+                                 VerusCLHashFunction CLHashV2_2, VerusCLHashInternalFunction CLHashInternalV2_2,
+                                 VerusCLHashX4Function CLHashV2_2x4) :
+        CVerusKernel(Name, CPUFeatures),
+        clhash{CLHashV2, CLHashV2_1, CLHashV2_2},
+        clhashInternal{CLHashInternalV2, CLHashInternalV2_1, CLHashInternalV2_2},
+        clhashV2_2x4(CLHashV2_2x4) {}
+};
+
+struct CVerusSHA256Kernel : public CVerusKernel
+{
+    VerusSHA256TransformFunction transform;
+
+    constexpr CVerusSHA256Kernel(const char *Name, uint32_t CPUFeatures, VerusSHA256TransformFunction Transform) :
+        CVerusKernel(Name, CPUFeatures), transform(Transform) {}
+};
+
+class CVerusKernels
+{
+    public:
+        // detected CPU features, VERUS_CPU_*
+        static uint32_t CPUFeatures();
+
+        // space separated names of the detected features
+        static std::string CPUFeatureString();
+
+        // the currently selected kernel of each type, never NULL
+        static inline const CVerusHarakaKernel *Haraka()
+        {
+            return (const CVerusHarakaKernel *)Selected(VERUS_KERNEL_HARAKA);
+        }
+        static inline const CVerusCLHashKernel *CLHash()
+        {
+            return (const CVerusCLHashKernel *)Selected(VERUS_KERNEL_CLHASH);
+        }
+        static inline const CVerusSHA256Kernel *SHA256()
+        {
+            return (const CVerusSHA256Kernel *)Selected(VERUS_KERNEL_SHA256);
+        }
+        static inline const CVerusKernel *Selected(VerusKernelType type)
+        {
+            const CVerusKernel *pk = selected[type].load(std::memory_order_acquire);
+            return pk ? pk : (Init(), selected[type].load(std::memory_order_acquire));
+        }
+
+        // every compiled variant of a kernel type, best first, including ones this CPU can't run
+        static size_t Count(VerusKernelType type);
+        static const CVerusKernel *Get(VerusKernelType type, size_t index);
+        static bool IsSupported(const CVerusKernel *pk);
+
+        // pins the named variant, returns false and leaves the selection alone if it is
+        // unknown or not supported on this CPU. name "auto" restores the default choice.
+        static bool Select(VerusKernelType type, const std::string &name);
+
+        // applies a "type=name,type=name" list as used in VERUSHASH_KERNELS
+        static bool Select(const std::string &spec);
+
+        // one line with the CPU features and the selected kernel of each type
+        static std::string Describe();
+
+        static const char *TypeName(VerusKernelType type);
+
+        // detects the CPU and applies the environment override, only the first call does anything
+        static void Init();
+
+    private:
+        static std::atomic<const CVerusKernel *> selected[VERUS_KERNEL_TYPES];
+};
+
+// true when the AES-NI and PCLMULQDQ kernels can be used on this CPU
+inline bool IsCPUVerusOptimized()
+{
+    return (CVerusKernels::CPUFeatures() & VERUS_CPU_OPTIMIZED) == VERUS_CPU_OPTIMIZED;
+}
+
+// kept for existing callers, false pins the portable kernels and true returns to automatic selection
+inline void ForceCPUVerusOptimized(bool trueorfalse)
+{
+    if (trueorfalse)
+    {
+        CVerusKernels::Select("haraka=auto,clhash=auto");
+    }
+    else
+    {
+        CVerusKernels::Select("haraka=ct,clhash=port");
+    }
+}
+
+#endif
@@ -0,0 +1,326 @@
+// (C) 2018 The Verus Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+/*
+Per thread latency histograms and their Prometheus rendering, see verus_latency.h.
+*/
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "verus_latency.h"
+#include "verus_kernels.h"
+#include "verus_memory.h"
+#include "verus_thread_counters.h"
+
+// values below 32 ticks share a bucket, above that eight per power of two up to 2^40 ticks,
+// several minutes, which also holds anything longer
+static const int LATENCY_BUCKETS = 1 + (40 - 5) * 8;
+
+static const char *apiNames[VERUS_LATENCY_APIS] = {"verushash", "hash_batch"};
+static const char *versionNames[VERUS_LATENCY_VERSIONS] = {"v1", "v2", "v2b", "v2b1", "v2b2"};
+
+static inline int bucket_of(uint64_t ticks)
+{
+    if (ticks < 32)
+    {
+        return 0;
+    }
+    int e = 63 - __builtin_clzll(ticks);
+    int bucket = 1 + (e - 5) * 8 + (int)((ticks >> (e - 3)) & 7);
+    return bucket < LATENCY_BUCKETS ? bucket : LATENCY_BUCKETS - 1;
+}
+
+// the low end in ticks of a bucket, and of one past the last for its high end
+static inline uint64_t bucket_low_ticks(int bucket)
+{
+    if (!bucket)
+    {
+        return 0;
+    }
+    int e = (bucket - 1) / 8 + 5;
+    return (8ULL + (bucket - 1) % 8) << (e - 3);
+}
+
+// one histogram, in ticks
+struct CVerusLatencyHistogram
+{
+    std::atomic<uint64_t> count;
+    std::atomic<uint64_t> totalTicks;
+    std::atomic<uint64_t> buckets[LATENCY_BUCKETS];
+
+    CVerusLatencyHistogram() : count(0), totalTicks(0)
+    {
+        for (int k = 0; k < LATENCY_BUCKETS; k++)
+        {
+            buckets[k].store(0, std::memory_order_relaxed);
+        }
+    }
+};
+
+// the histograms of one thread, each allocated by the thread on its first call of that API and
+// version and kept with the counters when they pass to a new thread
+struct CVerusLatencyCounters
+{
+    std::atomic<CVerusLatencyHistogram *> histograms[VERUS_LATENCY_APIS][VERUS_LATENCY_VERSIONS];
+
+    CVerusLatencyCounters()
+    {
+        for (int i = 0; i < VERUS_LATENCY_APIS; i++)
+        {
+            for (int j = 0; j < VERUS_LATENCY_VERSIONS; j++)
+            {
+                histograms[i][j].store(NULL, std::memory_order_relaxed);
+            }
+        }
+    }
+};
+
+typedef CVerusThreadCounters<CVerusLatencyCounters> CVerusLatencyThreads;
+
+struct CVerusLatencyTotals
+{
+    uint64_t count[VERUS_LATENCY_APIS][VERUS_LATENCY_VERSIONS] = {{0}};
+    uint64_t totalTicks[VERUS_LATENCY_APIS][VERUS_LATENCY_VERSIONS] = {{0}};
+    uint64_t buckets[VERUS_LATENCY_APIS][VERUS_LATENCY_VERSIONS][LATENCY_BUCKETS] = {{{0}}};
+};
+
+static void sum_counters(CVerusLatencyTotals &totals)
+{
+    CVerusLatencyThreads::ForEach([&](const CVerusLatencyCounters &c) {
+        for (int i = 0; i < VERUS_LATENCY_APIS; i++)
+        {
+            for (int j = 0; j < VERUS_LATENCY_VERSIONS; j++)
+            {
+                const CVerusLatencyHistogram *h = c.histograms[i][j].load(std::memory_order_acquire);
+                if (!h)
+                {
+                    continue;
+                }
+                totals.count[i][j] += h->count.load(std::memory_order_relaxed);
+                totals.totalTicks[i][j] += h->totalTicks.load(std::memory_order_relaxed);
+                for (int k = 0; k < LATENCY_BUCKETS; k++)
+                {
+                    totals.buckets[i][j][k] += h->buckets[k].load(std::memory_order_relaxed);
+                }
+            }
+        }
+    });
+}
+
+static double ns_per_tick()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    struct timespec start, now;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    uint64_t startTicks = CVerusLatency::Now(), ns;
+    do
+    {
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        ns = (now.tv_sec - start.tv_sec) * 1000000000ULL + now.tv_nsec - start.tv_nsec;
+    } while (ns < 1000000);
+    return (double)ns / (CVerusLatency::Now() - startTicks);
+#else
+    return 1;
+#endif
+}
+
+double CVerusLatency::NsPerTick()
+{
+    static const double nsPerTick = ns_per_tick();
+    return nsPerTick;
+}
+
+void CVerusLatency::Record(int api, int version, uint64_t ticks)
+{
+    CVerusLatencyCounters &c = CVerusLatencyThreads::Local();
+    CVerusLatencyHistogram *h = c.histograms[api][version].load(std::memory_order_relaxed);
+    if (!h)
+    {
+        // only this thread stores it, readers see it zeroed
+        h = new CVerusLatencyHistogram();
+        CVerusMemory::Alloc(VERUS_MEMORY_THREAD_COUNTERS, sizeof(CVerusLatencyHistogram));
+        c.histograms[api][version].store(h, std::memory_order_release);
+    }
+    VerusCounterAdd(h->count, 1);
+    VerusCounterAdd(h->totalTicks, ticks);
+    VerusCounterAdd(h->buckets[bucket_of(ticks)], 1);
+}
+
+uint64_t CVerusLatency::Read(int api, int version, uint64_t &totalNs, std::vector<uint64_t> *buckets)
+{
+    totalNs = 0;
+    if (api < 0 || api >= VERUS_LATENCY_APIS || version < 0 || version >= VERUS_LATENCY_VERSIONS)
+    {
+        return 0;
+    }
+
+    // on the heap, the totals are 22 KB
+    std::vector<CVerusLatencyTotals> totals(1);
+    sum_counters(totals[0]);
+    const CVerusLatencyTotals &t = totals[0];
+    if (buckets)
+    {
+        buckets->assign(t.buckets[api][version], t.buckets[api][version] + LATENCY_BUCKETS);
+    }
+    totalNs = t.totalTicks[api][version] * NsPerTick();
+    return t.count[api][version];
+}
+
+int CVerusLatency::Buckets()
+{
+    return LATENCY_BUCKETS;
+}
+
+uint64_t CVerusLatency::BucketLow(int bucket)
+{
+    return bucket_low_ticks(bucket) * NsPerTick();
+}
+
+static void append(std::string &out, const char *format, ...) __attribute__((format(printf, 2, 3)));
+
+static void append(std::string &out, const char *format, ...)
+{
+    char line[256];
+    va_list args;
+    va_start(args, format);
+    vsnprintf(line, sizeof(line), format, args);
+    va_end(args);
+    out += line;
+}
+
+std::string CVerusLatency::Prometheus()
+{
+    std::vector<CVerusLatencyTotals> totals(1);
+    sum_counters(totals[0]);
+    const CVerusLatencyTotals &t = totals[0];
+    std::string out;
+
+    // the buckets of the histogram are at 2^e and 1.5 * 2^e ns from 256 ns to about 13 s. the
+    // counts are kept in ticks, so each adds the tick buckets below its edge and the share of the
+    // one around it that is below, as if the calls in that were spread evenly over it
+    double nsPerTick = NsPerTick();
+    out += "# HELP verushash_hash_latency_seconds Latency of hashing calls by API and hash version.\n";
+    out += "# TYPE verushash_hash_latency_seconds histogram\n";
+    for (int i = 0; i < VERUS_LATENCY_APIS; i++)
+    {
+        for (int j = 0; j < VERUS_LATENCY_VERSIONS; j++)
+        {
+            if (!t.count[i][j])
+            {
+                continue;
+            }
+            uint64_t below = 0;
+            int k = 0;
+            for (int e = 8; e < 34; e++)
+            {
+                for (uint64_t le : {1ULL << e, 3ULL << (e - 1)})
+                {
+                    double leTicks = le / nsPerTick;
+                    for (; k < LATENCY_BUCKETS - 1 && bucket_low_ticks(k + 1) <= leTicks; k++)
+                    {
+                        below += t.buckets[i][j][k];
+                    }
+                    uint64_t share = 0;
+                    if (k < LATENCY_BUCKETS - 1)
+                    {
+                        double low = bucket_low_ticks(k), high = bucket_low_ticks(k + 1);
+                        share = t.buckets[i][j][k] * ((leTicks - low) / (high - low)) + 0.5;
+                    }
+                    append(out, "verushash_hash_latency_seconds_bucket{api=\"%s\",version=\"%s\",le=\"%.9g\"} %llu\n",
+                           apiNames[i], versionNames[j], le / 1e9, (unsigned long long)(below + share));
+                }
+            }
+            append(out, "verushash_hash_latency_seconds_bucket{api=\"%s\",version=\"%s\",le=\"+Inf\"} %llu\n",
+                   apiNames[i], versionNames[j], (unsigned long long)t.count[i][j]);
+            append(out, "verushash_hash_latency_seconds_sum{api=\"%s\",version=\"%s\"} %.9g\n",
+                   apiNames[i], versionNames[j], t.totalTicks[i][j] * nsPerTick / 1e9);
+            append(out, "verushash_hash_latency_seconds_count{api=\"%s\",version=\"%s\"} %llu\n",
+                   apiNames[i], versionNames[j], (unsigned long long)t.count[i][j]);
+        }
+    }
+
+    // each quantile is the high end of the bucket that holds it, so never below the real value
+    static const double quantiles[4] = {0.5, 0.9, 0.99, 0.999};
+    out += "# HELP verushash_hash_latency_quantile_seconds Latency quantiles of hashing calls, within 12.5%.\n";
+    out += "# TYPE verushash_hash_latency_quantile_seconds summary\n";
+    for (int i = 0; i < VERUS_LATENCY_APIS; i++)
+    {
+        for (int j = 0; j < VERUS_LATENCY_VERSIONS; j++)
+        {
+            uint64_t count = t.count[i][j], seen = 0;
+            if (!count)
+            {
+                continue;
+            }
+            int next = 0;
+            for (int k = 0; k < LATENCY_BUCKETS && next < 4; k++)
+            {
+                seen += t.buckets[i][j][k];
+                for (; next < 4 && seen >= quantiles[next] * count; next++)
+                {
+                    append(out, "verushash_hash_latency_quantile_seconds{api=\"%s\",version=\"%s\",quantile=\"%g\"} %.9g\n",
+                           apiNames[i], versionNames[j], quantiles[next], bucket_low_ticks(k + 1) * nsPerTick / 1e9);
+                }
+            }
+            append(out, "verushash_hash_latency_quantile_seconds_sum{api=\"%s\",version=\"%s\"} %.9g\n",
+                   apiNames[i], versionNames[j], t.totalTicks[i][j] * nsPerTick / 1e9);
+            append(out, "verushash_hash_latency_quantile_seconds_count{api=\"%s\",version=\"%s\"} %llu\n",
+                   apiNames[i], versionNames[j], (unsigned long long)count);
+        }
+    }
+
+    uint64_t counters[VERUS_COUNTERS];
+    verushash_counters(counters, VERUS_COUNTERS);
+    out += "# HELP verushash_hashes_total Finished hashes by version.\n";
+    out += "# TYPE verushash_hashes_total counter\n";
+    for (int j = 0; j < VERUS_LATENCY_VERSIONS; j++)
+    {
+        append(out, "verushash_hashes_total{version=\"%s\"} %llu\n", versionNames[j],
+               (unsigned long long)counters[VERUS_COUNTER_HASHES_V1 + j]);
+    }
+    for (int c = VERUS_LATENCY_VERSIONS; c < VERUS_COUNTERS; c++)
+    {
+        const char *name = verushash_counter_name(c);
+        append(out, "# TYPE verushash_%s_total counter\nverushash_%s_total %llu\n", name, name, (unsigned long long)counters[c]);
+    }
+
+    static const struct
+    {
+        int field;
+        const char *name, *type, *help;
+    } memoryMetrics[VERUS_MEMORY_FIELDS] = {
+        {VERUS_MEMORY_LIVE, "memory_buffers", "gauge", "Buffers the library holds by kind, keys are one per hashing thread."},
+        {VERUS_MEMORY_BYTES, "memory_bytes", "gauge", "Bytes the library holds by kind."},
+        {VERUS_MEMORY_PEAK_BYTES, "memory_peak_bytes", "gauge", "The most bytes the library held at once by kind."},
+        {VERUS_MEMORY_ALLOCATIONS, "memory_allocations_total", "counter", "Buffer allocations by kind."},
+        {VERUS_MEMORY_FREES, "memory_frees_total", "counter", "Buffer frees by kind."},
+    };
+    for (const auto &m : memoryMetrics)
+    {
+        append(out, "# HELP verushash_%s %s\n# TYPE verushash_%s %s\n", m.name, m.help, m.name, m.type);
+        for (int kind = 0; kind < VERUS_MEMORY_KINDS; kind++)
+        {
+            append(out, "verushash_%s{kind=\"%s\"} %llu\n", m.name, verushash_memory_kind_name(kind),
+                   (unsigned long long)CVerusMemory::Get(kind, m.field));
+        }
+    }
+
+    out += "# HELP verushash_kernel_info The selected hash kernels.\n";
+    out += "# TYPE verushash_kernel_info gauge\n";
+    append(out, "verushash_kernel_info{haraka=\"%s\",clhash=\"%s\",sha256=\"%s\"} 1\n",
+           CVerusKernels::Haraka()->name, CVerusKernels::CLHash()->name, CVerusKernels::SHA256()->name);
+    return out;
+}
+
+int verushash_prometheus(char *buf, int len)
+{
+    std::string text = CVerusLatency::Prometheus();
+    if (buf && len > (int)text.size())
+    {
+        memcpy(buf, text.c_str(), text.size() + 1);
+    }
+    return text.size();
+}
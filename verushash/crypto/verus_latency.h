@@ -0,0 +1,110 @@
+// (C) 2018 The Verus Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+/*
+Latency histograms of the hashing entry points, always built in like the runtime counters in
+verus_counters.h, for latency objectives rather than averages. Every call of an entry point is
+timed with the TSC into a histogram of its API and hash version, held in counters of the calling
+thread, see verus_thread_counters.h. A thread allocates the histogram of an API and version on
+its first call of them, so most threads have one. Each has eight buckets per power of two of
+ticks from 32 ticks, HDR style, so percentiles are read to within 12.5%. Ticks are converted to
+seconds only when the histograms are read, with the tick rate measured over a millisecond the
+first time, so hashing never waits for the measurement.
+
+    verushash       the C API the Go binding calls, one header per call
+    hash_batch      CVerusHash::HashBatch, one call of any width
+
+verushash_prometheus renders the histograms and the runtime counters as Prometheus text
+exposition format, for a service to serve on its own metrics endpoint:
+
+    verushash_hash_latency_seconds          histogram, two buckets per power of two of ns,
+                                            interpolated within the tick bucket around each
+    verushash_hash_latency_quantile_seconds summary, p50 to p99.9 from the full histogram
+    verushash_hashes_total, verushash_bytes_total ... the runtime counters
+    verushash_kernel_info                   the selected kernels, as labels
+
+Both latency metrics have api and version labels, and only those that have seen calls appear.
+*/
+#ifndef VERUS_LATENCY_H_
+#define VERUS_LATENCY_H_
+
+#include <stdint.h>
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+enum {
+    VERUS_LATENCY_VERUSHASH = 0,
+    VERUS_LATENCY_HASH_BATCH = 1,
+    VERUS_LATENCY_APIS = 2
+};
+
+// the histograms and runtime counters as Prometheus text, written to buf with a terminating
+// zero if it fits in len bytes. returns the length without the terminator
+int verushash_prometheus(char *buf, int len);
+
+#ifdef __cplusplus
+} // extern "C"
+
+#include <string>
+#include <vector>
+
+#include "verus_counters.h"
+
+// the versions are VERUS_COUNTER_HASHES_V1 to VERUS_COUNTER_HASHES_V2B2
+static const int VERUS_LATENCY_VERSIONS = VERUS_COUNTER_HASHES_V2B2 + 1;
+
+class CVerusLatency
+{
+    public:
+        // a timestamp in ticks, the TSC on x86, which is read in a few cycles where the monotonic
+        // clock takes tens of nanoseconds, and nanoseconds elsewhere
+        static inline uint64_t Now()
+        {
+#if defined(__x86_64__) || defined(__i386__)
+            return __rdtsc();
+#else
+            struct timespec ts;
+            clock_gettime(CLOCK_MONOTONIC, &ts);
+            return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+#endif
+        }
+
+        // nanoseconds per tick of Now, measured over a millisecond the first time it is needed,
+        // which is never on a hashing call
+        static double NsPerTick();
+
+        // adds one call of ticks to the calling thread's histogram of api and version
+        static void Record(int api, int version, uint64_t ticks);
+
+        // the count and total, and the bucket counts of a histogram over all threads
+        static uint64_t Read(int api, int version, uint64_t &totalNs, std::vector<uint64_t> *buckets = NULL);
+
+        // the number of buckets Read returns, and the low end in ns of each
+        static int Buckets();
+        static uint64_t BucketLow(int bucket);
+
+        static std::string Prometheus();
+};
+
+// times the scope it is declared in as one call
+class CVerusLatencyTimer
+{
+    public:
+        CVerusLatencyTimer(int api, int version) : api(api), version(version), start(CVerusLatency::Now()) {}
+        ~CVerusLatencyTimer() { CVerusLatency::Record(api, version, CVerusLatency::Now() - start); }
+
+    private:
+        int api, version;
+        uint64_t start;
+};
+#endif
+
+#endif
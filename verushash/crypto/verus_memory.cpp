@@ -0,0 +1,170 @@
+// (C) 2018 The Verus Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+/*
+Memory accounting and the release of idle thread keys, see verus_memory.h.
+*/
+
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "verus_memory.h"
+#include "verus_counters.h"
+#include "verus_hash.h"
+#include "verus_latency.h"
+
+static const char *kindNames[VERUS_MEMORY_KINDS] = {"keys", "key_descriptors", "read_buffers", "thread_counters"};
+
+// zero initialized before any dynamic initialization, so allocations during it are counted
+static std::atomic<uint64_t> memoryValues[VERUS_MEMORY_KINDS][VERUS_MEMORY_FIELDS];
+
+void CVerusMemory::Alloc(int kind, uint64_t bytes)
+{
+    std::atomic<uint64_t> *m = memoryValues[kind];
+    m[VERUS_MEMORY_LIVE].fetch_add(1, std::memory_order_relaxed);
+    m[VERUS_MEMORY_ALLOCATIONS].fetch_add(1, std::memory_order_relaxed);
+    uint64_t held = m[VERUS_MEMORY_BYTES].fetch_add(bytes, std::memory_order_relaxed) + bytes;
+    uint64_t peak = m[VERUS_MEMORY_PEAK_BYTES].load(std::memory_order_relaxed);
+    while (held > peak && !m[VERUS_MEMORY_PEAK_BYTES].compare_exchange_weak(peak, held, std::memory_order_relaxed))
+    {
+    }
+}
+
+void CVerusMemory::Free(int kind, uint64_t bytes)
+{
+    std::atomic<uint64_t> *m = memoryValues[kind];
+    m[VERUS_MEMORY_LIVE].fetch_sub(1, std::memory_order_relaxed);
+    m[VERUS_MEMORY_FREES].fetch_add(1, std::memory_order_relaxed);
+    m[VERUS_MEMORY_BYTES].fetch_sub(bytes, std::memory_order_relaxed);
+}
+
+uint64_t CVerusMemory::Get(int kind, int field)
+{
+    if (kind < 0 || kind >= VERUS_MEMORY_KINDS || field < 0 || field >= VERUS_MEMORY_FIELDS)
+    {
+        return 0;
+    }
+    return memoryValues[kind][field].load(std::memory_order_relaxed);
+}
+
+// a thread's claim on its key and when it last gave it up, registered for the whole life of the
+// thread. claimed is 1 while the thread or a release holds the key, depth counts the thread's
+// own nested claims and is only touched by the thread
+struct CVerusKeyOwner
+{
+    std::atomic<int> claimed;
+    std::atomic<uint64_t> lastUsed;
+    int depth = 0;
+    thread_specific_ptr *key, *descr;
+
+    CVerusKeyOwner();
+    ~CVerusKeyOwner();
+};
+
+static std::mutex &owners_lock()
+{
+    // never destroyed, so threads that exit during static destruction can still unregister
+    static std::mutex *lock = new std::mutex;
+    return *lock;
+}
+
+static std::vector<CVerusKeyOwner *> &owners()
+{
+    static std::vector<CVerusKeyOwner *> *registry = new std::vector<CVerusKeyOwner *>;
+    return *registry;
+}
+
+CVerusKeyOwner::CVerusKeyOwner() : claimed(0), lastUsed(CVerusLatency::Now())
+{
+    // taking the addresses initializes the key pointers first, so that at thread exit they
+    // are destroyed after this has unregistered, and no release can touch them then
+    key = &verusclhasher_key;
+    descr = &verusclhasher_descr;
+    std::lock_guard<std::mutex> lock(owners_lock());
+    owners().push_back(this);
+}
+
+CVerusKeyOwner::~CVerusKeyOwner()
+{
+    std::lock_guard<std::mutex> lock(owners_lock());
+    owners().erase(std::find(owners().begin(), owners().end(), this));
+}
+
+static thread_local CVerusKeyOwner keyOwner;
+
+void CVerusMemory::ClaimKey()
+{
+    CVerusKeyOwner &o = keyOwner;
+    if (o.depth++)
+    {
+        return;
+    }
+    // a release holds the claim only while it frees the two buffers
+    while (o.claimed.exchange(1, std::memory_order_acquire))
+    {
+        std::this_thread::yield();
+    }
+}
+
+void CVerusMemory::UnclaimKey()
+{
+    CVerusKeyOwner &o = keyOwner;
+    if (--o.depth)
+    {
+        return;
+    }
+    o.lastUsed.store(CVerusLatency::Now(), std::memory_order_relaxed);
+    o.claimed.store(0, std::memory_order_release);
+}
+
+int CVerusMemory::ReleaseIdleKeys(uint64_t idleNs)
+{
+    uint64_t idleTicks = idleNs / CVerusLatency::NsPerTick();
+    int released = 0;
+
+    std::lock_guard<std::mutex> lock(owners_lock());
+    for (CVerusKeyOwner *o : owners())
+    {
+        int unclaimed = 0;
+        if (!o->claimed.compare_exchange_strong(unclaimed, 1, std::memory_order_acquire))
+        {
+            continue;
+        }
+        uint64_t now = CVerusLatency::Now(), lastUsed = o->lastUsed.load(std::memory_order_relaxed);
+        if (o->key->get() && now >= lastUsed && now - lastUsed >= idleTicks)
+        {
+            o->key->reset();
+            o->descr->reset();
+            released++;
+        }
+        o->claimed.store(0, std::memory_order_release);
+    }
+    if (released)
+    {
+        CVerusCounters::AddShared(VERUS_COUNTER_KEY_RELEASES, released);
+    }
+    return released;
+}
+
+int verushash_memory(uint64_t *values, int count)
+{
+    for (int i = 0; i < count && i < VERUS_MEMORY_KINDS * VERUS_MEMORY_FIELDS; i++)
+    {
+        values[i] = CVerusMemory::Get(i / VERUS_MEMORY_FIELDS, i % VERUS_MEMORY_FIELDS);
+    }
+    return VERUS_MEMORY_KINDS * VERUS_MEMORY_FIELDS;
+}
+
+const char *verushash_memory_kind_name(int kind)
+{
+    return (kind >= 0 && kind < VERUS_MEMORY_KINDS) ? kindNames[kind] : NULL;
+}
+
+int verushash_release_idle_keys(uint64_t idle_ms)
+{
+    return CVerusMemory::ReleaseIdleKeys(idle_ms * 1000000);
+}
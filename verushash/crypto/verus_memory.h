@@ -0,0 +1,94 @@
+// (C) 2018 The Verus Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+/*
+Accounting of the memory the library holds, always built in like the runtime counters, and the
+release of the CLHash keys of threads that have stopped hashing.
+
+    keys                each thread that runs VerusHash 2b keeps a CLHash key, its refresh copy
+                        and move scratch, about 17 KB, from its first hash until it exits, so
+                        the live count is the number of threads with a hashing context
+    key_descriptors     the seed and size of each of those keys
+    read_buffers        the read ahead buffers of CVerusFileHasher, while a file is hashed
+    thread_counters     the per thread blocks of the runtime counters, latency histograms and
+                        stats builds, which are kept for the next new thread when one exits
+
+Each kind has the buffers and bytes held now, the most bytes ever held at once, and the
+allocations and frees since the process started, whose rate is the allocations per second.
+These are rare events, counted in shared atomics.
+
+A thread's key is only freed when the thread exits, which with a pool that grows and shrinks,
+such as Go's threads for cgo calls, can be long after its last hash. verushash_release_idle_keys
+frees the keys of threads that have not hashed for a given time, from any thread. A thread
+claims its key, see CVerusKeyClaim, while it sets up or finalizes a hash, and a claimed key is
+never released, so a released thread simply allocates and generates its key again on its next
+hash. Code that uses the thread's key directly, outside CVerusHashV2, must not race with a
+release.
+*/
+#ifndef VERUS_MEMORY_H_
+#define VERUS_MEMORY_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+enum {
+    VERUS_MEMORY_KEYS = 0,
+    VERUS_MEMORY_KEY_DESCRIPTORS = 1,
+    VERUS_MEMORY_READ_BUFFERS = 2,
+    VERUS_MEMORY_THREAD_COUNTERS = 3,
+    VERUS_MEMORY_KINDS = 4
+};
+
+enum {
+    VERUS_MEMORY_LIVE = 0,              // buffers allocated and not yet freed
+    VERUS_MEMORY_BYTES = 1,             // the bytes they hold
+    VERUS_MEMORY_PEAK_BYTES = 2,        // the most bytes held at once
+    VERUS_MEMORY_ALLOCATIONS = 3,
+    VERUS_MEMORY_FREES = 4,
+    VERUS_MEMORY_FIELDS = 5
+};
+
+// values[kind * VERUS_MEMORY_FIELDS + field] for the first count of them, returning
+// VERUS_MEMORY_KINDS * VERUS_MEMORY_FIELDS
+int verushash_memory(uint64_t *values, int count);
+
+// a lower case name for each kind, such as "keys", or NULL for an unknown one
+const char *verushash_memory_kind_name(int kind);
+
+// frees the keys of threads that have not started or finished a hash for idle_ms milliseconds,
+// returning how many were freed
+int verushash_release_idle_keys(uint64_t idle_ms);
+
+#ifdef __cplusplus
+} // extern "C"
+
+class CVerusMemory
+{
+    public:
+        static void Alloc(int kind, uint64_t bytes);
+        static void Free(int kind, uint64_t bytes);
+
+        // a field of a kind, or 0 for unknown ones
+        static uint64_t Get(int kind, int field);
+
+        // the calling thread's claim on its key, see CVerusKeyClaim
+        static void ClaimKey();
+        static void UnclaimKey();
+
+        static int ReleaseIdleKeys(uint64_t idleNs);
+};
+
+// holds the calling thread's key for the scope, so verushash_release_idle_keys leaves it
+class CVerusKeyClaim
+{
+    public:
+        CVerusKeyClaim() { CVerusMemory::ClaimKey(); }
+        ~CVerusKeyClaim() { CVerusMemory::UnclaimKey(); }
+};
+#endif
+
+#endif
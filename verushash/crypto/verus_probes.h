@@ -0,0 +1,81 @@
+// (C) 2018 The Verus Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+/*
+USDT static probes, for attaching bpftrace or other tracers to a running process without
+rebuilding it. Each probe is a single nop in the code and an ELF note naming it and where its
+arguments are, and costs nothing more until a tracer patches the nop. The provider is verushash:
+
+    hash_entry      version, length         a Verushash:: entry point starts, the version is a
+    hash_return     version, length         VERUS_COUNTER_HASHES_ value, the length in bytes
+    key_generate    key, size               GenNewCLKey generates the key for a new seed
+    key_restore     key, size               GenNewCLKey copies back the mutated part for the same seed
+    key_alloc       key, size               a thread allocates its key buffer
+    key_free        key                     a thread's key buffer is freed
+    batch_start     count, bytes            CVerusHash::HashBatch
+    batch_end       count
+    chunk_enqueue   offset, size            CVerusFileHasher starts reading a chunk ahead
+    chunk_dequeue   size                    and takes it to hash
+
+The probes/ directory has bpftrace scripts that use them. The notes are those of systemtap's
+sys/sdt.h, which is used when it is installed, and written here for x86-64 ELF when it is not.
+Elsewhere, and when VERUSHASH_NO_PROBES is defined, the probes are empty.
+*/
+#ifndef VERUS_PROBES_H_
+#define VERUS_PROBES_H_
+
+#include <stdint.h>
+
+#if !defined(VERUSHASH_NO_PROBES) && defined(__has_include)
+#if __has_include(<sys/sdt.h>)
+#include <sys/sdt.h>
+#define VERUS_PROBE(name) STAP_PROBE(verushash, name)
+#define VERUS_PROBE1(name, a) STAP_PROBE1(verushash, name, a)
+#define VERUS_PROBE2(name, a, b) STAP_PROBE2(verushash, name, a, b)
+#define VERUS_PROBES_ENABLED
+#endif
+#endif
+
+#if !defined(VERUSHASH_NO_PROBES) && !defined(VERUS_PROBES_ENABLED) && defined(__x86_64__) && defined(__ELF__)
+// a version 3 stapsdt note: the probe address, the base used to relocate it, no semaphore, the
+// provider, name and argument list. Every argument is passed as a signed 64 bit value, -8@
+// followed by the operand, always a register or immediate, as tracers don't all read segment
+// relative memory operands such as those of thread local variables
+#define VERUS_PROBE_ASM(name, args, ...) \
+    __asm__ __volatile__("990: nop\n" \
+                         ".pushsection .note.stapsdt,\"?\",\"note\"\n" \
+                         ".balign 4\n" \
+                         ".4byte 992f-991f, 994f-993f, 3\n" \
+                         "991: .asciz \"stapsdt\"\n" \
+                         "992: .balign 4\n" \
+                         "993: .8byte 990b\n" \
+                         ".8byte _.stapsdt.base\n" \
+                         ".8byte 0\n" \
+                         ".asciz \"verushash\"\n" \
+                         ".asciz \"" #name "\"\n" \
+                         ".asciz \"" args "\"\n" \
+                         "994: .balign 4\n" \
+                         ".popsection\n" \
+                         ".ifndef _.stapsdt.base\n" \
+                         ".pushsection .stapsdt.base,\"aG\",\"progbits\",.stapsdt.base,comdat\n" \
+                         ".weak _.stapsdt.base\n" \
+                         ".hidden _.stapsdt.base\n" \
+                         "_.stapsdt.base: .space 1\n" \
+                         ".size _.stapsdt.base, 1\n" \
+                         ".popsection\n" \
+                         ".endif\n" \
+                         :: __VA_ARGS__)
+#define VERUS_PROBE(name) VERUS_PROBE_ASM(name, "")
+#define VERUS_PROBE1(name, a) VERUS_PROBE_ASM(name, "-8@%0", "nr"((int64_t)(a)))
+#define VERUS_PROBE2(name, a, b) VERUS_PROBE_ASM(name, "-8@%0 -8@%1", "nr"((int64_t)(a)), "nr"((int64_t)(b)))
+#define VERUS_PROBES_ENABLED
+#endif
+
+#ifndef VERUS_PROBES_ENABLED
+#define VERUS_PROBE(name)
+#define VERUS_PROBE1(name, a)
+#define VERUS_PROBE2(name, a, b)
+#endif
+
+#endif
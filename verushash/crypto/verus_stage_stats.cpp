@@ -0,0 +1,187 @@
+// (C) 2018 The Verus Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+/*
+Per thread stage counters for CVerusStageStats, see verus_stage_stats.h.
+*/
+
+#include <stdio.h>
+
+#include <mutex>
+#include <vector>
+
+#include "verus_stage_stats.h"
+#include "verus_thread_counters.h"
+
+// values below 16 have a bucket each, above that eight per power of two up to 2^64
+static const int STAGE_BUCKETS = 16 + (64 - 4) * 8;
+
+static const char *stageNames[VERUS_STAGES] = {
+    "deserialize", "pbaas_check", "write", "keygen", "key_restore", "clhash", "final_haraka"
+};
+
+static inline int bucket_of(uint64_t cycles)
+{
+    if (cycles < 16)
+    {
+        return (int)cycles;
+    }
+    int e = 63 - __builtin_clzll(cycles);
+    return 16 + (e - 4) * 8 + (int)((cycles >> (e - 3)) & 7);
+}
+
+static inline uint64_t bucket_low(int bucket)
+{
+    if (bucket < 16)
+    {
+        return bucket;
+    }
+    int e = (bucket - 16) / 8 + 4;
+    return (8ULL + (bucket - 16) % 8) << (e - 3);
+}
+
+// the counters of one thread, see verus_thread_counters.h
+struct CVerusStageCounters
+{
+    std::atomic<uint64_t> count[VERUS_STAGES];
+    std::atomic<uint64_t> cycles[VERUS_STAGES];
+    std::atomic<uint64_t> buckets[VERUS_STAGES][STAGE_BUCKETS];
+
+    CVerusStageCounters()
+    {
+        for (int i = 0; i < VERUS_STAGES; i++)
+        {
+            count[i].store(0, std::memory_order_relaxed);
+            cycles[i].store(0, std::memory_order_relaxed);
+            for (int j = 0; j < STAGE_BUCKETS; j++)
+            {
+                buckets[i][j].store(0, std::memory_order_relaxed);
+            }
+        }
+    }
+};
+
+typedef CVerusThreadCounters<CVerusStageCounters> CVerusStageThreads;
+
+// sums over all counters, and what they were at the last Reset
+struct CVerusStageTotals
+{
+    uint64_t count[VERUS_STAGES] = {0};
+    uint64_t cycles[VERUS_STAGES] = {0};
+    uint64_t buckets[VERUS_STAGES][STAGE_BUCKETS] = {{0}};
+};
+
+// the totals at the last Reset. resetLock is held around reading the counters together with
+// them, so a Reset can't fall between the two
+static std::mutex &resetLock = *new std::mutex;
+static CVerusStageTotals &resetTotals = *new CVerusStageTotals;
+
+static void sum_counters(CVerusStageTotals &totals)
+{
+    CVerusStageThreads::ForEach([&](const CVerusStageCounters &c) {
+        for (int i = 0; i < VERUS_STAGES; i++)
+        {
+            totals.count[i] += c.count[i].load(std::memory_order_relaxed);
+            totals.cycles[i] += c.cycles[i].load(std::memory_order_relaxed);
+            for (int j = 0; j < STAGE_BUCKETS; j++)
+            {
+                totals.buckets[i][j] += c.buckets[i][j].load(std::memory_order_relaxed);
+            }
+        }
+    });
+}
+
+bool CVerusStageStats::Enabled()
+{
+#ifdef VERUSHASH_STAGE_STATS
+    return true;
+#else
+    return false;
+#endif
+}
+
+const char *CVerusStageStats::StageName(int stage)
+{
+    return (stage >= 0 && stage < VERUS_STAGES) ? stageNames[stage] : "unknown";
+}
+
+void CVerusStageStats::Record(int stage, uint64_t cycles)
+{
+    CVerusStageCounters &c = CVerusStageThreads::Local();
+    VerusCounterAdd(c.count[stage], 1);
+    VerusCounterAdd(c.cycles[stage], cycles);
+    VerusCounterAdd(c.buckets[stage][bucket_of(cycles)], 1);
+}
+
+CVerusStageSummary CVerusStageStats::Summary(int stage)
+{
+    CVerusStageSummary s = {StageName(stage), 0, 0, 0, 0, 0, 0, 0};
+    if (stage < 0 || stage >= VERUS_STAGES)
+    {
+        return s;
+    }
+
+    // on the heap, the totals are 27 KB each
+    std::vector<CVerusStageTotals> totals(2);
+    {
+        std::lock_guard<std::mutex> lock(resetLock);
+        sum_counters(totals[0]);
+        totals[1] = resetTotals;
+    }
+
+    const CVerusStageTotals &t = totals[0], &base = totals[1];
+    uint64_t count = t.count[stage] - base.count[stage];
+    if (!count)
+    {
+        return s;
+    }
+    s.count = count;
+    s.average = (double)(t.cycles[stage] - base.cycles[stage]) / count;
+
+    // the sample at each rank is the low end of the bucket that holds it
+    const double ranks[4] = {0.5, 0.9, 0.99, 0.999};
+    uint64_t *percentiles[4] = {&s.p50, &s.p90, &s.p99, &s.p999};
+    uint64_t seen = 0;
+    int next = 0;
+    for (int j = 0; j < STAGE_BUCKETS; j++)
+    {
+        uint64_t n = t.buckets[stage][j] - base.buckets[stage][j];
+        if (!n)
+        {
+            continue;
+        }
+        seen += n;
+        while (next < 4 && seen >= ranks[next] * count)
+        {
+            *percentiles[next++] = bucket_low(j);
+        }
+        s.max = bucket_low(j);
+    }
+    return s;
+}
+
+std::string CVerusStageStats::Report()
+{
+    std::string report;
+    char line[160];
+    for (int i = 0; i < VERUS_STAGES; i++)
+    {
+        CVerusStageSummary s = Summary(i);
+        if (s.count)
+        {
+            snprintf(line, sizeof(line), "%-13s %10llu samples %10.1f avg %8llu p50 %8llu p90 %8llu p99 %8llu p99.9 %8llu max cycles\n",
+                     s.name, (unsigned long long)s.count, s.average, (unsigned long long)s.p50, (unsigned long long)s.p90,
+                     (unsigned long long)s.p99, (unsigned long long)s.p999, (unsigned long long)s.max);
+            report += line;
+        }
+    }
+    return report;
+}
+
+void CVerusStageStats::Reset()
+{
+    std::lock_guard<std::mutex> lock(resetLock);
+    resetTotals = CVerusStageTotals();
+    sum_counters(resetTotals);
+}
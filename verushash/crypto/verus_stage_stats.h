@@ -0,0 +1,94 @@
+// (C) 2018 The Verus Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+/*
+Cycle accounting for the stages of a VerusHash 2b hash, from the serialized header to the
+final keyed Haraka. It only exists in builds configured with -DVERUSHASH_STAGE_STATS=ON,
+which defines VERUSHASH_STAGE_STATS for every file. Without it the VERUS_STAGE_ macros are
+empty and nothing here is called, so normal builds run exactly the same code as before.
+
+Each stage is timed with rdtscp into counters of the calling thread, which only that thread
+writes, so recording takes no locks or atomic read-modify-writes. Every thread's counters hold
+the exact count and total cycles of each stage, and a histogram with eight buckets per power
+of two, from which the percentiles are read to within 12.5%. Counters outlive their thread
+and are handed to the next new thread, so totals survive thread churn.
+
+    CVerusStageSummary s = CVerusStageStats::Summary(VERUS_STAGE_CLHASH);
+    printf("%s %.0f cycles average, %llu p99\n", s.name, s.average, (unsigned long long)s.p99);
+
+Summary and Reset can be called from any thread while hashing goes on.
+*/
+#ifndef VERUS_STAGE_STATS_H_
+#define VERUS_STAGE_STATS_H_
+
+#include <stdint.h>
+#include <string>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+enum VerusHashStage {
+    VERUS_STAGE_DESERIALIZE = 0,        // CBlockHeader from the serialized bytes, Verushash::verushash_v2b2
+    VERUS_STAGE_PBAAS_CHECK = 1,        // CheckNonCanonicalData and clearing it, GetVerusV2Hash of PBaaS headers
+    VERUS_STAGE_WRITE = 2,              // absorbing the input with CVerusHashV2::Write
+    VERUS_STAGE_KEYGEN = 3,             // GenNewCLKey for a new seed, chaining Haraka256 over the key
+    VERUS_STAGE_KEY_RESTORE = 4,        // GenNewCLKey for the current seed, copying back the mutated part
+    VERUS_STAGE_CLHASH = 5,
+    VERUS_STAGE_FINAL_HARAKA = 6,       // haraka512Keyed with the mutated key
+    VERUS_STAGES = 7
+};
+
+struct CVerusStageSummary
+{
+    const char *name;
+    uint64_t count;
+    double average;                     // exact, cycles
+    uint64_t p50, p90, p99, p999, max;  // from the histogram, the low end of the bucket
+};
+
+class CVerusStageStats
+{
+    public:
+        // true if the library was built with VERUSHASH_STAGE_STATS
+        static bool Enabled();
+
+        static const char *StageName(int stage);
+
+        static inline uint64_t Now()
+        {
+#if defined(__x86_64__) || defined(__i386__)
+            unsigned int aux;
+            return __rdtscp(&aux);
+#else
+            return 0;
+#endif
+        }
+
+        // adds one sample to the calling thread's counters
+        static void Record(int stage, uint64_t cycles);
+
+        // totals of all threads since the last Reset
+        static CVerusStageSummary Summary(int stage);
+
+        // one line per stage with samples, for logs and tools
+        static std::string Report();
+
+        static void Reset();
+};
+
+#ifdef VERUSHASH_STAGE_STATS
+// VERUS_STAGE_START starts a timer, VERUS_STAGE_END records the cycles since then for a stage and
+// VERUS_STAGE_NEXT does the same and restarts the timer, for stages that follow each other
+#define VERUS_STAGE_START(timer) uint64_t timer = CVerusStageStats::Now()
+#define VERUS_STAGE_END(stage, timer) CVerusStageStats::Record(stage, CVerusStageStats::Now() - (timer))
+#define VERUS_STAGE_NEXT(stage, timer) \
+    do { uint64_t now_ = CVerusStageStats::Now(); CVerusStageStats::Record(stage, now_ - (timer)); timer = now_; } while (0)
+#else
+#define VERUS_STAGE_START(timer)
+#define VERUS_STAGE_END(stage, timer)
+#define VERUS_STAGE_NEXT(stage, timer)
+#endif
+
+#endif
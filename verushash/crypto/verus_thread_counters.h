@@ -0,0 +1,117 @@
+// (C) 2018 The Verus Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+/*
+Counters that each hashing thread updates without locks or atomic read-modify-writes, for the
+instrumentation in verus_stage_stats.h and verus_clhash_stats.h. T is a struct of
+std::atomic<uint64_t> counters, zeroed by its constructor, that only its owning thread adds to
+with VerusCounterAdd. Any thread can read all of them at once with ForEach.
+
+The counters of a thread are kept when it exits and handed to the next new thread, so totals
+survive thread churn and memory stays bounded by the largest number of threads alive at once.
+*/
+#ifndef VERUS_THREAD_COUNTERS_H_
+#define VERUS_THREAD_COUNTERS_H_
+
+#include <stdint.h>
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+#include "verus_memory.h"
+
+// only the owning thread writes a counter, so a plain load and store is enough
+static inline void VerusCounterAdd(std::atomic<uint64_t> &counter, uint64_t n)
+{
+    counter.store(counter.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+}
+
+template <typename T>
+class CVerusThreadCounters
+{
+    public:
+        // the calling thread's counters
+        static inline T &Local()
+        {
+            return local ? local->counters : Adopt();
+        }
+
+        // f(const T &) for the counters of every thread, live or exited, under the lock
+        template <typename F>
+        static void ForEach(F f)
+        {
+            std::lock_guard<std::mutex> lock(Lock());
+            for (const Entry *pe : Registry())
+            {
+                f(pe->counters);
+            }
+        }
+
+        // held by ForEach, so a reader can keep its own state consistent with the counters
+        static std::mutex &Lock()
+        {
+            // never destroyed, so threads that exit during static destruction can still release their counters
+            static std::mutex *lock = new std::mutex;
+            return *lock;
+        }
+
+    private:
+        struct Entry
+        {
+            T counters;
+            bool inUse = true;          // owned by a live thread, under Lock
+        };
+
+        // releases the thread's counters when it exits
+        struct Owner
+        {
+            Entry *entry = NULL;
+
+            ~Owner()
+            {
+                if (entry)
+                {
+                    std::lock_guard<std::mutex> lock(Lock());
+                    entry->inUse = false;
+                    local = NULL;
+                }
+            }
+        };
+
+        // local is a plain pointer so that Local() needs no TLS wrapper call, only Adopt touches owner
+        static thread_local Entry *local;
+        static thread_local Owner owner;
+
+        static std::vector<Entry *> &Registry()
+        {
+            static std::vector<Entry *> *registry = new std::vector<Entry *>;
+            return *registry;
+        }
+
+        // the counters of an exited thread if there are any, or new ones
+        static T &Adopt()
+        {
+            std::lock_guard<std::mutex> lock(Lock());
+            for (Entry *pe : Registry())
+            {
+                if (!pe->inUse)
+                {
+                    pe->inUse = true;
+                    owner.entry = local = pe;
+                    return pe->counters;
+                }
+            }
+            Registry().push_back(new Entry());
+            CVerusMemory::Alloc(VERUS_MEMORY_THREAD_COUNTERS, sizeof(Entry));
+            owner.entry = local = Registry().back();
+            return local->counters;
+        }
+};
+
+template <typename T>
+thread_local typename CVerusThreadCounters<T>::Entry *CVerusThreadCounters<T>::local = NULL;
+template <typename T>
+thread_local typename CVerusThreadCounters<T>::Owner CVerusThreadCounters<T>::owner;
+
+#endif
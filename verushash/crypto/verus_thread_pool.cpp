@@ -0,0 +1,140 @@
+// (C) 2018 The Verus Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+/*
+The batch hashing workers, see verus_thread_pool.h.
+*/
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <system_error>
+#include <thread>
+
+#include "verus_thread_pool.h"
+
+// a ForEach call, on its caller's stack. helpers and running are under the pool lock
+struct CVerusPoolJob
+{
+    const std::function<void(size_t, size_t)> *fn;
+    size_t count, grain;
+    std::atomic<size_t> next;
+    int helpers;                        // workers that may still join
+    int running;                        // workers in Run
+    std::condition_variable finished;
+
+    CVerusPoolJob(const std::function<void(size_t, size_t)> *f, size_t c, size_t g, int h) :
+        fn(f), count(c), grain(g), next(0), helpers(h), running(0) {}
+
+    void Run()
+    {
+        size_t begin;
+        while ((begin = next.fetch_add(grain, std::memory_order_relaxed)) < count)
+        {
+            (*fn)(begin, std::min(count, begin + grain));
+        }
+    }
+};
+
+// never destroyed, the workers are detached and may still wait on it during static destruction
+struct CVerusPool
+{
+    std::mutex lock;
+    std::condition_variable work;
+    std::deque<CVerusPoolJob *> jobs;
+    int workers = 0;
+};
+
+static CVerusPool &pool()
+{
+    static CVerusPool *p = new CVerusPool;
+    return *p;
+}
+
+static void worker()
+{
+    CVerusPool &p = pool();
+    std::unique_lock<std::mutex> lock(p.lock);
+    for (;;)
+    {
+        p.work.wait(lock, [&p]() { return !p.jobs.empty(); });
+        CVerusPoolJob *job = p.jobs.front();
+        if (!--job->helpers)
+        {
+            p.jobs.pop_front();
+        }
+        job->running++;
+        lock.unlock();
+        job->Run();
+        lock.lock();
+        if (!--job->running)
+        {
+            job->finished.notify_all();
+        }
+    }
+}
+
+int CVerusThreadPool::DefaultThreads()
+{
+    return std::max(1, (int)std::thread::hardware_concurrency());
+}
+
+int CVerusThreadPool::Workers()
+{
+    CVerusPool &p = pool();
+    std::lock_guard<std::mutex> lock(p.lock);
+    return p.workers;
+}
+
+void CVerusThreadPool::ForEach(size_t count, int threads, size_t grain, const std::function<void(size_t, size_t)> &fn)
+{
+    grain = std::max(grain, (size_t)1);
+    size_t runs = (count + grain - 1) / grain;
+    threads = std::min((size_t)(threads > 0 ? threads : DefaultThreads()), std::max(runs, (size_t)1));
+    int helpers = std::min(threads, MAX_WORKERS + 1) - 1;
+    if (!helpers)
+    {
+        for (size_t begin = 0; begin < count; begin += grain)
+        {
+            fn(begin, std::min(count, begin + grain));
+        }
+        return;
+    }
+
+    CVerusPoolJob job(&fn, count, grain, helpers);
+    CVerusPool &p = pool();
+    {
+        std::lock_guard<std::mutex> lock(p.lock);
+        try
+        {
+            for (; p.workers < helpers; p.workers++)
+            {
+                std::thread(worker).detach();
+            }
+        }
+        catch (const std::system_error &)
+        {
+            // out of threads, the job takes the workers there are, or none
+            job.helpers = p.workers;
+        }
+        if (job.helpers)
+        {
+            p.jobs.push_back(&job);
+        }
+    }
+    p.work.notify_all();
+
+    job.Run();
+
+    // no worker joins once the job is off the queue, and those that did have nothing left to
+    // take, so this only waits for the runs they are in
+    std::unique_lock<std::mutex> lock(p.lock);
+    if (job.helpers)
+    {
+        p.jobs.erase(std::find(p.jobs.begin(), p.jobs.end(), &job));
+    }
+    job.finished.wait(lock, [&job]() { return !job.running; });
+}
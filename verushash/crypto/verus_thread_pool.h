@@ -0,0 +1,40 @@
+// (C) 2018 The Verus Developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+/*
+The worker threads batch hashing is spread over. Workers are started the first time a batch asks
+for them and then wait for the next batch, so each keeps its thread local CLHash key warm from
+one batch to the next, instead of every batch allocating and generating keys on new threads.
+Idle workers' keys are freed by verushash_release_idle_keys like those of any other thread.
+
+ForEach splits [0, count) into runs of grain items that the calling thread and up to threads - 1
+workers take in turn, so a slow item only holds up its own thread. Batches from several threads
+at once share the workers.
+*/
+#ifndef VERUS_THREAD_POOL_H_
+#define VERUS_THREAD_POOL_H_
+
+#include <stddef.h>
+#include <functional>
+
+class CVerusThreadPool
+{
+    public:
+        // the most workers ever started, beyond that batches share them
+        static const int MAX_WORKERS = 256;
+
+        // one thread per hardware thread
+        static int DefaultThreads();
+
+        // calls fn(begin, end) for runs of at most grain items that cover [0, count) once, on
+        // the calling thread and up to threads - 1 workers, 0 for DefaultThreads(), and returns
+        // when all have been called. when no more workers can be started it makes do with those
+        // there are, or the calling thread alone. fn must not throw
+        static void ForEach(size_t count, int threads, size_t grain, const std::function<void(size_t, size_t)> &fn);
+
+        // workers started so far
+        static int Workers();
+};
+
+#endif
@@ -0,0 +1,146 @@
+package VH
+
+/*
+#cgo LDFLAGS: -L${SRCDIR}/build -l:libverushash.a -lsodium
+#include <stdint.h>
+#include "verushash.h"
+#include "crypto/verus_counters.h"
+
+// the hash is returned in a struct by value, so it is copied onto the Go stack and no Go
+// pointer to the result has to escape to the heap
+typedef struct { uint8_t hash[32]; int status; } verushash_result;
+
+static verushash_result hash_v1(const uint8_t *data, size_t len)
+{
+    verushash_result r;
+    verushash_v1(data, len, r.hash);
+    r.status = 0;
+    return r;
+}
+
+static verushash_result hash_v2(const uint8_t *data, size_t len)
+{
+    verushash_result r;
+    verushash_v2(data, len, r.hash);
+    r.status = 0;
+    return r;
+}
+
+static verushash_result hash_v2b(const uint8_t *data, size_t len)
+{
+    verushash_result r;
+    verushash_v2b(data, len, r.hash);
+    r.status = 0;
+    return r;
+}
+
+static verushash_result hash_v2b1(const uint8_t *data, size_t len)
+{
+    verushash_result r;
+    verushash_v2b1(data, len, r.hash);
+    r.status = 0;
+    return r;
+}
+
+static verushash_result hash_v2b2(const uint8_t *data, size_t len)
+{
+    verushash_result r;
+    r.status = verushash_v2b2(data, len, r.hash);
+    return r;
+}
+*/
+import "C"
+
+import "unsafe"
+
+// the hash versions of Batch
+const (
+	VersionV1   = C.VERUS_COUNTER_HASHES_V1
+	VersionV2   = C.VERUS_COUNTER_HASHES_V2
+	VersionV2B  = C.VERUS_COUNTER_HASHES_V2B
+	VersionV2B1 = C.VERUS_COUNTER_HASHES_V2B1
+	VersionV2B2 = C.VERUS_COUNTER_HASHES_V2B2
+)
+
+// The hash functions pass the Go slice itself to C, which the cgo rules allow for memory that
+// holds no Go pointers. It stays where it is and alive for the call, so nothing is copied and
+// a hash allocates nothing.
+
+// cbytes returns the pointer and length to pass for b, nil for an empty slice
+func cbytes(b []byte) (*C.uint8_t, C.size_t) {
+	if len(b) == 0 {
+		return nil, 0
+	}
+	return (*C.uint8_t)(unsafe.Pointer(&b[0])), C.size_t(len(b))
+}
+
+func result(r C.verushash_result) [32]byte {
+	return *(*[32]byte)(unsafe.Pointer(&r.hash[0]))
+}
+
+// HashV1 returns the VerusHash 1.0 hash of b
+func HashV1(b []byte) [32]byte {
+	p, n := cbytes(b)
+	return result(C.hash_v1(p, n))
+}
+
+// HashV2 returns the VerusHash 2.0 hash of b
+func HashV2(b []byte) [32]byte {
+	p, n := cbytes(b)
+	return result(C.hash_v2(p, n))
+}
+
+// HashV2B returns the VerusHash 2b hash of b
+func HashV2B(b []byte) [32]byte {
+	p, n := cbytes(b)
+	return result(C.hash_v2b(p, n))
+}
+
+// HashV2B1 returns the VerusHash 2b1 hash of b
+func HashV2B1(b []byte) [32]byte {
+	p, n := cbytes(b)
+	return result(C.hash_v2b1(p, n))
+}
+
+// HashV2B2 returns the VerusHash 2b2 hash of the serialized block header b, and false with a
+// zero hash when b does not parse as one
+func HashV2B2(b []byte) ([32]byte, bool) {
+	p, n := cbytes(b)
+	r := C.hash_v2b2(p, n)
+	return result(r), r.status == 0
+}
+
+// Batch hashes the inputs packed in data with version into out, in one call into the library.
+// Input i starts at offsets[i] and ends at offsets[i+1], the last one at len(data). They are
+// spread over threads threads of the library's pool, the calling one included, 0 for one per
+// hardware thread. Unless status is nil, status[i] is 0 for input i, or -1 for a V2b2 header
+// that did not parse, whose hash is zero. It returns how many did not, or -1 without hashing
+// for an unknown version or offsets out of order or past len(data). out and status must hold
+// at least len(offsets) entries.
+func Batch(version int, data []byte, offsets []int, out [][32]byte, status []int32, threads int) int {
+	if len(offsets) == 0 {
+		return 0
+	}
+	if len(out) < len(offsets) {
+		panic("VH: out is shorter than the batch")
+	}
+	var ps *C.int
+	if status != nil {
+		if len(status) < len(offsets) {
+			panic("VH: status is shorter than the batch")
+		}
+		ps = (*C.int)(unsafe.Pointer(&status[0]))
+	}
+	p, n := cbytes(data)
+	return int(C.verushash_batch(C.int(version), p, n, (*C.size_t)(unsafe.Pointer(&offsets[0])),
+		C.size_t(len(offsets)), (*C.uint8_t)(unsafe.Pointer(&out[0][0])), ps, C.int(threads)))
+}
+
+// Batch passes offsets as the size_t array it is in memory, so this fails to compile where int
+// and size_t differ in size. A negative offset is a size_t past len(data), which it rejects
+var _ [unsafe.Sizeof(int(0)) - unsafe.Sizeof(C.size_t(0))]struct{}
+var _ [unsafe.Sizeof(C.size_t(0)) - unsafe.Sizeof(int(0))]struct{}
+
+// and status as the int array
+var _ [unsafe.Sizeof(int32(0)) - unsafe.Sizeof(C.int(0))]struct{}
+var _ [unsafe.Sizeof(C.int(0)) - unsafe.Sizeof(int32(0))]struct{}
@@ -410,7 +410,9 @@ template<typename T>
 uint256 SerializeVerusHashV2b(const T& obj, int solutionVersion=SOLUTION_VERUSHHASH_V2, int nType=SER_GETHASH, int nVersion=0)
 {
     CVerusHashV2bWriter ss(nType, nVersion, solutionVersion);
+    VERUS_STAGE_START(timer);
     ss << obj;
+    VERUS_STAGE_END(VERUS_STAGE_WRITE, timer);
     return ss.GetHash();
 }
 
@@ -3,100 +3,218 @@
 #include "verushash.h"
 
 #include <stdint.h>
+#include <algorithm>
 #include <vector>
 #include <csignal>
 #include <sodium.h>
 #include <iostream>
 #include "crypto/verus_hash.h"
+#include "crypto/verus_latency.h"
+#include "crypto/verus_probes.h"
+#include "crypto/verus_thread_pool.h"
 #include "solutiondata.h"
 
 #include <sstream>
+#include <atomic>
+#include <mutex>
 
-bool initialized = false;
+static std::once_flag initializedFlag;
 
-
-void Verushash::initialize() {
-    if (!initialized)
-    {
-        CVerusHash::init();
-        CVerusHashV2::init();
+static void initializeOnce() {
+    // detects the CPU and selects the hash kernels, see crypto/verus_kernels.h
+    CVerusKernels::Init();
+    if (sodium_init() == -1) {
+        // try again
         if (sodium_init() == -1) {
-            // try again
-            if (sodium_init() == -1) {
-                // failed twice, give up
-                // complain first
-                //cout("verushash: unable to load sodium_init(), failed to intialize")
-                raise(SIGINT);
-            }
-       	}
+            // failed twice, give up
+            // complain first
+            //cout("verushash: unable to load sodium_init(), failed to intialize")
+            raise(SIGINT);
+        }
     }
+}
+
+void Verushash::initialize() {
+    std::call_once(initializedFlag, initializeOnce);
     initialized = true;
 }
 
 
-void Verushash::verushash(const char * bytes, int length, void * ptrResult) {
-    if (initialized == false) {
-        initialize();
-    }
-    verus_hash(ptrResult, bytes, length);
+void verushash_v1(const uint8_t *data, size_t len, uint8_t out[32])
+{
+    VERUS_PROBE2(hash_entry, VERUS_COUNTER_HASHES_V1, len);
+    CVerusLatencyTimer latency(VERUS_LATENCY_VERUSHASH, VERUS_COUNTER_HASHES_V1);
+    std::call_once(initializedFlag, initializeOnce);
+    verus_hash(out, data, len);
+    VERUS_PROBE2(hash_return, VERUS_COUNTER_HASHES_V1, len);
 }
 
-void Verushash::verushash_v2(const char * bytes, int length, void * ptrResult) {
-    CVerusHashV2 vh2(SOLUTION_VERUSHHASH_V2);
-    
-    if (initialized == false) {
-        initialize();
-    }
-
-    vh2.Reset();
-    vh2.Write((unsigned char *) bytes, length);
-    vh2.Finalize((unsigned char *) ptrResult);
+void verushash_v2(const uint8_t *data, size_t len, uint8_t out[32])
+{
+    VERUS_PROBE2(hash_entry, VERUS_COUNTER_HASHES_V2, len);
+    CVerusLatencyTimer latency(VERUS_LATENCY_VERUSHASH, VERUS_COUNTER_HASHES_V2);
+    std::call_once(initializedFlag, initializeOnce);
+    verus_hash_v2(out, data, len);
+    VERUS_PROBE2(hash_return, VERUS_COUNTER_HASHES_V2, len);
 }
 
-void Verushash::verushash_v2b(const char * bytes, int length, void * ptrResult) {
+void verushash_v2b(const uint8_t *data, size_t len, uint8_t out[32])
+{
+    VERUS_PROBE2(hash_entry, VERUS_COUNTER_HASHES_V2B, len);
+    CVerusLatencyTimer latency(VERUS_LATENCY_VERUSHASH, VERUS_COUNTER_HASHES_V2B);
     CVerusHashV2 vh2(SOLUTION_VERUSHHASH_V2);
-    
-    if (initialized == false) {
-        initialize();
-    }
+
+    std::call_once(initializedFlag, initializeOnce);
 
     vh2.Reset();
-    vh2.Write((unsigned char *) bytes, length);
-    vh2.Finalize2b((unsigned char *) ptrResult);
+    VERUS_STAGE_START(timer);
+    vh2.Write(data, len);
+    VERUS_STAGE_END(VERUS_STAGE_WRITE, timer);
+    vh2.Finalize2b(out);
+    VERUS_PROBE2(hash_return, VERUS_COUNTER_HASHES_V2B, len);
 }
 
-void Verushash::verushash_v2b1(std::string const bytes, int length, void * ptrResult) {
+void verushash_v2b1(const uint8_t *data, size_t len, uint8_t out[32])
+{
+    VERUS_PROBE2(hash_entry, VERUS_COUNTER_HASHES_V2B1, len);
+    CVerusLatencyTimer latency(VERUS_LATENCY_VERUSHASH, VERUS_COUNTER_HASHES_V2B1);
     CVerusHashV2 vh2b1(SOLUTION_VERUSHHASH_V2_1);
 
-    if (initialized == false) {
-        initialize();
-    }
+    std::call_once(initializedFlag, initializeOnce);
 
     vh2b1.Reset();
-    vh2b1.Write((unsigned char *) &bytes[0], length);
-    vh2b1.Finalize2b((unsigned char *) ptrResult);
+    VERUS_STAGE_START(timer);
+    vh2b1.Write(data, len);
+    VERUS_STAGE_END(VERUS_STAGE_WRITE, timer);
+    vh2b1.Finalize2b(out);
+    VERUS_PROBE2(hash_return, VERUS_COUNTER_HASHES_V2B1, len);
 }
 
-void Verushash::verushash_v2b2(std::string const bytes, void * ptrResult)
+int verushash_v2b2(const uint8_t *data, size_t len, uint8_t out[32])
 {
+    VERUS_PROBE2(hash_entry, VERUS_COUNTER_HASHES_V2B2, len);
+    CVerusLatencyTimer latency(VERUS_LATENCY_VERUSHASH, VERUS_COUNTER_HASHES_V2B2);
     uint256 result;
+    int status = 0;
 
-
-    if (initialized == false) {
-        initialize();
-    }
+    std::call_once(initializedFlag, initializeOnce);
 
     CBlockHeader bh;
-    CDataStream s(bytes.data(), bytes.data() + bytes.size(), SER_GETHASH, 0);
+    CDataStream s((const char *)data, (const char *)data + len, SER_GETHASH, 0);
 
     try
     {
+        VERUS_STAGE_START(timer);
         s >> bh;
+        VERUS_STAGE_END(VERUS_STAGE_DESERIALIZE, timer);
         result = bh.GetVerusV2Hash();
     }
     catch(const std::exception& e)
     {
+        CVerusCounters::Add(VERUS_COUNTER_PARSE_FAILURES);
+        status = -1;
+    }
+
+    memcpy(out, &result, 32);
+    VERUS_PROBE2(hash_return, VERUS_COUNTER_HASHES_V2B2, len);
+    return status;
+}
+
+int verushash_batch(int version, const uint8_t *data, size_t len, const size_t *offsets, size_t count, uint8_t *out, int *status, int threads)
+{
+    // V1 runs fill the lanes of HashBatch, the others are taken a few headers at a time
+    static const size_t V1_GRAIN = 64, GRAIN = 4;
+
+    if (version < VERUS_COUNTER_HASHES_V1 || version > VERUS_COUNTER_HASHES_V2B2)
+    {
+        return -1;
+    }
+    for (size_t i = 0; i < count; i++)
+    {
+        if (offsets[i] > (i + 1 < count ? offsets[i + 1] : len))
+        {
+            return -1;
+        }
     }
 
-    memcpy(ptrResult, &result, 32);
+    std::call_once(initializedFlag, initializeOnce);
+
+    std::atomic<int> failures(0);
+    auto end = [&](size_t i) { return i + 1 < count ? offsets[i + 1] : len; };
+    // nothing may throw out of a C function, the pool only does when it cannot queue the batch
+    try
+    {
+        CVerusThreadPool::ForEach(count, threads, version == VERUS_COUNTER_HASHES_V1 ? V1_GRAIN : GRAIN, [&](size_t begin, size_t stop) {
+            if (version == VERUS_COUNTER_HASHES_V1)
+            {
+                const unsigned char *inputs[V1_GRAIN];
+                size_t lengths[V1_GRAIN];
+                for (size_t i = begin; i < stop; i++)
+                {
+                    inputs[i - begin] = data + offsets[i];
+                    lengths[i - begin] = end(i) - offsets[i];
+                }
+                CVerusHash::HashBatch(out + (begin << 5), inputs, lengths, stop - begin);
+                if (status)
+                {
+                    std::fill(status + begin, status + stop, 0);
+                }
+                return;
+            }
+            for (size_t i = begin; i < stop; i++)
+            {
+                int result = 0;
+                switch (version)
+                {
+                    case VERUS_COUNTER_HASHES_V2:
+                        verushash_v2(data + offsets[i], end(i) - offsets[i], out + (i << 5));
+                        break;
+                    case VERUS_COUNTER_HASHES_V2B:
+                        verushash_v2b(data + offsets[i], end(i) - offsets[i], out + (i << 5));
+                        break;
+                    case VERUS_COUNTER_HASHES_V2B1:
+                        verushash_v2b1(data + offsets[i], end(i) - offsets[i], out + (i << 5));
+                        break;
+                    default:
+                        if ((result = verushash_v2b2(data + offsets[i], end(i) - offsets[i], out + (i << 5))))
+                        {
+                            failures.fetch_add(1, std::memory_order_relaxed);
+                        }
+                        break;
+                }
+                if (status)
+                {
+                    status[i] = result;
+                }
+            }
+        });
+    }
+    catch (...)
+    {
+        return -1;
+    }
+    return failures.load();
+}
+
+// the Verushash methods are the C API for C++ callers
+
+void Verushash::verushash(const char * bytes, int length, void * ptrResult) {
+    verushash_v1((const uint8_t *) bytes, length, (uint8_t *) ptrResult);
+}
+
+void Verushash::verushash_v2(const char * bytes, int length, void * ptrResult) {
+    ::verushash_v2((const uint8_t *) bytes, length, (uint8_t *) ptrResult);
+}
+
+void Verushash::verushash_v2b(const char * bytes, int length, void * ptrResult) {
+    ::verushash_v2b((const uint8_t *) bytes, length, (uint8_t *) ptrResult);
+}
+
+void Verushash::verushash_v2b1(std::string const bytes, int length, void * ptrResult) {
+    ::verushash_v2b1((const uint8_t *) bytes.data(), length, (uint8_t *) ptrResult);
+}
+
+void Verushash::verushash_v2b2(std::string const bytes, void * ptrResult)
+{
+    ::verushash_v2b2((const uint8_t *) bytes.data(), bytes.size(), (uint8_t *) ptrResult);
 }
@@ -7,11 +7,41 @@
 #ifndef _VERUSHASH_H_
 #define _VERUSHASH_H_/* File : veruhash.h */
 
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// The stable C API the Go binding calls. Each hashes len bytes at data into out, initializing
+// the library on first use, and only reads data and writes out for the length of the call.
+void verushash_v1(const uint8_t *data, size_t len, uint8_t out[32]);
+void verushash_v2(const uint8_t *data, size_t len, uint8_t out[32]);
+void verushash_v2b(const uint8_t *data, size_t len, uint8_t out[32]);
+void verushash_v2b1(const uint8_t *data, size_t len, uint8_t out[32]);
+
+// data is a serialized block header, returns 0, or -1 with out zeroed when it does not parse
+int verushash_v2b2(const uint8_t *data, size_t len, uint8_t out[32]);
+
+// hashes count inputs packed in the len bytes at data with version, a VERUS_COUNTER_HASHES_ value,
+// into out + 32 * i. Input i starts at offsets[i] and ends at offsets[i + 1], the last one at len.
+// They are spread over threads threads, the calling one included, 0 for one per hardware thread,
+// of a pool kept for the process, see crypto/verus_thread_pool.h. V1 inputs go through
+// CVerusHash::HashBatch. Unless status is NULL, status[i] is what verushash_v2b2 returns for
+// input i, 0 for the other versions. Returns how many V2b2 headers did not parse, whose hashes
+// are zero, or -1 without hashing for an unknown version or offsets out of order or past len,
+// or when the batch cannot be queued
+int verushash_batch(int version, const uint8_t *data, size_t len, const size_t *offsets, size_t count, uint8_t *out, int *status, int threads);
+
+#ifdef __cplusplus
+} // extern "C"
+
 #include <stdio.h>
 #include <string>
 class Verushash {
 public:
-  bool initialized = false;
+  bool initialized = false;    // set by initialize(), the hash functions don't depend on it
   void initialize();
   void verushash(const char * bytes, int length, void * ptrResult);
   void verushash_v2(const char * bytes, int length, void * ptrResult);
@@ -19,4 +49,6 @@ public:
   void verushash_v2b1(std::string bytes, int length, void * ptrResult);
   void verushash_v2b2(std::string const  bytes, void * ptrResult);
 };
-#endif
\ No newline at end of file
+#endif
+
+#endif
@@ -0,0 +1,256 @@
+package verushash
+
+import (
+	"bytes"
+	"encoding/binary"
+	"errors"
+	"io/ioutil"
+	"os"
+	"runtime"
+	"strconv"
+	"testing"
+	"time"
+)
+
+// The benchmarks hash the headers of a corpus in the verushash_replay format, see
+// verushash/bench/bench_replay.h, testdata/headers.vhrp unless VERUSHASH_CORPUS names another.
+// `verushash_replay gobench` times the same calls on the same corpus in C++ under the same
+// names, so comparing the two shows what the binding costs on its own.
+
+// the header kinds of bench_corpus.h, the entry point each header is hashed with
+const (
+	benchKindV1 = iota
+	benchKindV2
+	benchKindV2B
+	benchKindV2B1
+	benchKindV2B2
+	benchKindV2B2PBaaS
+)
+
+type benchHeader struct {
+	kind     int
+	expected []byte
+	header   []byte
+}
+
+func readBenchCorpus() ([]benchHeader, error) {
+	path := os.Getenv("VERUSHASH_CORPUS")
+	if path == "" {
+		path = "testdata/headers.vhrp"
+	}
+	data, err := ioutil.ReadFile(path)
+	if err != nil {
+		return nil, err
+	}
+	if len(data) < 12 || string(data[:4]) != "VHRP" || binary.LittleEndian.Uint32(data[4:]) != 1 {
+		return nil, errors.New(path + ": not a version 1 header corpus")
+	}
+
+	count := int(binary.LittleEndian.Uint32(data[8:]))
+	headers := make([]benchHeader, 0, count)
+	for pos := 12; len(headers) < count; {
+		if len(data) < pos+41 {
+			return nil, errors.New(path + ": truncated")
+		}
+		kind := int(data[pos+4])
+		expected := data[pos+5 : pos+37]
+		length := int(binary.LittleEndian.Uint32(data[pos+37:]))
+		pos += 41
+		if len(data) < pos+length {
+			return nil, errors.New(path + ": truncated")
+		}
+		headers = append(headers, benchHeader{kind, expected, data[pos : pos+length]})
+		pos += length
+	}
+	return headers, nil
+}
+
+// benchHeaders returns the corpus headers of kinds, checking hash on each
+func benchHeaders(b testing.TB, hash func([]byte) []byte, kinds ...int) [][]byte {
+	corpus, err := readBenchCorpus()
+	if err != nil {
+		b.Fatal(err)
+	}
+	var headers [][]byte
+	for i, h := range corpus {
+		for _, kind := range kinds {
+			if h.kind != kind {
+				continue
+			}
+			if !bytes.Equal(hash(h.header), h.expected) {
+				b.Fatalf("header %d of the corpus hashes differently", i)
+			}
+			headers = append(headers, h.header)
+		}
+	}
+	if len(headers) == 0 {
+		b.Skip("no headers of this kind in the corpus")
+	}
+	return headers
+}
+
+// benchRun times hash on headers one goroutine at a time and on GOMAXPROCS goroutines
+func benchRun(b *testing.B, headers [][]byte, hash func([]byte)) {
+	b.Run("seq", func(b *testing.B) {
+		b.ReportAllocs()
+		b.SetBytes(int64(len(headers[0])))
+		for i := 0; i < b.N; i++ {
+			hash(headers[i%len(headers)])
+		}
+	})
+	b.Run("parallel", func(b *testing.B) {
+		b.ReportAllocs()
+		b.SetBytes(int64(len(headers[0])))
+		b.RunParallel(func(pb *testing.PB) {
+			for i := 0; pb.Next(); i++ {
+				hash(headers[i%len(headers)])
+			}
+		})
+	})
+}
+
+func benchHash(b *testing.B, hash func([]byte) []byte, kinds ...int) {
+	headers := benchHeaders(b, hash, kinds...)
+	benchRun(b, headers, func(header []byte) { hash(header) })
+}
+
+// benchSum is benchHash for a function that returns the hash by value, which fails if a hash
+// allocates
+func benchSum(b *testing.B, sum func([]byte) [32]byte, kinds ...int) {
+	headers := benchHeaders(b, func(header []byte) []byte {
+		hash := sum(header)
+		return hash[:]
+	}, kinds...)
+	if allocs := testing.AllocsPerRun(100, func() { sum(headers[0]) }); allocs != 0 {
+		b.Fatalf("%v allocations per hash", allocs)
+	}
+	benchRun(b, headers, func(header []byte) { sum(header) })
+}
+
+func BenchmarkVerusHash(b *testing.B) {
+	benchHash(b, VerusHash, benchKindV1)
+}
+
+func BenchmarkVerusHash_V2B(b *testing.B) {
+	benchHash(b, VerusHash_V2B, benchKindV2B)
+}
+
+func BenchmarkVerusHash_V2B1(b *testing.B) {
+	benchHash(b, VerusHash_V2B1, benchKindV2B1)
+}
+
+func BenchmarkVerusHash_V2B2(b *testing.B) {
+	benchHash(b, VerusHash_V2B2, benchKindV2B2, benchKindV2B2PBaaS)
+}
+
+func BenchmarkVerusHashSum(b *testing.B) {
+	benchSum(b, VerusHashSum, benchKindV1)
+}
+
+func BenchmarkVerusHashSum_V2B(b *testing.B) {
+	benchSum(b, VerusHashSum_V2B, benchKindV2B)
+}
+
+func BenchmarkVerusHashSum_V2B1(b *testing.B) {
+	benchSum(b, VerusHashSum_V2B1, benchKindV2B1)
+}
+
+func BenchmarkVerusHashSum_V2B2(b *testing.B) {
+	benchSum(b, func(header []byte) [32]byte {
+		hash, _ := VerusHashSum_V2B2(header)
+		return hash
+	}, benchKindV2B2, benchKindV2B2PBaaS)
+}
+
+// BenchmarkVerusHashV2B2Batch hashes batches of 2000 V2b2 headers, as many as a getheaders
+// response, taken in turn from the corpus, as slices and packed in one buffer
+func BenchmarkVerusHashV2B2Batch(b *testing.B) {
+	const batch = 2000
+	corpus := benchHeaders(b, VerusHash_V2B2, benchKindV2B2, benchKindV2B2PBaaS)
+	headers := make([][]byte, batch)
+	var packed []byte
+	offsets := make([]int, batch)
+	for i := range headers {
+		headers[i] = corpus[i%len(corpus)]
+		offsets[i] = len(packed)
+		packed = append(packed, headers[i]...)
+	}
+	out := make([][32]byte, batch)
+
+	run := func(b *testing.B, hash func() int) {
+		if failed := hash(); failed != 0 {
+			b.Fatalf("%d headers did not parse", failed)
+		}
+		for i := range headers {
+			if !bytes.Equal(out[i][:], VerusHash_V2B2(headers[i])) {
+				b.Fatalf("header %d of the batch hashes differently", i)
+			}
+		}
+		b.ReportAllocs()
+		b.SetBytes(int64(len(packed)))
+		b.ResetTimer()
+		start := time.Now()
+		for i := 0; i < b.N; i++ {
+			hash()
+		}
+		b.ReportMetric(float64(time.Since(start).Nanoseconds())/float64(b.N*batch), "ns/header")
+	}
+	b.Run("slices", func(b *testing.B) {
+		run(b, func() int { return VerusHashV2B2Batch(headers, out) })
+	})
+	b.Run("packed", func(b *testing.B) {
+		run(b, func() int { return VerusHashV2B2Packed(packed, offsets, out) })
+	})
+}
+
+// BenchmarkHasherV2B2 compares V2b2 hashing from GOMAXPROCS goroutines, each calling the library
+// itself, with the same goroutines sending their headers to a Hasher, for several GOMAXPROCS. The
+// keys/op metric is the CLHash keys allocated per hash, which the naive calls leave to however
+// the runtime moves goroutines between threads
+func BenchmarkHasherV2B2(b *testing.B) {
+	headers := benchHeaders(b, VerusHash_V2B2, benchKindV2B2, benchKindV2B2PBaaS)
+	procs := runtime.GOMAXPROCS(0)
+	defer runtime.GOMAXPROCS(procs)
+
+	run := func(b *testing.B, hash func([]byte) ([32]byte, bool)) {
+		b.ReportAllocs()
+		b.SetBytes(int64(len(headers[0])))
+		keys := ReadCounters().KeyAllocations
+		b.RunParallel(func(pb *testing.PB) {
+			for i := 0; pb.Next(); i++ {
+				if _, ok := hash(headers[i%len(headers)]); !ok {
+					b.Error("a corpus header did not parse")
+					return
+				}
+			}
+		})
+		b.ReportMetric(float64(ReadCounters().KeyAllocations-keys)/float64(b.N), "keys/op")
+	}
+	for _, p := range []int{1, 2, 4, 8, 16} {
+		runtime.GOMAXPROCS(p)
+		b.Run("naive/procs="+strconv.Itoa(p), func(b *testing.B) {
+			run(b, VerusHashSum_V2B2)
+		})
+		b.Run("pool/procs="+strconv.Itoa(p), func(b *testing.B) {
+			h := NewHasher(0, 0)
+			defer h.Close()
+			run(b, h.HashV2B2)
+		})
+	}
+}
+
+func BenchmarkReadCounters(b *testing.B) {
+	b.ReportAllocs()
+	for i := 0; i < b.N; i++ {
+		ReadCounters()
+	}
+}
+
+func BenchmarkWritePrometheus(b *testing.B) {
+	b.ReportAllocs()
+	for i := 0; i < b.N; i++ {
+		if err := WritePrometheus(ioutil.Discard); err != nil {
+			b.Fatal(err)
+		}
+	}
+}
@@ -0,0 +1,182 @@
+package verushash
+
+import (
+	"bytes"
+	"runtime"
+	"sync"
+	"testing"
+
+	"github.com/asherda/go-verushash/verushash"
+)
+
+// The tests check every entry point against the expected hashes of the benchmark corpus, see
+// verushash_bench_test.go, and the batch and Hasher entry points against the single calls.
+
+// a header that does not parse, the start of a V2b2 header cut off inside its solution
+func truncatedHeader(t *testing.T) []byte {
+	headers := benchHeaders(t, VerusHash_V2B2, benchKindV2B2)
+	return headers[0][:len(headers[0])/2]
+}
+
+func TestVerusHash(t *testing.T) {
+	corpus, err := readBenchCorpus()
+	if err != nil {
+		t.Fatal(err)
+	}
+	sum := func(hash [32]byte) []byte { return hash[:] }
+	for i, h := range corpus {
+		var hashes [][]byte
+		switch h.kind {
+		case benchKindV1:
+			hashes = [][]byte{VerusHash(h.header), sum(VerusHashSum(h.header))}
+		case benchKindV2:
+			hashes = [][]byte{sum(VH.HashV2(h.header))}
+		case benchKindV2B:
+			hashes = [][]byte{VerusHash_V2B(h.header), sum(VerusHashSum_V2B(h.header))}
+		case benchKindV2B1:
+			hashes = [][]byte{VerusHash_V2B1(h.header), sum(VerusHashSum_V2B1(h.header))}
+		case benchKindV2B2, benchKindV2B2PBaaS:
+			hash, ok := VerusHashSum_V2B2(h.header)
+			if !ok {
+				t.Fatalf("header %d of the corpus did not parse", i)
+			}
+			hashes = [][]byte{VerusHash_V2B2(h.header), hash[:]}
+		default:
+			t.Fatalf("header %d of the corpus is of unknown kind %d", i, h.kind)
+		}
+		for _, hash := range hashes {
+			if !bytes.Equal(hash, h.expected) {
+				t.Fatalf("header %d of the corpus, of kind %d, hashes to %x, not %x", i, h.kind, hash, h.expected)
+			}
+		}
+	}
+}
+
+func TestVerusHashV2B2ParseFailure(t *testing.T) {
+	header := truncatedHeader(t)
+	failures := ReadCounters().ParseFailures
+	if hash, ok := VerusHashSum_V2B2(header); ok || hash != [32]byte{} {
+		t.Fatalf("truncated header: %x, %v, want a zero hash and false", hash, ok)
+	}
+	if hash := VerusHash_V2B2(header); !bytes.Equal(hash, make([]byte, 32)) {
+		t.Fatalf("truncated header: %x, want a zero hash", hash)
+	}
+	if n := ReadCounters().ParseFailures - failures; n != 2 {
+		t.Fatalf("%d parse failures counted, want 2", n)
+	}
+}
+
+// a thread hashing again after ReleaseIdleKeys freed its key must generate a new one, whatever
+// the seed, such as the zero one of a V2b input under 32 bytes
+func TestReleaseIdleKeys(t *testing.T) {
+	header := benchHeaders(t, VerusHash_V2B2, benchKindV2B2)[0]
+	short := []byte("sixteen bytes...")
+	runtime.LockOSThread()
+	defer runtime.UnlockOSThread()
+
+	// the short inputs first, so the first hash after the release is on the new key
+	hash := func() (hashes [3][32]byte) {
+		hashes[0] = VerusHashSum_V2B(short)
+		hashes[1] = VerusHashSum_V2B1(short)
+		hashes[2], _ = VerusHashSum_V2B2(header)
+		return hashes
+	}
+	before := hash()
+	releases := ReadCounters().KeyReleases
+	if n := ReleaseIdleKeys(0); n < 1 {
+		t.Fatalf("%d keys released, want at least this thread's", n)
+	}
+	if n := ReadCounters().KeyReleases - releases; n < 1 {
+		t.Fatalf("%d key releases counted", n)
+	}
+	if after := hash(); after != before {
+		t.Fatalf("hashes after the key release %x, before it %x", after, before)
+	}
+	if again := hash(); again != before {
+		t.Fatalf("hashes on the new key %x, before the key release %x", again, before)
+	}
+}
+
+func TestVerusHashV2B2Batch(t *testing.T) {
+	headers := benchHeaders(t, VerusHash_V2B2, benchKindV2B2, benchKindV2B2PBaaS)
+	bad := len(headers) / 2
+	headers = append(headers[:bad:bad], append([][]byte{truncatedHeader(t)}, headers[bad:]...)...)
+	var packed []byte
+	offsets := make([]int, len(headers))
+	for i, header := range headers {
+		offsets[i] = len(packed)
+		packed = append(packed, header...)
+	}
+
+	check := func(name string, hash func(out [][32]byte) int) {
+		out := make([][32]byte, len(headers))
+		for i := range out {
+			out[i][0] = 1
+		}
+		if failed := hash(out); failed != 1 {
+			t.Fatalf("%s: %d headers did not parse, want 1", name, failed)
+		}
+		for i, header := range headers {
+			if want, _ := VerusHashSum_V2B2(header); out[i] != want {
+				t.Fatalf("%s: header %d hashes to %x, not %x", name, i, out[i], want)
+			}
+		}
+	}
+	check("slices", func(out [][32]byte) int { return VerusHashV2B2Batch(headers, out) })
+	check("packed", func(out [][32]byte) int { return VerusHashV2B2Packed(packed, offsets, out) })
+	for _, threads := range []int{1, 3, 0} {
+		status := make([]int32, len(headers))
+		check("status", func(out [][32]byte) int {
+			return VH.Batch(VH.VersionV2B2, packed, offsets, out, status, threads)
+		})
+		for i, s := range status {
+			if (s != 0) != (i == bad) {
+				t.Fatalf("%d threads: status %d of header %d", threads, s, i)
+			}
+		}
+	}
+
+	out := make([][32]byte, 2)
+	if failed := VH.Batch(VH.VersionV2B2, packed, []int{0, len(packed) + 1}, out, nil, 1); failed != -1 {
+		t.Fatalf("offset past the end: %d, want -1", failed)
+	}
+	if failed := VH.Batch(VH.VersionV2B2, packed, []int{offsets[1], offsets[0]}, out, nil, 1); failed != -1 {
+		t.Fatalf("offsets out of order: %d, want -1", failed)
+	}
+	defer func() {
+		if recover() == nil {
+			t.Fatal("VerusHashV2B2Packed did not panic on offsets out of order")
+		}
+	}()
+	VerusHashV2B2Packed(packed, []int{offsets[1], offsets[0]}, out)
+}
+
+func TestHasher(t *testing.T) {
+	headers := append(benchHeaders(t, VerusHash_V2B2, benchKindV2B2, benchKindV2B2PBaaS), truncatedHeader(t))
+	h := NewHasher(2, 4)
+	defer h.Close()
+
+	// enough goroutines that requests queue up and the workers take them in batches
+	var wg sync.WaitGroup
+	errs := make(chan string, 16)
+	for g := 0; g < 16; g++ {
+		wg.Add(1)
+		go func(g int) {
+			defer wg.Done()
+			for i := g; i < g+4*len(headers); i++ {
+				header := headers[i%len(headers)]
+				hash, ok := h.HashV2B2(header)
+				want, wantOk := VerusHashSum_V2B2(header)
+				if hash != want || ok != wantOk {
+					errs <- "a header hashes differently through the Hasher"
+					return
+				}
+			}
+		}(g)
+	}
+	wg.Wait()
+	close(errs)
+	for err := range errs {
+		t.Fatal(err)
+	}
+}